@@ -70,6 +70,8 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-nopbo",      noPBOOption,   PHASE_BEFORE_SETTINGS, 1);
 	#endif
 	registerOption("-testconfig", testConfigOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-batch",      batchOption,   PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-batchjobs",  batchJobsOption, PHASE_BEFORE_SETTINGS);
 
 	registerOption("-machine",    machineOption, PHASE_LOAD_MACHINE);
 
@@ -278,7 +280,13 @@ void CommandLineParser::parse(int argc, char** argv)
 
 bool CommandLineParser::isHiddenStartup() const
 {
-	return (parseStatus == CONTROL) || (parseStatus == TEST);
+	return (parseStatus == CONTROL) || (parseStatus == TEST) ||
+	       (parseStatus == BATCH);
+}
+
+const std::vector<std::string>& CommandLineParser::getBatchReplays() const
+{
+	return replayCLI.getBatchReplays();
 }
 
 CommandLineParser::ParseStatus CommandLineParser::getParseStatus() const
@@ -575,6 +583,37 @@ string_view CommandLineParser::TestConfigOption::optionHelp() const
 	return "Test if the specified config works and exit";
 }
 
+// class BatchOption
+
+void CommandLineParser::BatchOption::parseOption(
+	const string& /*option*/, array_ref<string>& /*cmdLine*/)
+{
+	auto& parser = OUTER(CommandLineParser, batchOption);
+	parser.parseStatus = CommandLineParser::BATCH;
+}
+
+string_view CommandLineParser::BatchOption::optionHelp() const
+{
+	return "Run the given replays (headless and unthrottled) to their "
+	       "end, print a hash of the final machine state and exit";
+}
+
+// class BatchJobsOption
+
+void CommandLineParser::BatchJobsOption::parseOption(
+	const string& option, array_ref<string>& cmdLine)
+{
+	const auto& arg = getArgument(option, cmdLine);
+	if (!StringOp::stringToUint(arg, jobs) || (jobs < 1) || (jobs > 256)) {
+		throw FatalError("Invalid number of batch jobs: ", arg);
+	}
+}
+
+string_view CommandLineParser::BatchJobsOption::optionHelp() const
+{
+	return "Number of replays to run in parallel in batch mode";
+}
+
 // class BashOption
 
 void CommandLineParser::BashOption::parseOption(
@@ -31,7 +31,7 @@ class Interpreter;
 class CommandLineParser
 {
 public:
-	enum ParseStatus { UNPARSED, RUN, CONTROL, TEST, EXIT };
+	enum ParseStatus { UNPARSED, RUN, CONTROL, TEST, BATCH, EXIT };
 	enum ParsePhase {
 		PHASE_BEFORE_INIT,       // --help, --version, -bash
 		PHASE_INIT,              // calls Reactor::init()
@@ -61,6 +61,14 @@ public:
 	  */
 	bool isHiddenStartup() const;
 
+	/** Replays to run in batch mode (see '-batch' option).
+	  */
+	const std::vector<std::string>& getBatchReplays() const;
+
+	/** Number of replays to run in parallel in batch mode.
+	  */
+	unsigned getBatchJobs() const { return batchJobsOption.jobs; }
+
 private:
 	struct OptionData {
 		CLIOption* option;
@@ -126,6 +134,18 @@ private:
 		string_view optionHelp() const override;
 	} testConfigOption;
 
+	struct BatchOption final : CLIOption {
+		void parseOption(const std::string& option, array_ref<std::string>& cmdLine) override;
+		string_view optionHelp() const override;
+	} batchOption;
+
+	struct BatchJobsOption final : CLIOption {
+		BatchJobsOption() : jobs(1) {}
+		void parseOption(const std::string& option, array_ref<std::string>& cmdLine) override;
+		string_view optionHelp() const override;
+		unsigned jobs;
+	} batchJobsOption;
+
 	struct BashOption final : CLIOption {
 		void parseOption(const std::string& option, array_ref<std::string>& cmdLine) override;
 		string_view optionHelp() const override;
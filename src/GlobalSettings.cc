@@ -43,6 +43,12 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 			{"hq",   ResampledSoundDevice::RESAMPLE_HQ},
 			{"fast", ResampledSoundDevice::RESAMPLE_LQ},
 			{"blip", ResampledSoundDevice::RESAMPLE_BLIP}})
+	, reverseMemoryLimitSetting(commandController, "reverse_memory_limit",
+		"maximum amount of memory (in MB) used by the reverse history "
+		"of each machine, 0 means unlimited", 0, 0, 1024 * 1024)
+	, backgroundMachinesSetting(commandController, "background_machines",
+		"advance the non-active machines at full speed, each in its own "
+		"thread", false)
 	, throttleManager(commandController)
 {
 	for (auto i : xrange(SDL_NumJoysticks())) {
@@ -3,6 +3,7 @@
 #include "ReadOnlySetting.hh"
 #include "CommandController.hh"
 #include "Timer.hh"
+#include "Thread.hh"
 #include "memory.hh"
 
 namespace openmsx {
@@ -45,12 +46,18 @@ void LedStatus::setLed(Led led, bool status)
 	// the LEDs as a VU meter while playing samples). Without throttling
 	// all these events overload the host CPU. That's why we limit it to
 	// 100 events per second.
+	// Events can only be handled in the main thread. When the machine is
+	// emulated in another thread, always handle it (a bit) later.
 	auto now = Timer::getTime();
 	auto diff = now - lastTime;
 	if (diff > 10000) { // 1/100 s
-		// handle now
-		lastTime = now;
-		handleEvent(led);
+		if (Thread::isMainThread()) {
+			// handle now
+			lastTime = now;
+			handleEvent(led);
+		} else if (!isPendingRT()) {
+			scheduleRT(0);
+		}
 	} else {
 		// schedule to handle it later, if we didn't plan to do so already
 		if (!isPendingRT()) {
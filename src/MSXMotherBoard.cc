@@ -41,6 +41,7 @@
 #include "serialize.hh"
 #include "serialize_stl.hh"
 #include "ScopedAssign.hh"
+#include "Thread.hh"
 #include "memory.hh"
 #include "stl.hh"
 #include "unreachable.hh"
@@ -193,6 +194,7 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	, powered(false)
 	, active(false)
 	, fastForwarding(false)
+	, background(false)
 {
 	slotManager = make_unique<CartridgeSlotManager>(*this);
 	reverseManager = make_unique<ReverseManager>(*this);
@@ -518,6 +520,36 @@ void MSXMotherBoard::fastForward(EmuTime::param time, bool fast)
 	msxMixer->unmute();
 }
 
+void MSXMotherBoard::setBackground(bool background_)
+{
+	assert(Thread::isMainThread());
+	if (background == background_) return;
+	background = background_;
+	if (background) {
+		realTime->disable();
+		msxMixer->mute();
+		msxMixer->setSeekMode(true);
+	} else {
+		msxMixer->setSeekMode(false);
+		msxMixer->unmute();
+		realTime->enable();
+	}
+}
+
+bool MSXMotherBoard::executeBackground()
+{
+	assert(background);
+	if (!powered) {
+		return false;
+	}
+	assert(getMachineConfig());
+
+	// Fast-forward mode: breakpoints are ignored (the global break/step
+	// state belongs to the active machine) and nothing is rendered.
+	getCPU().execute(true);
+	return true;
+}
+
 void MSXMotherBoard::pause()
 {
 	if (getMachineConfig()) {
@@ -79,6 +79,21 @@ public:
 	 */
 	void fastForward(EmuTime::param time, bool fast);
 
+	/** Put this (non-active) machine in or out of background mode. In
+	  * background mode the machine doesn't synchronize with real time
+	  * and doesn't produce sound. Must be called from the main thread.
+	  */
+	void setBackground(bool background);
+	bool isBackground() const { return background; }
+
+	/** Run emulation of a machine in background mode, see
+	  * Reactor::startBackgroundBoards(). This may be called from a
+	  * non-main thread, returns on the next exitCPULoopAsync() call.
+	  * @return True if emulation steps were done,
+	  *   false if emulation is suspended.
+	  */
+	bool executeBackground();
+
 	/** See CPU::exitCPULoopAsync(). */
 	void exitCPULoopAsync();
 	void exitCPULoopSync();
@@ -271,6 +286,7 @@ private:
 	bool powered;
 	bool active;
 	bool fastForwarding;
+	bool background;
 };
 SERIALIZE_CLASS_VERSION(MSXMotherBoard, 4);
 
@@ -17,6 +17,7 @@ struct EqualRTSchedulable {
 
 void RTScheduler::add(uint64_t delta, RTSchedulable& schedulable)
 {
+	auto lock = getLock();
 	queue.insert(RTSyncPoint{Timer::getTime() + delta, &schedulable},
 	             [](RTSyncPoint& sp) {
                              sp.time = std::numeric_limits<uint64_t>::max(); },
@@ -26,16 +27,18 @@ void RTScheduler::add(uint64_t delta, RTSchedulable& schedulable)
 
 bool RTScheduler::remove(RTSchedulable& schedulable)
 {
+	auto lock = getLock();
 	return queue.remove(EqualRTSchedulable(schedulable));
 }
 
 bool RTScheduler::isPending(const RTSchedulable& schedulable) const
 {
+	auto lock = getLock();
 	return std::find_if(std::begin(queue), std::end(queue),
 	                    EqualRTSchedulable(schedulable)) != std::end(queue);
 }
 
-void RTScheduler::scheduleHelper(uint64_t limit)
+void RTScheduler::scheduleHelper(uint64_t limit, std::unique_lock<std::mutex>& lock)
 {
 	// Process at most this many events to prevent getting stuck in an
 	// infinite loop when a RTSchedulable keeps on rescheduling itself in
@@ -45,7 +48,10 @@ void RTScheduler::scheduleHelper(uint64_t limit)
 		auto* schedulable = queue.front().schedulable;
 		queue.remove_front();
 
+		// executeRT() may (un)schedule RTSchedulables
+		if (lock) lock.unlock();
 		schedulable->executeRT();
+		lock = getLock();
 
 		// It's possible RTSchedulables are canceled in the mean time,
 		// so we can't rely on 'count' to replace this empty check.
@@ -5,6 +5,7 @@
 #include "Timer.hh"
 #include "likely.hh"
 #include <cstdint>
+#include <mutex>
 
 namespace openmsx {
 
@@ -16,6 +17,10 @@ struct RTSyncPoint
 	RTSchedulable* schedulable;
 };
 
+/** RTSchedulables are always executed in the main thread. But in
+  * multi-threaded mode (when emulating non-active machines in other threads,
+  * see ReplayBatch) they can be (un)scheduled from any thread.
+  */
 class RTScheduler
 {
 public:
@@ -23,11 +28,18 @@ public:
 	inline void execute()
 	{
 		auto limit = Timer::getTime();
+		auto lock = getLock();
 		if (!queue.empty() && unlikely(limit >= queue.front().time)) {
-			scheduleHelper(limit); // slow path not inlined
+			scheduleHelper(limit, lock); // slow path not inlined
 		}
 	}
 
+	/** Enable/disable the locking that's needed to (un)schedule from
+	  * other threads. May only be changed from the main thread, while
+	  * no other thread uses this RTScheduler.
+	  */
+	void setMultiThreaded(bool multiThreaded_) { multiThreaded = multiThreaded_; }
+
 private:
 	// These are called by RTSchedulable
 	friend class RTSchedulable;
@@ -36,9 +48,17 @@ private:
 	bool isPending(const RTSchedulable& schedulable) const;
 
 private:
-	void scheduleHelper(uint64_t limit);
+	// Only actually locked in multi-threaded mode.
+	std::unique_lock<std::mutex> getLock() const
+	{
+		return multiThreaded ? std::unique_lock<std::mutex>(mutex)
+		                     : std::unique_lock<std::mutex>();
+	}
+	void scheduleHelper(uint64_t limit, std::unique_lock<std::mutex>& lock);
 
 	SchedulerQueue<RTSyncPoint> queue;
+	mutable std::mutex mutex; // protects 'queue' in multi-threaded mode
+	bool multiThreaded = false;
 };
 
 } // namespace openmsx
@@ -3,6 +3,7 @@
 #include "RTScheduler.hh"
 #include "EventDistributor.hh"
 #include "GlobalCommandController.hh"
+#include "Interpreter.hh"
 #include "InputEventGenerator.hh"
 #include "InputEvents.hh"
 #include "DiskFactory.hh"
@@ -35,6 +36,10 @@
 #include "FileOperations.hh"
 #include "ReadDir.hh"
 #include "Thread.hh"
+#include "ThreadPool.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMixer.hh"
+#include "ReverseManager.hh"
 #include "Timer.hh"
 #include "serialize.hh"
 #include "openmsx.hh"
@@ -52,6 +57,10 @@ using std::make_shared;
 
 namespace openmsx {
 
+// Upper limit for the number of machines that run concurrently in the
+// background, see startBackgroundBoards().
+const unsigned MAX_BACKGROUND_THREADS = 256;
+
 class QuitCommand final : public Command
 {
 public:
@@ -174,6 +183,7 @@ private:
 
 Reactor::Reactor()
 	: activeBoard(nullptr)
+	, stopBackground(false)
 	, blockedCounter(0)
 	, paused(false)
 	, running(true)
@@ -191,10 +201,17 @@ void Reactor::init()
 	globalCliComm = make_unique<GlobalCliComm>();
 	globalCommandController = make_unique<GlobalCommandController>(
 		*eventDistributor, *globalCliComm, *this);
+	// Tcl code may access any machine. Only the main thread can stop the
+	// background boards, in other threads Tcl may not be used at all (see
+	// TclCallback::executeDeferred()).
+	Interpreter::setAccessCallback([this] {
+		if (Thread::isMainThread()) stopBackgroundBoards();
+	});
 	globalSettings = make_unique<GlobalSettings>(
 		*globalCommandController);
 	inputEventGenerator = make_unique<InputEventGenerator>(
 		*globalCommandController, *eventDistributor, *globalSettings);
+	threadPool = make_unique<ThreadPool>();
 	mixer = make_unique<Mixer>(
 		*this, *globalCommandController);
 	diskFactory = make_unique<DiskFactory>(
@@ -251,6 +268,8 @@ void Reactor::init()
 Reactor::~Reactor()
 {
 	if (!isInit) return;
+	stopBackgroundBoards();
+	Interpreter::setAccessCallback(nullptr);
 	deleteBoard(activeBoard);
 
 	eventDistributor->unregisterEventListener(OPENMSX_QUIT_EVENT, *this);
@@ -533,8 +552,14 @@ void Reactor::run(CommandLineParser& parser)
 	}
 
 	while (running) {
+		// stops the background boards when needed
 		eventDistributor->deliverEvents();
 		assert(garbageBoards.empty());
+		if (blockedCounter == 0) {
+			startBackgroundBoards();
+		} else {
+			stopBackgroundBoards();
+		}
 		bool blocked = (blockedCounter > 0) || !activeBoard;
 		if (!blocked) blocked = !activeBoard->execute();
 		if (blocked) {
@@ -547,6 +572,63 @@ void Reactor::run(CommandLineParser& parser)
 			eventDistributor->sleep(20 * 1000);
 		}
 	}
+	stopBackgroundBoards();
+}
+
+void Reactor::startBackgroundBoards()
+{
+	// Everything that determines which boards run in the background (the
+	// setting, the active board, breakpoints, ...) can only change via
+	// events or Tcl, and those first stop the background boards. So while
+	// they're running there's nothing to do.
+	if (!backgroundTasks.empty()) return;
+	// Breakpoints and conditions are global and are checked via Tcl, so
+	// then only the active machine (in the main thread) may run.
+	bool enabled = globalSettings->getBackgroundMachinesSetting().getBoolean() &&
+	               !MSXCPUInterface::anyBreakPoints();
+	for (auto& b : boards) {
+		MSXMotherBoard* board = b.get();
+		bool background = enabled && (board != activeBoard) &&
+			board->getCPUInterface().getWatchPoints().empty() &&
+			!board->getReverseManager().replayNeedsMainThread();
+		board->setBackground(background);
+		if (!background) continue;
+
+		if (!backgroundPool) {
+			backgroundPool = make_unique<ThreadPool>(MAX_BACKGROUND_THREADS);
+		}
+		// background boards (un)schedule RTSchedulables
+		rtScheduler->setMultiThreaded(true);
+		backgroundTasks.emplace_back(board, backgroundPool->addTask([this, board] {
+			Thread::setEmulationThread(true);
+			while (!stopBackground && board->executeBackground()) {
+				// loop until stopBackgroundBoards() or power off
+			}
+			Thread::setEmulationThread(false);
+		}));
+	}
+}
+
+void Reactor::stopBackgroundBoards()
+{
+	assert(Thread::isMainThread());
+	if (backgroundTasks.empty()) return;
+	auto tasks = std::move(backgroundTasks);
+	backgroundTasks.clear();
+
+	stopBackground = true;
+	for (auto& t : tasks) {
+		t.first->exitCPULoopAsync();
+	}
+	for (auto& t : tasks) {
+		t.second.wait();
+	}
+	stopBackground = false;
+	rtScheduler->setMultiThreaded(false);
+
+	for (auto& t : tasks) {
+		t.second.get(); // rethrows exceptions from the worker threads
+	}
 }
 
 void Reactor::unpause()
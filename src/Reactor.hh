@@ -5,9 +5,12 @@
 #include "EventListener.hh"
 #include "string_view.hh"
 #include "openmsx.hh"
+#include <atomic>
+#include <future>
 #include <string>
 #include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 #include <iostream>
@@ -50,6 +53,7 @@ class RestoreMachineCommand;
 class AviRecorder;
 class ConfigInfo;
 class RealTimeInfo;
+class ThreadPool;
 template <typename T> class EnumSetting;
 
 /**
@@ -86,6 +90,12 @@ public:
 	EnumSetting<int>& getMachineSetting() { return *machineSetting; }
 	FilePool& getFilePool() { return *filePool; }
 
+	/** Shared pool (one thread per hardware thread) for short tasks,
+	  * e.g. scaling an image in bands or calculating the deltas of
+	  * reverse snapshots. Don't add long running tasks.
+	  */
+	ThreadPool& getThreadPool() { return *threadPool; }
+
 	RomDatabase& getSoftwareDatabase();
 
 	void switchMachine(const std::string& machine);
@@ -108,6 +118,14 @@ public:
 	Board createEmptyMotherBoard();
 	void replaceBoard(MSXMotherBoard& oldBoard, Board newBoard); // for reverse
 
+	/** Wait till all machines that run in a background thread are
+	  * stopped (see startBackgroundBoards()). This is done before events
+	  * are delivered and before Tcl executes an openMSX command or
+	  * accesses a setting. So event handlers and Tcl code never run
+	  * concurrently with a background machine. Main thread only.
+	  */
+	void stopBackgroundBoards();
+
 private:
 	using Boards = std::vector<Board>;
 
@@ -126,6 +144,12 @@ private:
 	void unpause();
 	void pause();
 
+	/** Advance the non-active machines concurrently, each in its own
+	  * worker thread (only when the 'background_machines' setting is
+	  * enabled). The main loop (re)starts them when they aren't running.
+	  */
+	void startBackgroundBoards();
+
 	std::mutex mbMutex; // this should come first, because it's still used by
 	                    // the destructors of the unique_ptr below
 
@@ -136,6 +160,7 @@ private:
 	std::unique_ptr<GlobalCommandController> globalCommandController;
 	std::unique_ptr<GlobalSettings> globalSettings;
 	std::unique_ptr<InputEventGenerator> inputEventGenerator;
+	std::unique_ptr<ThreadPool> threadPool;
 #if UNIQUE_PTR_BUG // see openmsx.hh
 	std::unique_ptr<Display> display2;
 	Display* display;
@@ -180,6 +205,12 @@ private:
 	Boards garbageBoards;
 	MSXMotherBoard* activeBoard; // either nullptr or a board inside 'boards'
 
+	// Machines that are currently running in a worker thread. The main
+	// thread may not touch these machines until stopBackgroundBoards().
+	std::vector<std::pair<MSXMotherBoard*, std::shared_future<void>>> backgroundTasks;
+	std::unique_ptr<ThreadPool> backgroundPool; // created on first use
+	std::atomic<bool> stopBackground;
+
 	int blockedCounter;
 	bool paused;
 
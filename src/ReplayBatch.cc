@@ -0,0 +1,156 @@
+#include "ReplayBatch.hh"
+#include "Reactor.hh"
+#include "ReverseManager.hh"
+#include "MSXMotherBoard.hh"
+#include "MSXMixer.hh"
+#include "Debugger.hh"
+#include "EventDistributor.hh"
+#include "RTScheduler.hh"
+#include "Setting.hh"
+#include "MSXException.hh"
+#include "ThreadPool.hh"
+#include "Thread.hh"
+#include "sha1.hh"
+#include "memory.hh"
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iostream>
+
+using std::string;
+
+namespace openmsx {
+
+struct BatchJob
+{
+	explicit BatchJob(const string& filename_)
+		: filename(filename_), endTime(EmuTime::zero) {}
+
+	string filename;
+	std::unique_ptr<MSXMotherBoard> board;
+	EmuTime endTime;
+	std::shared_future<void> done; // only valid for threaded jobs
+	Sha1Sum hash;
+	string error;
+};
+
+// Can run in the main thread or in an emulation thread.
+static void emulate(BatchJob& job)
+{
+	job.board->fastForward(job.endTime, true);
+	job.hash = job.board->getDebugger().calcStateHash();
+}
+
+// Store any error (not only MSXExceptions) in the job.
+template<typename F> static void catchErrors(BatchJob& job, F f)
+{
+	try {
+		f();
+	} catch (MSXException& e) {
+		job.error = e.getMessage();
+	} catch (std::exception& e) {
+		job.error = e.what();
+	} catch (...) {
+		job.error = "unknown error";
+	}
+}
+
+// While jobs run in other threads, the RTScheduler needs locking and the
+// (shared) settings may not change. Restore the normal state on exit.
+struct ParallelMode
+{
+	ParallelMode(RTScheduler& rtScheduler_, bool parallel)
+		: rtScheduler(rtScheduler_)
+	{
+		rtScheduler.setMultiThreaded(parallel);
+	}
+	~ParallelMode()
+	{
+		BaseSetting::setFrozen(false);
+		rtScheduler.setMultiThreaded(false);
+	}
+	RTScheduler& rtScheduler;
+};
+
+ReplayBatch::ReplayBatch(Reactor& reactor_)
+	: reactor(reactor_)
+{
+}
+
+int ReplayBatch::run(const std::vector<string>& replays, unsigned jobs)
+{
+	auto& eventDistributor = reactor.getEventDistributor();
+	ParallelMode parallelMode(reactor.getRTScheduler(), jobs > 1);
+	std::deque<std::unique_ptr<BatchJob>> inFlight;
+	ThreadPool pool(jobs); // destroyed (threads joined) before 'inFlight'
+
+	// keep on handling (deferred) messages while waiting
+	auto wait = [&](BatchJob& job) {
+		if (!job.done.valid()) return;
+		while (job.done.wait_for(std::chrono::milliseconds(20)) !=
+		       std::future_status::ready) {
+			eventDistributor.deliverEvents();
+		}
+	};
+
+	auto next = begin(replays);
+	int result = 0;
+	while ((next != end(replays)) || !inFlight.empty()) {
+		// load new machines (only in the main thread)
+		while ((inFlight.size() < jobs) && (next != end(replays))) {
+			auto job = make_unique<BatchJob>(*next++);
+			auto* j = job.get();
+			catchErrors(*j, [&] {
+				bool needsMainThread;
+				j->board = ReverseManager::loadReplayMachine(
+					reactor, j->filename, j->endTime,
+					needsMainThread);
+				auto& mixer = j->board->getMSXMixer();
+				mixer.mute();
+				mixer.setSeekMode(true);
+				if (needsMainThread || (jobs == 1)) {
+					// The recorded commands may change settings,
+					// so first wait till no other thread uses them.
+					for (auto& other : inFlight) wait(*other);
+					BaseSetting::setFrozen(false);
+					emulate(*j);
+				} else {
+					BaseSetting::setFrozen(true);
+					j->done = pool.addTask([j] {
+						Thread::setEmulationThread(true);
+						try {
+							emulate(*j);
+						} catch (...) {
+							Thread::setEmulationThread(false);
+							throw; // reported via 'done'
+						}
+						Thread::setEmulationThread(false);
+					});
+				}
+			});
+			inFlight.push_back(std::move(job));
+		}
+
+		// report oldest job
+		auto& job = *inFlight.front();
+		wait(job);
+		if (job.done.valid()) {
+			catchErrors(job, [&] { job.done.get(); });
+		}
+		// also executes the Tcl callbacks this job deferred, before
+		// its machine gets deleted
+		eventDistributor.deliverEvents();
+		if (job.error.empty()) {
+			std::cout << job.hash.toString() << "  " << job.filename
+			          << std::endl;
+		} else {
+			std::cerr << job.filename << ": " << job.error << std::endl;
+			result = 1;
+		}
+		inFlight.pop_front(); // deletes machine, in the main thread
+	}
+	return result;
+}
+
+} // namespace openmsx
@@ -0,0 +1,46 @@
+#ifndef REPLAYBATCH_HH
+#define REPLAYBATCH_HH
+
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Reactor;
+
+/** Runs replays without any interaction (started with the '-batch' command
+  * line option). Each replay is run as fast as possible (no sound, no video)
+  * till the end, then a hash of the final machine state is printed. This is
+  * meant for regression testing.
+  *
+  * Multiple replays can run in parallel, each in its own thread. Loading and
+  * deleting machines is always done in the main thread. Replays that contain
+  * recorded commands are run in the main thread as well (those commands are
+  * executed via Tcl). Tcl callbacks (e.g. di_halt_callback) that trigger in
+  * another thread are executed later in the main thread (see
+  * TclCallback::executeDeferred()).
+  *
+  * The machines share the global settings. While replays run in other
+  * threads, those settings are read-only (see BaseSetting::setFrozen()).
+  * Before a replay runs in the main thread (its commands may change
+  * settings), first all other running replays are finished.
+  */
+class ReplayBatch
+{
+public:
+	explicit ReplayBatch(Reactor& reactor);
+
+	/** Run the given replays, with at most 'jobs' replays in parallel.
+	  * The results are printed in the same order as the given replays.
+	  * @return Process exit code: 0 when all replays could be run,
+	  *         otherwise 1.
+	  */
+	int run(const std::vector<std::string>& replays, unsigned jobs);
+
+private:
+	Reactor& reactor;
+};
+
+} // namespace openmsx
+
+#endif
@@ -26,6 +26,11 @@ string_view ReplayCLI::optionHelp() const
 void ReplayCLI::parseFileType(const string& filename,
                               array_ref<string>& /*cmdLine*/)
 {
+	if (parser.getParseStatus() == CommandLineParser::BATCH) {
+		// run later, see ReplayBatch
+		batchReplays.push_back(filename);
+		return;
+	}
 	TclObject command;
 	command.addListElement("reverse");
 	command.addListElement("loadreplay");
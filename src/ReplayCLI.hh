@@ -2,6 +2,8 @@
 #define REPLAYCLI_HH
 
 #include "CLIOption.hh"
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
@@ -18,8 +20,13 @@ public:
 	                   array_ref<std::string>& cmdLine) override;
 	string_view fileTypeHelp() const override;
 
+	const std::vector<std::string>& getBatchReplays() const {
+		return batchReplays;
+	}
+
 private:
 	CommandLineParser& parser;
+	std::vector<std::string> batchReplays;
 };
 
 } // namespace openmsx
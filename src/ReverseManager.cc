@@ -12,19 +12,23 @@
 #include "FileOperations.hh"
 #include "FileContext.hh"
 #include "StateChange.hh"
+#include "RecordedCommand.hh"
 #include "Timer.hh"
 #include "CliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
+#include "GlobalSettings.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <functional>
 #include <iomanip>
+#include <unordered_map>
 
 using std::string;
 using std::vector;
@@ -114,6 +118,29 @@ void ReverseManager::ReverseHistory::clear()
 	Events().swap(events);
 }
 
+size_t ReverseManager::ReverseHistory::getMemoryUsage() const
+{
+	// DeltaBlocks can be shared between chunks (and a DeltaBlockDiff
+	// shares its base block), so make sure each is only counted once.
+	size_t result = 0;
+	vector<const DeltaBlock*> blocks;
+	for (auto& p : chunks) {
+		auto& chunk = p.second;
+		result += chunk.size;
+		for (auto& b : chunk.deltaBlocks) {
+			for (const DeltaBlock* d = b.get(); d; d = d->getBase()) {
+				blocks.push_back(d);
+			}
+		}
+	}
+	std::sort(begin(blocks), end(blocks));
+	blocks.erase(std::unique(begin(blocks), end(blocks)), end(blocks));
+	for (auto* d : blocks) {
+		result += d->getDataSize();
+	}
+	return result;
+}
+
 
 class EndLogEvent final : public StateChange
 {
@@ -138,13 +165,19 @@ ReverseManager::ReverseManager(MSXMotherBoard& motherBoard_)
 	, syncInputEvent (motherBoard_.getScheduler())
 	, motherBoard(motherBoard_)
 	, eventDistributor(motherBoard.getReactor().getEventDistributor())
+	, memoryLimitSetting(motherBoard.getReactor().getGlobalSettings()
+	                          .getReverseMemoryLimitSetting())
 	, reverseCmd(motherBoard.getCommandController())
 	, keyboard(nullptr)
 	, eventDelay(nullptr)
+	, history(motherBoard.getReactor().getThreadPool())
 	, replayIndex(0)
+	, commandEventsEnd(0)
 	, collecting(false)
 	, pendingTakeSnapshot(false)
 	, reRecordCount(0)
+	, lastSeekDuration(0)
+	, lastSeekDistance(0.0)
 {
 	eventDistributor.registerEventListener(OPENMSX_TAKE_REVERSE_SNAPSHOT, *this);
 
@@ -163,6 +196,15 @@ bool ReverseManager::isReplaying() const
 	return replayIndex != history.events.size();
 }
 
+void ReverseManager::updateCommandEventsEnd()
+{
+	auto& events = history.events;
+	auto it = std::find_if(events.rbegin(), events.rend(),
+		[](const std::shared_ptr<StateChange>& e) {
+			return dynamic_cast<const MSXCommandEvent*>(e.get()) != nullptr; });
+	commandEventsEnd = unsigned(events.rend() - it);
+}
+
 void ReverseManager::start()
 {
 	if (!isCollecting()) {
@@ -185,6 +227,7 @@ void ReverseManager::stop()
 		syncInputEvent .removeSyncPoint(); // stop any pending replay actions
 		history.clear();
 		replayIndex = 0;
+		commandEventsEnd = 0;
 		collecting = false;
 		pendingTakeSnapshot = false;
 	}
@@ -246,6 +289,9 @@ void ReverseManager::status(TclObject& result) const
 	}
 	EmuTime le(isCollecting() && (lastEvent != history.events.rend()) ? (*lastEvent)->getTime() : EmuTime::zero);
 	result.addListElement((le - EmuTime::zero).toDouble());
+
+	result.addListElement("memory_usage");
+	result.addListElement(double(history.getMemoryUsage()));
 }
 
 void ReverseManager::debugInfo(TclObject& result) const
@@ -264,6 +310,9 @@ void ReverseManager::debugInfo(TclObject& result) const
 		totalSize += chunk.size;
 	}
 	strAppend(res, "total size: ", totalSize, '\n');
+	strAppend(res, "memory usage: ", history.getMemoryUsage(), '\n');
+	strAppend(res, "last seek: ", lastSeekDuration / 1000000.0, "s"
+	               " (emulated ", lastSeekDistance, "s)\n");
 	result.setString(res);
 }
 
@@ -347,6 +396,7 @@ void ReverseManager::goTo(
 	bool sameTimeLine)
 {
 	auto& mixer = motherBoard.getMSXMixer();
+	auto seekStart = Timer::getTime();
 	try {
 		// The call to MSXMotherBoard::fastForward() below may take
 		// some time to execute. The DirectX sound driver has a problem
@@ -459,37 +509,53 @@ void ReverseManager::goTo(
 		auto lastSnapshotTarget = startMSXTime;
 		bool everShowedProgress = false;
 		syncNewSnapshot.removeSyncPoint(); // don't schedule new snapshot takings during fast forward
-		while (true) {
-			auto currentTimeNewBoard = newBoard->getCurrentTime();
-			auto nextSnapshotTarget = std::min(
-				preTarget,
-				lastSnapshotTarget + std::max(
-					EmuDuration(SNAPSHOT_PERIOD),
-					(preTarget - lastSnapshotTarget) / 2
-					));
-			auto nextTarget = std::min(nextSnapshotTarget, currentTimeNewBoard + EmuDuration::sec(1));
-			newBoard->fastForward(nextTarget, true);
-			auto now = Timer::getTime();
-			if (((now - lastProgress) > 1000000) || ((currentTimeNewBoard >= preTarget) && everShowedProgress)) {
-				everShowedProgress = true;
-				lastProgress = now;
-				int percentage = ((currentTimeNewBoard - startMSXTime) * 100u) / (preTarget - startMSXTime);
-				reportProgress(newBoard->getReactor(), targetTime, percentage);
-			}
-			// note: fastForward does not always stop at
-			//       _exactly_ the requested time
-			if (currentTimeNewBoard >= preTarget) break;
-			if (currentTimeNewBoard >= nextSnapshotTarget) {
-				// NOTE: there used to be
-				//newBoard->getReactor().getEventDistributor().deliverEvents();
-				// here, but that has all kinds of nasty side effects: it enables
-				// processing of hotkeys, which can cause things like the machine
-				// being deleted, causing a crash. TODO: find a better way to support
-				// live updates of the UI whilst being in a reverse action...
-				newBoard->getReverseManager().takeSnapshot(currentTimeNewBoard);
-				lastSnapshotTarget = nextSnapshotTarget;
+		auto& newMixer = newBoard->getMSXMixer();
+		try {
+			while (true) {
+				auto currentTimeNewBoard = newBoard->getCurrentTime();
+				auto nextSnapshotTarget = std::min(
+					preTarget,
+					lastSnapshotTarget + std::max(
+						EmuDuration(SNAPSHOT_PERIOD),
+						(preTarget - lastSnapshotTarget) / 2
+						));
+				// Don't generate sound while seeking. Video isn't
+				// rendered either (renderers check
+				// MSXMotherBoard::isFastForwarding()). Though in
+				// seek mode the sound devices don't advance their
+				// internal state (e.g. phase counters), so only
+				// do this after the last snapshot has been taken.
+				newMixer.setSeekMode(nextSnapshotTarget == preTarget);
+				auto nextTarget = std::min(nextSnapshotTarget, currentTimeNewBoard + EmuDuration::sec(1));
+				newBoard->fastForward(nextTarget, true);
+				auto now = Timer::getTime();
+				if (((now - lastProgress) > 1000000) || ((currentTimeNewBoard >= preTarget) && everShowedProgress)) {
+					everShowedProgress = true;
+					lastProgress = now;
+					int percentage = ((currentTimeNewBoard - startMSXTime) * 100u) / (preTarget - startMSXTime);
+					reportProgress(newBoard->getReactor(), targetTime, percentage);
+				}
+				// note: fastForward does not always stop at
+				//       _exactly_ the requested time
+				if (currentTimeNewBoard >= preTarget) break;
+				if (currentTimeNewBoard >= nextSnapshotTarget) {
+					// NOTE: there used to be
+					//newBoard->getReactor().getEventDistributor().deliverEvents();
+					// here, but that has all kinds of nasty side effects: it enables
+					// processing of hotkeys, which can cause things like the machine
+					// being deleted, causing a crash. TODO: find a better way to support
+					// live updates of the UI whilst being in a reverse action...
+					newBoard->getReverseManager().takeSnapshot(currentTimeNewBoard);
+					lastSnapshotTarget = nextSnapshotTarget;
+				}
 			}
+		} catch (MSXException&) {
+			// seek mode may be enabled on the new board's mixer, which
+			// is not necessarily the same as 'mixer'
+			newMixer.setSeekMode(false);
+			throw;
 		}
+		newMixer.setSeekMode(false);
 		// re-enable automatic snapshots
 		schedule(getCurrentTime());
 
@@ -513,7 +579,10 @@ void ReverseManager::goTo(
 		}
 
 		//assert(!isCollecting()); // can't access 'this->' members anymore!
-		assert(newBoard->getReverseManager().isCollecting());
+		auto& newManager = newBoard->getReverseManager();
+		assert(newManager.isCollecting());
+		newManager.lastSeekDuration = Timer::getTime() - seekStart;
+		newManager.lastSeekDistance = (newBoard->getCurrentTime() - startMSXTime).toDouble();
 	} catch (MSXException&) {
 		// Make sure mixer doesn't stay muted in case of error.
 		mixer.unmute();
@@ -671,6 +740,38 @@ void ReverseManager::saveReplay(
 	result.setString("Saved replay to " + filename);
 }
 
+static string resolveReplayFilename(const string& fileNameArg)
+{
+	auto context = userDataFileContext(REPLAY_DIR);
+	try {
+		// Try filename as typed by user.
+		return context.resolve(fileNameArg);
+	} catch (MSXException& /*e1*/) { try {
+		// Not found, try adding '.omr'.
+		return context.resolve(fileNameArg + ".omr");
+	} catch (MSXException& e2) { try {
+		// Again not found, try adding '.gz'.
+		// (this is for backwards compatibility).
+		return context.resolve(fileNameArg + ".gz");
+	} catch (MSXException& /*e3*/) {
+		// Show error message that includes the default extension.
+		throw e2;
+	}}}
+}
+
+static void loadReplayFile(const string& filename, Replay& replay)
+{
+	try {
+		XmlInputArchive in(filename);
+		in.serialize("replay", replay);
+	} catch (XMLException& e) {
+		throw CommandException("Cannot load replay, bad file format: ",
+		                       e.getMessage());
+	} catch (MSXException& e) {
+		throw CommandException("Cannot load replay: ", e.getMessage());
+	}
+}
+
 void ReverseManager::loadReplay(
 	Interpreter& interp, array_ref<TclObject> tokens, TclObject& result)
 {
@@ -696,39 +797,14 @@ void ReverseManager::loadReplay(
 
 	if (arguments.size() != 1) throw SyntaxError();
 
-	// resolve the filename
-	auto context = userDataFileContext(REPLAY_DIR);
-	string fileNameArg = arguments[0];
-	string filename;
-	try {
-		// Try filename as typed by user.
-		filename = context.resolve(fileNameArg);
-	} catch (MSXException& /*e1*/) { try {
-		// Not found, try adding '.omr'.
-		filename = context.resolve(fileNameArg + ".omr");
-	} catch (MSXException& e2) { try {
-		// Again not found, try adding '.gz'.
-		// (this is for backwards compatibility).
-		filename = context.resolve(fileNameArg + ".gz");
-	} catch (MSXException& /*e3*/) {
-		// Show error message that includes the default extension.
-		throw e2;
-	}}}
+	string filename = resolveReplayFilename(arguments[0]);
 
 	// restore replay
 	auto& reactor = motherBoard.getReactor();
 	Replay replay(reactor);
 	Events events;
 	replay.events = &events;
-	try {
-		XmlInputArchive in(filename);
-		in.serialize("replay", replay);
-	} catch (XMLException& e) {
-		throw CommandException("Cannot load replay, bad file format: ",
-		                       e.getMessage());
-	} catch (MSXException& e) {
-		throw CommandException("Cannot load replay: ", e.getMessage());
-	}
+	loadReplayFile(filename, replay);
 
 	// get destination time index
 	auto destination = EmuTime::zero;
@@ -796,6 +872,47 @@ void ReverseManager::loadReplay(
 	result.setString("Loaded replay from " + filename);
 }
 
+std::unique_ptr<MSXMotherBoard> ReverseManager::loadReplayMachine(
+	Reactor& reactor, const string& fileNameArg,
+	EmuTime& endTime, bool& needsMainThread)
+{
+	string filename = resolveReplayFilename(fileNameArg);
+	Replay replay(reactor);
+	Events events;
+	replay.events = &events;
+	loadReplayFile(filename, replay);
+
+	// Start from the first snapshot, the others are not needed.
+	assert(!replay.motherBoards.empty());
+	auto newBoard = move(replay.motherBoards[0]);
+	auto& newManager = newBoard->getReverseManager();
+	EmuTime startTime = newBoard->getCurrentTime();
+
+	// terminate replay log with EndLogEvent (if not there already)
+	if (events.empty() ||
+	    !dynamic_cast<const EndLogEvent*>(events.back().get())) {
+		EmuTime t = std::max(replay.currentTime, startTime);
+		if (!events.empty()) t = std::max(t, events.back()->getTime());
+		events.push_back(std::make_shared<EndLogEvent>(t));
+	}
+	endTime = events.back()->getTime();
+
+	// Replay all events starting from the snapshot. Unlike transferHistory()
+	// no new snapshots are taken.
+	swap(newManager.history.events, events);
+	auto& newEvents = newManager.history.events;
+	unsigned replayIdx = 0;
+	while (newEvents[replayIdx]->getTime() < startTime) ++replayIdx;
+	newManager.collecting = true;
+	newManager.replayIndex = replayIdx;
+	newManager.updateCommandEventsEnd();
+	needsMainThread = newManager.replayNeedsMainThread();
+	newBoard->getStateChangeDistributor().registerRecorder(newManager);
+	newBoard->getStateChangeDistributor().setViewOnlyMode(true);
+	newManager.replayNextEvent();
+	return newBoard;
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -807,6 +924,7 @@ void ReverseManager::transferHistory(ReverseHistory& oldHistory,
 
 	// actual history transfer
 	history.swap(oldHistory);
+	updateCommandEventsEnd();
 
 	// resume collecting (and event recording)
 	collecting = true;
@@ -918,6 +1036,8 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
 	newChunk.eventCount = replayIndex;
+
+	enforceMemoryLimit(time);
 }
 
 void ReverseManager::replayNextEvent()
@@ -941,6 +1061,9 @@ void ReverseManager::signalStateChange(const shared_ptr<StateChange>& event)
 		// record event
 		history.events.push_back(event);
 		++replayIndex;
+		if (dynamic_cast<MSXCommandEvent*>(event.get())) {
+			commandEventsEnd = replayIndex;
+		}
 		assert(!isReplaying());
 	}
 }
@@ -960,6 +1083,7 @@ void ReverseManager::stopReplay(EmuTime::param time)
 		syncInputEvent.removeSyncPoint();
 		Events& events = history.events;
 		events.erase(begin(events) + replayIndex, end(events));
+		commandEventsEnd = std::min(commandEventsEnd, replayIndex);
 		// search snapshots that are newer than 'time' and erase them
 		auto it = find_if(begin(history.chunks), end(history.chunks),
 			[&](Chunks::value_type& p) { return p.second.time > time; });
@@ -997,6 +1121,77 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 	}
 }
 
+/* When the reverse history uses more memory than allowed by the
+ * 'reverse_memory_limit' setting, drop snapshots until it fits again.
+ *
+ * Snapshots are dropped one at a time, each time the one that is least
+ * valuable: the one where removing it creates the smallest gap relative to
+ * its age. So the (roughly exponential) spacing created by
+ * dropOldSnapshots() is preserved, only with fewer snapshots. Like in
+ * dropOldSnapshots(), the very oldest and the most recent snapshot are never
+ * dropped.
+ */
+void ReverseManager::enforceMemoryLimit(EmuTime::param time)
+{
+	size_t limit = size_t(memoryLimitSetting.getInt()) * 1024 * 1024;
+	if (limit == 0) return; // unlimited
+
+	auto& chunks = history.chunks;
+	if (chunks.size() <= 2) return;
+
+	// Calculate the memory usage only once, like getMemoryUsage(). Also
+	// count how many chunks use each DeltaBlock, so that the usage can be
+	// updated when a chunk is dropped.
+	struct BlockUse {
+		unsigned count;
+		size_t size;
+	};
+	std::unordered_map<const DeltaBlock*, BlockUse> blockUse;
+	size_t usage = 0;
+	for (auto& p : chunks) {
+		auto& chunk = p.second;
+		usage += chunk.size;
+		for (auto& b : chunk.deltaBlocks) {
+			for (const DeltaBlock* d = b.get(); d; d = d->getBase()) {
+				auto r = blockUse.emplace(d, BlockUse{0, 0});
+				if (r.second) {
+					r.first->second.size = d->getDataSize();
+					usage += r.first->second.size;
+				}
+				++r.first->second.count;
+			}
+		}
+	}
+
+	while ((chunks.size() > 2) && (usage > limit)) {
+		auto victim = end(chunks);
+		double victimValue = 0.0;
+		auto last = std::prev(end(chunks));
+		for (auto it = std::next(begin(chunks)); it != last; ++it) {
+			EmuTime prevTime = std::prev(it)->second.time;
+			EmuTime nextTime = std::next(it)->second.time;
+			EmuTime thisTime = it->second.time;
+			double age = (thisTime < time) ? (time - thisTime).toDouble()
+			                               : 0.0;
+			double gap = (nextTime - prevTime).toDouble();
+			double value = gap / (age + SNAPSHOT_PERIOD);
+			if ((victim == end(chunks)) || (value < victimValue)) {
+				victim = it;
+				victimValue = value;
+			}
+		}
+		auto& chunk = victim->second;
+		usage -= chunk.size;
+		for (auto& b : chunk.deltaBlocks) {
+			for (const DeltaBlock* d = b.get(); d; d = d->getBase()) {
+				auto& use = blockUse[d];
+				if (--use.count == 0) usage -= use.size;
+			}
+		}
+		chunks.erase(victim);
+	}
+}
+
 void ReverseManager::schedule(EmuTime::param time)
 {
 	syncNewSnapshot.setSyncPoint(time + EmuDuration(SNAPSHOT_PERIOD));
@@ -14,15 +14,19 @@
 #include <map>
 #include <memory>
 #include <cstdint>
+#include <string>
 
 namespace openmsx {
 
 class MSXMotherBoard;
+class Reactor;
 class Keyboard;
 class EventDelay;
 class EventDistributor;
+class ThreadPool;
 class TclObject;
 class Interpreter;
+class IntegerSetting;
 
 class ReverseManager final : private EventListener, private StateChangeRecorder
 {
@@ -50,6 +54,24 @@ public:
 		reRecordCount = count;
 	}
 
+	/** Are there still recorded commands to be replayed? Those are
+	  * executed via Tcl, so such a machine can only be emulated in the
+	  * main thread.
+	  */
+	bool replayNeedsMainThread() const { return replayIndex < commandEventsEnd; }
+
+	/** Load a replay into a new (non-active) machine that is ready to
+	  * replay all recorded events, starting from the first snapshot in
+	  * the replay. Used by the batch replay mode, see ReplayBatch.
+	  * @param reactor The Reactor.
+	  * @param filename Name of the replay file.
+	  * @param endTime Output, the time of the end of the replay.
+	  * @param needsMainThread Output, see replayNeedsMainThread().
+	  */
+	static std::unique_ptr<MSXMotherBoard> loadReplayMachine(
+		Reactor& reactor, const std::string& filename,
+		EmuTime& endTime, bool& needsMainThread);
+
 private:
 	struct ReverseChunk {
 		ReverseChunk() : time(EmuTime::zero) {}
@@ -68,9 +90,13 @@ private:
 	using Events = std::vector<std::shared_ptr<StateChange>>;
 
 	struct ReverseHistory {
+		explicit ReverseHistory(ThreadPool& pool)
+			: lastDeltaBlocks(pool) {}
+
 		void swap(ReverseHistory& other);
 		void clear();
 		unsigned getNextSeqNum(EmuTime::param time) const;
+		size_t getMemoryUsage() const;
 
 		Chunks chunks;
 		Events events;
@@ -98,10 +124,12 @@ private:
 	void transferHistory(ReverseHistory& oldHistory,
 	                     unsigned oldEventCount);
 	void transferState(MSXMotherBoard& newBoard);
+	void updateCommandEventsEnd();
 	void takeSnapshot(EmuTime::param time);
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
+	void enforceMemoryLimit(EmuTime::param time);
 
 	// Schedulable
 	struct SyncNewSnapshot : Schedulable {
@@ -135,6 +163,7 @@ private:
 
 	MSXMotherBoard& motherBoard;
 	EventDistributor& eventDistributor;
+	IntegerSetting& memoryLimitSetting;
 
 	struct ReverseCmd final : Command {
 		explicit ReverseCmd(CommandController& controller);
@@ -147,11 +176,18 @@ private:
 	EventDelay* eventDelay;
 	ReverseHistory history;
 	unsigned replayIndex;
+	// Index in history.events just past the last recorded command, see
+	// replayNeedsMainThread(). Updated by updateCommandEventsEnd().
+	unsigned commandEventsEnd;
 	bool collecting;
 	bool pendingTakeSnapshot;
 
 	unsigned reRecordCount;
 
+	// Statistics about the last 'reverse goto' (shown in 'reverse debug').
+	uint64_t lastSeekDuration; // real time in us
+	double lastSeekDistance;   // fast-forwarded emulation time in s
+
 	friend struct Replay;
 };
 
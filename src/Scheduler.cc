@@ -39,14 +39,12 @@ Scheduler::~Scheduler()
 
 void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isEmulationThread());
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
 	queue.insert(SynchronizationPoint(time, &device),
-	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             SetSentinel(), LessSyncPoint());
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -61,38 +59,45 @@ Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 	SyncPoints result;
 	copy_if(std::begin(queue), std::end(queue), back_inserter(result),
 	        EqualSchedulable(device));
+	// The queue isn't necessarily iterated in order (SchedulerHeap), but
+	// the savestate must not depend on that. Sync points with the same
+	// time are identical here (all have the same device).
+	std::sort(std::begin(result), std::end(result), LessSyncPoint());
 	return result;
 }
 
 bool Scheduler::removeSyncPoint(Schedulable& device)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isEmulationThread());
 	return queue.remove(EqualSchedulable(device));
 }
 
 void Scheduler::removeSyncPoints(Schedulable& device)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isEmulationThread());
 	queue.remove_all(EqualSchedulable(device));
 }
 
 bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
-	assert(Thread::isMainThread());
-	auto it = std::find_if(std::begin(queue), std::end(queue),
-	                       EqualSchedulable(device));
-	if (it != std::end(queue)) {
-		result = it->getTime();
-		return true;
-	} else {
-		return false;
+	assert(Thread::isEmulationThread());
+	// Search the earliest one, the queue isn't necessarily iterated in
+	// order (SchedulerHeap).
+	bool found = false;
+	for (auto& sp : queue) {
+		if ((sp.getDevice() == &device) &&
+		    (!found || (sp.getTime() < result))) {
+			result = sp.getTime();
+			found = true;
+		}
 	}
+	return found;
 }
 
 EmuTime::param Scheduler::getCurrentTime() const
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isEmulationThread());
 	return scheduleTime;
 }
 
@@ -116,7 +121,7 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 	}
 	scheduleInProgress = false;
 
-	cpu->setNextSyncPoint(next);
+	if (cpu) cpu->setNextSyncPoint(next);
 }
 
 
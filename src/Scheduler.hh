@@ -3,6 +3,7 @@
 
 #include "EmuTime.hh"
 #include "SchedulerQueue.hh"
+#include "SchedulerHeap.hh"
 #include "likely.hh"
 #include <vector>
 
@@ -31,6 +32,20 @@ private:
 };
 
 
+struct LessSyncPoint {
+	bool operator()(const SynchronizationPoint& x,
+	                const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
+struct SetSentinel {
+	void operator()(SynchronizationPoint& sp) const {
+		sp.setTime(EmuTime::infinity);
+	}
+};
+
+
 class Scheduler
 {
 public:
@@ -109,10 +124,18 @@ private: // -> intended for Schedulable
 private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
 
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	/** Not a priority queue because that doesn't allow removal of
+	  * non-top element. By default a sorted array, this is fastest when
+	  * there are only a few sync points. Compile with
+	  * -DUSE_SCHEDULER_HEAP to use a heap instead, that's faster when
+	  * there are many sync points. The iteration order of the heap is
+	  * unspecified.
 	  */
+#ifdef USE_SCHEDULER_HEAP
+	SchedulerHeap<SynchronizationPoint, LessSyncPoint> queue;
+#else
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
 	EmuTime scheduleTime;
 	MSXCPU* cpu;
 	bool scheduleInProgress;
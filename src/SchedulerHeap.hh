@@ -0,0 +1,185 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include "likely.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue, based on a 4-ary heap. Inserting and
+// removing the smallest element are O(log(N)) instead of (worst case) O(N),
+// so this is faster when there are many sync points (many devices). For a
+// typical machine with only a handful of sync points SchedulerQueue is
+// usually faster.
+//
+// The interface is the same as SchedulerQueue's, except that the comparison
+// predicate is a template parameter of the class (it's also needed to remove
+// elements). The iteration order (begin(), end()) is unspecified, so users
+// that need the elements in order have to search or sort them.
+//
+// A heap is not a stable data structure, but the Scheduler requires that
+// equivalent elements are removed in insertion order. So each element gets
+// a sequence number that's used as a tie breaker.
+template<typename T, typename LESS> class SchedulerHeap
+{
+public:
+	static const size_t CAPACITY = 32; // initial capacity
+	static const size_t ARITY = 4;
+
+	SchedulerHeap()
+		: items(CAPACITY), order(CAPACITY), num(0), counter(0)
+	{
+	}
+
+	size_t size()  const { return num; }
+	bool   empty() const { return num == 0; }
+
+	// Returns reference to the first element, This is the smallest element
+	// according to the sorting criteria. When empty, this is the sentinel
+	// (only after at least one element was inserted), like SchedulerQueue.
+	      T& front()       { return items[0]; }
+	const T& front() const { return items[0]; }
+
+	      T* begin()       { return items.data(); }
+	const T* begin() const { return items.data(); }
+	      T* end()         { return items.data() + num; }
+	const T* end()   const { return items.data() + num; }
+
+	// Insert new element, see SchedulerQueue::insert().
+	template<typename SET_SENTINEL>
+	void insert(const T& t, SET_SENTINEL setSentinel, LESS /*less*/)
+	{
+		if (unlikely(num == 0)) {
+			setSentinel(sentinel);
+		}
+		if (unlikely(num == items.size())) {
+			items.resize(2 * num);
+			order.resize(2 * num);
+		}
+		siftUp(num++, t, counter++);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		removeAt(0);
+	}
+
+	// Remove the first element (in sorted order, like SchedulerQueue) for
+	// which the given predicate returns true.
+	template<typename PRED> bool remove(PRED p)
+	{
+		size_t found = num;
+		for (size_t i = 0; i < num; ++i) {
+			if (p(items[i]) &&
+			    ((found == num) ||
+			     lessThan(items[i], order[i], items[found], order[found]))) {
+				found = i;
+			}
+		}
+		if (found == num) return false;
+		removeAt(found);
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	template<typename PRED> void remove_all(PRED p)
+	{
+		size_t j = 0;
+		for (size_t i = 0; i < num; ++i) {
+			if (!p(items[i])) {
+				items[j] = items[i];
+				order[j] = order[i];
+				++j;
+			}
+		}
+		num = j;
+		if (num == 0) {
+			items[0] = sentinel;
+			return;
+		}
+		// restore heap property, bottom-up
+		for (size_t i = (num - 1) / ARITY + 1; i-- > 0; /**/) {
+			T t = items[i];
+			siftDown(i, t, order[i]);
+		}
+	}
+
+private:
+	bool lessThan(const T& x, uint64_t xo, const T& y, uint64_t yo) const
+	{
+		if (less(x, y)) return true;
+		if (less(y, x)) return false;
+		return xo < yo; // equivalent elements: first inserted comes first
+	}
+
+	void removeAt(size_t i)
+	{
+		--num;
+		if (i == num) {
+			if (num == 0) items[0] = sentinel;
+			return;
+		}
+		// Move the last element into the hole, it may need to move
+		// either up or down from there.
+		T t = items[num];
+		uint64_t o = order[num];
+		if ((i != 0) &&
+		    lessThan(t, o, items[(i - 1) / ARITY], order[(i - 1) / ARITY])) {
+			siftUp(i, t, o);
+		} else {
+			siftDown(i, t, o);
+		}
+	}
+
+	void siftUp(size_t i, const T& t, uint64_t o)
+	{
+		while (i != 0) {
+			size_t parent = (i - 1) / ARITY;
+			if (!lessThan(t, o, items[parent], order[parent])) break;
+			items[i] = items[parent];
+			order[i] = order[parent];
+			i = parent;
+		}
+		items[i] = t;
+		order[i] = o;
+	}
+
+	void siftDown(size_t i, const T& t, uint64_t o)
+	{
+		while (true) {
+			size_t first = ARITY * i + 1;
+			if (first >= num) break;
+			size_t last = std::min(first + ARITY, num);
+			size_t best = first;
+			for (size_t c = first + 1; c < last; ++c) {
+				if (lessThan(items[c], order[c], items[best], order[best])) {
+					best = c;
+				}
+			}
+			if (!lessThan(items[best], order[best], t, o)) break;
+			items[i] = items[best];
+			order[i] = order[best];
+			i = best;
+		}
+		items[i] = t;
+		order[i] = o;
+	}
+
+private:
+	// Invariant: items.size() == order.size() >= max(num, 1)
+	std::vector<T> items;
+	std::vector<uint64_t> order; // sequence numbers, tie breaker
+	T sentinel;
+	LESS less;
+	size_t num;
+	uint64_t counter;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
@@ -147,6 +147,13 @@ void Interpreter::unregisterCommand(Command& command)
 	Tcl_DeleteCommandFromToken(interp, static_cast<Tcl_Command>(command.getToken()));
 }
 
+static std::function<void()> accessCallback;
+
+void Interpreter::setAccessCallback(std::function<void()> callback)
+{
+	accessCallback = std::move(callback);
+}
+
 int Interpreter::commandProc(ClientData clientData, Tcl_Interp* interp,
                            int objc, Tcl_Obj* const objv[])
 {
@@ -158,6 +165,7 @@ int Interpreter::commandProc(ClientData clientData, Tcl_Interp* interp,
 		int res = TCL_OK;
 		TclObject result;
 		try {
+			if (accessCallback) accessCallback();
 			if (!command.isAllowedInEmptyMachine()) {
 				if (auto controller =
 					dynamic_cast<MSXCommandController*>(
@@ -373,6 +381,14 @@ char* Interpreter::traceProc(ClientData clientData, Tcl_Interp* interp,
 		assert(removeColonColon(part1) == removeColonColon(part1Obj.getString()));
 
 		static string static_string;
+		if (accessCallback) {
+			try {
+				accessCallback();
+			} catch (MSXException& e) {
+				static_string = e.getMessage();
+				return const_cast<char*>(static_string.c_str());
+			}
+		}
 		if (flags & TCL_TRACE_READS) {
 			try {
 				setVar(interp, part1Obj, variable->getValue());
@@ -385,6 +401,7 @@ char* Interpreter::traceProc(ClientData clientData, Tcl_Interp* interp,
 			try {
 				Tcl_Obj* v = getVar(interp, part1Obj);
 				TclObject newValue(v ? v : Tcl_NewObj());
+				variable->checkNotFrozen();
 				variable->setValueDirect(newValue);
 				const TclObject& newValue2 = variable->getValue();
 				if (newValue != newValue2) {
@@ -401,6 +418,7 @@ char* Interpreter::traceProc(ClientData clientData, Tcl_Interp* interp,
 				// note we cannot use restoreDefault(), because
 				// that goes via Tcl and the Tcl variable
 				// doesn't exist at this point
+				variable->checkNotFrozen();
 				variable->setValueDirect(TclObject(
 					variable->getRestoreValue()));
 			} catch (MSXException&) {
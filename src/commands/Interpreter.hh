@@ -4,6 +4,7 @@
 #include "TclParser.hh"
 #include "TclObject.hh"
 #include "string_view.hh"
+#include <functional>
 #include <vector>
 #include <tcl.h>
 
@@ -52,6 +53,12 @@ public:
 
 	void poll();
 
+	/** The given function is called (in the main thread) right before Tcl
+	  * executes an openMSX command or accesses a setting. The Reactor uses
+	  * this to stop the machines that run in background threads.
+	  */
+	static void setAccessCallback(std::function<void()> callback);
+
 private:
 	static int outputProc(ClientData clientData, const char* buf,
 	        int toWrite, int* errorCodePtr);
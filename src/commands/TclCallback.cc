@@ -3,13 +3,25 @@
 #include "CliComm.hh"
 #include "CommandException.hh"
 #include "StringSetting.hh"
+#include "Thread.hh"
 #include "memory.hh"
+#include <algorithm>
+#include <cassert>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <utility>
 
 using std::string;
+using std::vector;
 
 namespace openmsx {
 
+// Callbacks triggered in a background machine (see executeDeferred()).
+using Deferred = std::pair<TclCallback*, vector<string>>;
+static std::deque<Deferred> deferred;
+static std::mutex deferredMutex;
+
 TclCallback::TclCallback(
 		CommandController& controller,
 		string_view name,
@@ -30,7 +42,13 @@ TclCallback::TclCallback(StringSetting& setting)
 {
 }
 
-TclCallback::~TclCallback() = default;
+TclCallback::~TclCallback()
+{
+	std::lock_guard<std::mutex> lock(deferredMutex);
+	deferred.erase(std::remove_if(begin(deferred), end(deferred),
+		[&](const Deferred& d) { return d.first == this; }),
+		end(deferred));
+}
 
 TclObject TclCallback::getValue() const
 {
@@ -39,6 +57,7 @@ TclObject TclCallback::getValue() const
 
 TclObject TclCallback::execute()
 {
+	if (!Thread::isMainThread()) return defer({});
 	const auto& callback = getValue();
 	if (callback.empty()) return TclObject();
 
@@ -49,6 +68,7 @@ TclObject TclCallback::execute()
 
 TclObject TclCallback::execute(int arg1)
 {
+	if (!Thread::isMainThread()) return defer({strCat(arg1)});
 	const auto& callback = getValue();
 	if (callback.empty()) return TclObject();
 
@@ -60,6 +80,7 @@ TclObject TclCallback::execute(int arg1)
 
 TclObject TclCallback::execute(int arg1, int arg2)
 {
+	if (!Thread::isMainThread()) return defer({strCat(arg1), strCat(arg2)});
 	const auto& callback = getValue();
 	if (callback.empty()) return TclObject();
 
@@ -72,6 +93,7 @@ TclObject TclCallback::execute(int arg1, int arg2)
 
 TclObject TclCallback::execute(int arg1, string_view arg2)
 {
+	if (!Thread::isMainThread()) return defer({strCat(arg1), arg2.str()});
 	const auto& callback = getValue();
 	if (callback.empty()) return TclObject();
 
@@ -84,6 +106,7 @@ TclObject TclCallback::execute(int arg1, string_view arg2)
 
 TclObject TclCallback::execute(string_view arg1, string_view arg2)
 {
+	if (!Thread::isMainThread()) return defer({arg1.str(), arg2.str()});
 	const auto& callback = getValue();
 	if (callback.empty()) return TclObject();
 
@@ -94,6 +117,39 @@ TclObject TclCallback::execute(string_view arg1, string_view arg2)
 	return executeCommon(command);
 }
 
+TclObject TclCallback::defer(vector<string> args)
+{
+	// Don't touch any Tcl objects (not even the callback setting) in
+	// this thread, only copy the arguments.
+	std::lock_guard<std::mutex> lock(deferredMutex);
+	deferred.emplace_back(this, std::move(args));
+	return TclObject();
+}
+
+void TclCallback::executeDeferred()
+{
+	assert(Thread::isMainThread());
+	while (true) {
+		// One at a time: a callback may delete (the owner of) other
+		// callbacks, see the destructor.
+		Deferred d;
+		{
+			std::lock_guard<std::mutex> lock(deferredMutex);
+			if (deferred.empty()) return;
+			d = std::move(deferred.front());
+			deferred.pop_front();
+		}
+		auto& callback = *d.first;
+		const auto& name = callback.getValue();
+		if (name.empty()) continue;
+
+		TclObject command;
+		command.addListElement(name);
+		for (auto& arg : d.second) command.addListElement(arg);
+		callback.executeCommon(command);
+	}
+}
+
 TclObject TclCallback::executeCommon(TclObject& command)
 {
 	try {
@@ -4,6 +4,8 @@
 #include "TclObject.hh"
 #include "string_view.hh"
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
@@ -27,10 +29,18 @@ public:
 	TclObject execute(int arg1, string_view arg2);
 	TclObject execute(string_view arg1, string_view arg2);
 
+	/** Tcl may only be used in the main thread. When a callback gets
+	  * triggered in another thread (a machine running in the background),
+	  * it's queued and the execute() methods return an empty result.
+	  * This executes the queued callbacks, call it from the main thread.
+	  */
+	static void executeDeferred();
+
 	TclObject getValue() const;
 	StringSetting& getSetting() const { return callbackSetting; }
 
 private:
+	TclObject defer(std::vector<std::string> args);
 	TclObject executeCommon(TclObject& command);
 
 	std::unique_ptr<StringSetting> callbackSetting2; // can be nullptr
@@ -1,23 +1,68 @@
 #include "BreakPointBase.hh"
+#include "NativeCondition.hh"
 #include "CommandException.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
 #include "GlobalCliComm.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
 #include "ScopedAssign.hh"
 
 namespace openmsx {
 
+// Evaluates native conditions on the given machine, with the same result as
+// the corresponding Tcl commands (see NativeCondition).
+class MotherBoardReader final : public NativeCondition::Reader
+{
+public:
+	explicit MotherBoardReader(MSXMotherBoard& motherBoard_)
+		: motherBoard(motherBoard_) {}
+
+	byte read(string_view name, unsigned address) override
+	{
+		// same errors as 'debug read'
+		auto* debuggable = motherBoard.getDebugger().findDebuggable(name);
+		if (!debuggable) {
+			throw CommandException("No such debuggable: ", name);
+		}
+		if (address >= debuggable->getSize()) {
+			throw CommandException("Invalid address");
+		}
+		return debuggable->read(address);
+	}
+
+	bool isExpanded(int ps) override
+	{
+		return motherBoard.getCPUInterface().isExpanded(ps);
+	}
+
+private:
+	MSXMotherBoard& motherBoard;
+};
+
+
 BreakPointBase::BreakPointBase(TclObject command_, TclObject condition_)
 	: command(std::move(command_)), condition(std::move(condition_))
 	, executing(false)
 {
+	auto native = std::make_shared<NativeCondition>();
+	if (native->compile(condition.getString())) {
+		nativeCondition = std::move(native);
+	}
 }
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            MSXMotherBoard& motherBoard) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
 	try {
+		if (nativeCondition) {
+			MotherBoardReader reader(motherBoard);
+			return nativeCondition->eval(reader);
+		}
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
 		cliComm.printWarning(e.getMessage());
@@ -25,14 +70,27 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+bool BreakPointBase::isCertainlyFalse(MSXMotherBoard& motherBoard) const
+{
+	if (!nativeCondition) return false;
+	try {
+		MotherBoardReader reader(motherBoard);
+		return !nativeCondition->eval(reader);
+	} catch (CommandException&) {
+		// let checkAndExecute() report the error
+		return false;
+	}
+}
+
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     MSXMotherBoard& motherBoard)
 {
 	if (executing) {
 		// no recursive execution
 		return;
 	}
 	ScopedAssign<bool> sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	if (isTrue(cliComm, interp, motherBoard)) {
 		try {
 			command.executeCommand(interp, true); // compile command
 		} catch (CommandException& e) {
@@ -3,11 +3,14 @@
 
 #include "TclObject.hh"
 #include "string_view.hh"
+#include <memory>
 
 namespace openmsx {
 
 class Interpreter;
 class GlobalCliComm;
+class MSXMotherBoard;
+class NativeCondition;
 
 /** Base class for CPU break and watch points.
  */
@@ -19,7 +22,15 @@ public:
 	TclObject getConditionObj() const { return condition; }
 	TclObject getCommandObj()   const { return command; }
 
-	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     MSXMotherBoard& motherBoard);
+
+	/** Returns true when it's cheap to determine that checkAndExecute()
+	  * won't execute the command (condition is compiled to native code
+	  * and currently evaluates to false). A false result means the
+	  * condition must be checked via checkAndExecute().
+	  */
+	bool isCertainlyFalse(MSXMotherBoard& motherBoard) const;
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -28,10 +39,14 @@ protected:
 	BreakPointBase(TclObject command, TclObject condition);
 
 private:
-	bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
+	bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	            MSXMotherBoard& motherBoard) const;
 
 	TclObject command;
 	TclObject condition;
+	// Compiled version of 'condition', nullptr if that's not possible.
+	// Shared because breakpoints/conditions are often copied.
+	std::shared_ptr<const NativeCondition> nativeCondition;
 	bool executing;
 };
 
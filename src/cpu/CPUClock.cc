@@ -5,6 +5,7 @@ namespace openmsx {
 
 CPUClock::CPUClock(EmuTime::param time, Scheduler& scheduler_)
 	: clock(time)
+	, totalTicks(0)
 	, scheduler(scheduler_)
 	, remaining(-1), limit(-1), limitEnabled(false)
 {
@@ -13,6 +14,7 @@ CPUClock::CPUClock(EmuTime::param time, Scheduler& scheduler_)
 void CPUClock::advanceTime(EmuTime::param time)
 {
 	remaining = limit;
+	totalTicks += clock.getTicksTill(time);
 	clock.advance(time);
 	setLimit(scheduler.getNext());
 }
@@ -20,7 +20,7 @@ protected:
 // when using the following code:
 #if 0
 	// 64-bit addition is cheap
-	inline void add(unsigned ticks) { clock += ticks; }
+	inline void add(unsigned ticks) { clock += ticks; totalTicks += ticks; }
 	inline void sync() const { }
 #else
 	// 64-bit addition is expensive
@@ -28,6 +28,7 @@ protected:
 	inline void add(unsigned ticks) { remaining -= ticks; }
 	inline void sync() const {
 		clock.fastAdd(limit - remaining);
+		totalTicks += limit - remaining;
 		limit = remaining;
 	}
 #endif
@@ -38,6 +39,12 @@ protected:
 	const EmuTime getTimeFast(int cc) const {
 		return clock.getFastAdd(limit - remaining + cc);
 	}
+	/** Number of ticks executed so far. Unlike the tick count of the
+	  * underlying clock this doesn't jump on a frequency change (but
+	  * setTime() isn't counted). */
+	uint64_t getTotalTicks() const {
+		return totalTicks + (limit - remaining);
+	}
 	void setTime(EmuTime::param time) { sync(); clock.reset(time); }
 	void setFreq(unsigned freq) { clock.setFreq(freq); }
 	void advanceTime(EmuTime::param time);
@@ -55,6 +62,7 @@ protected:
 		unsigned ticks = clock.getTicksTillUp(time);
 		unsigned halts = (ticks + hltStates - 1) / hltStates; // round up
 		clock += halts * hltStates;
+		totalTicks += halts * hltStates;
 		return halts;
 	}
 
@@ -65,8 +73,8 @@ protected:
 	void waitForEvenCycle(int cc)
 	{
 		sync();
-		auto totalTicks = clock.getTotalTicks() + cc;
-		if (totalTicks & 1) {
+		auto ticks = clock.getTotalTicks() + cc;
+		if (ticks & 1) {
 			add(1);
 		}
 	}
@@ -119,6 +127,7 @@ protected:
 
 private:
 	mutable DynamicClock clock;
+	mutable uint64_t totalTicks;
 	Scheduler& scheduler;
 	int remaining;
 	mutable int limit;
@@ -159,6 +159,8 @@
 // instructions too late.
 
 #include "CPUCore.hh"
+#include "CPUProfiler.hh"
+#include "CPUTraceBuffer.hh"
 #include "MSXCPUInterface.hh"
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
@@ -329,6 +331,8 @@ template<class T> CPUCore<T>::CPUCore(
 	, nmiEdge(false)
 	, exitLoop(false)
 	, tracingEnabled(traceSetting.getBoolean())
+	, profiler(nullptr)
+	, traceBuffer(nullptr)
 	, isTurboR(motherboard.isTurboR())
 {
 	static_assert(!std::is_polymorphic<CPUCore<T>>::value,
@@ -341,6 +345,18 @@ template<class T> void CPUCore<T>::warp(EmuTime::param time)
 {
 	assert(T::getTimeFast() <= time);
 	T::setTime(time);
+	if (profiler) profiler->skipCycles();
+}
+
+template<class T> void CPUCore<T>::setProfiler(CPUProfiler* profiler_)
+{
+	profiler = profiler_;
+	if (profiler) profiler->skipCycles();
+}
+
+template<class T> void CPUCore<T>::setTraceBuffer(CPUTraceBuffer* traceBuffer_)
+{
+	traceBuffer = traceBuffer_;
 }
 
 template<class T> EmuTime::param CPUCore<T>::getCurrentTime() const
@@ -356,6 +372,8 @@ template<class T> void CPUCore<T>::invalidateMemCache(unsigned start, unsigned s
 	memset(&writeCacheLine [first], 0, num * sizeof(byte*)); //
 	memset(&readCacheTried [first], 0, num * sizeof(bool));  // FALSE
 	memset(&writeCacheTried[first], 0, num * sizeof(bool));  //
+	memset(&readWatchLine  [first], 0, num * sizeof(byte*)); // nullptr
+	memset(&writeWatchLine [first], 0, num * sizeof(byte*)); //
 }
 
 template<class T> void CPUCore<T>::doReset(EmuTime::param time)
@@ -429,13 +447,13 @@ template<class T> void CPUCore<T>::exitCPULoopAsync()
 }
 template<class T> void CPUCore<T>::exitCPULoopSync()
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isEmulationThread());
 	exitLoop = true;
 	T::disableLimit();
 }
 template<class T> inline bool CPUCore<T>::needExitCPULoop()
 {
-	// always executed in main thread
+	// always executed in the emulation thread
 	if (unlikely(exitLoop)) {
 		// Note: The test-and-set is _not_ atomic! But that's fine.
 		//   An atomic implementation is trivial (see below), but
@@ -579,6 +597,7 @@ template<class T> void CPUCore<T>::doSetFreq()
 		// unlocked, use value set by user
 		T::setFreq(freqValue.getInt());
 	}
+	if (profiler) profiler->skipCycles();
 }
 
 
@@ -614,9 +633,21 @@ NEVER_INLINE byte CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 			readCacheLine[high] = line - addrBase;
 			return readCacheLine[high][address];
 		}
+		// only uncacheable because of (read) watchpoints?
+		if (const byte* line = interface->getReadCacheLineIgnoreWatch(addrBase)) {
+			readWatchLine[high] = line - addrBase;
+		}
+		readCacheTried[high] = true;
+	}
+	if (const byte* line = readWatchLine[high]) {
+		if (!interface->isReadWatched(address)) {
+			// no watchpoint on this specific address
+			T::template PRE_MEM<PRE_PB, POST_PB>(address);
+			T::template POST_MEM<       POST_PB>(address);
+			return line[address];
+		}
 	}
 	// uncacheable
-	readCacheTried[high] = true;
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -718,9 +749,22 @@ NEVER_INLINE void CPUCore<T>::WRMEMslow(unsigned address, byte value, unsigned c
 			writeCacheLine[high][address] = value;
 			return;
 		}
+		// only uncacheable because of (write) watchpoints?
+		if (byte* line = interface->getWriteCacheLineIgnoreWatch(addrBase)) {
+			writeWatchLine[high] = line - addrBase;
+		}
+		writeCacheTried[high] = true;
+	}
+	if (byte* line = writeWatchLine[high]) {
+		if (!interface->isWriteWatched(address)) {
+			// no watchpoint on this specific address
+			T::template PRE_MEM<PRE_PB, POST_PB>(address);
+			T::template POST_MEM<       POST_PB>(address);
+			line[address] = value;
+			return;
+		}
 	}
 	// uncacheable
-	writeCacheTried[high] = true;
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -863,6 +907,43 @@ template<class T> inline void CPUCore<T>::irq2()
 	T::add(T::CC_IRQ2);
 }
 
+// Called right before an instruction is fetched. When profiling, the only
+// overhead is a (well predicted) test on a member variable.
+template<class T> ALWAYS_INLINE void CPUCore<T>::profileInstruction()
+{
+	if (unlikely(profiler != nullptr)) {
+		unsigned pc = getPC();
+		profiler->instruction(interface->getSelectedSlot(pc >> 14), pc,
+		                      T::getTotalTicks());
+	}
+}
+
+// Same as above, but for recording an instruction trace. The registers are
+// recorded as they are right before the instruction is executed.
+template<class T> ALWAYS_INLINE void CPUCore<T>::traceInstruction()
+{
+	if (unlikely(traceBuffer != nullptr)) {
+		traceInstruction_slow();
+	}
+}
+template<class T> void CPUCore<T>::traceInstruction_slow()
+{
+	auto& e = traceBuffer->next();
+	unsigned pc = getPC();
+	e.time = T::getTimeFast();
+	e.pc = pc;
+	e.af = getAF(); e.bc = getBC(); e.de = getDE(); e.hl = getHL();
+	e.ix = getIX(); e.iy = getIY(); e.sp = getSP();
+	const byte* line = readCacheLine[pc >> CacheLine::BITS];
+	if (likely(line && ((pc & CacheLine::LOW) <= (CacheLine::SIZE - 4)))) {
+		memcpy(e.opcode, &line[pc], 4);
+	} else {
+		for (unsigned i = 0; i < 4; ++i) {
+			e.opcode[i] = interface->peekMem(word(pc + i), e.time);
+		}
+	}
+}
+
 template<class T>
 void CPUCore<T>::executeInstructions()
 {
@@ -912,6 +993,8 @@ void CPUCore<T>::executeInstructions()
 	T::add(ii.cycles); \
 	T::R800Refresh(*this); \
 	if (likely(!T::limitReached())) { \
+		profileInstruction(); \
+		traceInstruction(); \
 		incR(1); \
 		unsigned address = getPC(); \
 		const byte* line = readCacheLine[address >> CacheLine::BITS]; \
@@ -976,6 +1059,8 @@ void CPUCore<T>::executeInstructions()
 #ifndef USE_COMPUTED_GOTO
 start:
 #endif
+	profileInstruction();
+	traceInstruction();
 	unsigned ixy; // for dd_cb/fd_cb
 	byte opcodeMain = RDMEM_OPCODE<0>(T::CC_MAIN);
 	incR(1);
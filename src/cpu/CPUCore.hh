@@ -17,6 +17,8 @@
 namespace openmsx {
 
 class MSXCPUInterface;
+class CPUProfiler;
+class CPUTraceBuffer;
 class Scheduler;
 class MSXMotherBoard;
 class TclCallback;
@@ -50,6 +52,12 @@ public:
 
 	void setInterface(MSXCPUInterface* interf) { interface = interf; }
 
+	/** Start (non-null) or stop (nullptr) collecting a profile. */
+	void setProfiler(CPUProfiler* profiler);
+
+	/** Start (non-null) or stop (nullptr) recording executed instructions. */
+	void setTraceBuffer(CPUTraceBuffer* traceBuffer);
+
 	/**
 	 * Reset the CPU.
 	 */
@@ -127,6 +135,10 @@ private:
 	byte* writeCacheLine[CacheLine::NUM];
 	bool readCacheTried [CacheLine::NUM];
 	bool writeCacheTried[CacheLine::NUM];
+	// Lines that are only uncacheable because they contain watchpoints.
+	// The bytes without a watchpoint are accessed directly via these.
+	const byte* readWatchLine[CacheLine::NUM];
+	byte* writeWatchLine[CacheLine::NUM];
 
 	MSXMotherBoard& motherboard;
 	Scheduler& scheduler;
@@ -159,10 +171,19 @@ private:
 	/** In sync with traceSetting.getBoolean(). */
 	bool tracingEnabled;
 
+	/** Only non-null while profiling. */
+	CPUProfiler* profiler;
+
+	/** Only non-null while recording an instruction trace. */
+	CPUTraceBuffer* traceBuffer;
+
 	/** 'normal' Z80 and Z80 in a turboR behave slightly different */
 	const bool isTurboR;
 
 
+	inline void profileInstruction();
+	inline void traceInstruction();
+	void traceInstruction_slow();
 	inline void cpuTracePre();
 	inline void cpuTracePost();
 	void cpuTracePost_slow();
@@ -0,0 +1,57 @@
+#include "CPUProfiler.hh"
+#include <iomanip>
+#include <ostream>
+
+namespace openmsx {
+
+CPUProfiler::CPUProfiler()
+	: last(&dummy)
+	, dummy()
+	, lastTicks(0)
+{
+}
+
+CPUProfiler::~CPUProfiler() = default;
+
+CPUProfiler::Entry* CPUProfiler::allocate(unsigned slot)
+{
+	slots[slot].reset(new Entry[NUM_ADDRESSES]()); // zero-initialized
+	return slots[slot].get();
+}
+
+void CPUProfiler::clear()
+{
+	for (auto& s : slots) s.reset();
+	skipCycles();
+}
+
+void CPUProfiler::writeHeader(std::ostream& os)
+{
+	os << "# callgrind format\n"
+	      "version: 1\n"
+	      "creator: openMSX\n"
+	      "positions: instr\n"
+	      "events: Instructions Cycles\n";
+}
+
+void CPUProfiler::write(std::ostream& os, string_view name) const
+{
+	auto flags = os.flags();
+	for (unsigned slot = 0; slot < NUM_SLOTS; ++slot) {
+		const Entry* entries = slots[slot].get();
+		if (!entries) continue;
+		os << "\nob=" << name
+		   << "\nfl=slot " << (slot / 4) << '-' << (slot % 4)
+		   << "\nfn=slot " << (slot / 4) << '-' << (slot % 4) << '\n';
+		for (unsigned addr = 0; addr < NUM_ADDRESSES; ++addr) {
+			const Entry& e = entries[addr];
+			if (e.count == 0) continue;
+			os << "0x" << std::hex << std::setw(4) << std::setfill('0')
+			   << addr << std::dec << ' ' << e.count << ' ' << e.cycles
+			   << '\n';
+		}
+	}
+	os.flags(flags);
+}
+
+} // namespace openmsx
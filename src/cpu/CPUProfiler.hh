@@ -0,0 +1,79 @@
+#ifndef CPUPROFILER_HH
+#define CPUPROFILER_HH
+
+#include "string_view.hh"
+#include "likely.hh"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+
+namespace openmsx {
+
+/** Collects an execution profile of the emulated CPU.
+  *
+  * For every instruction address (per slot) this counts how often an
+  * instruction was executed there and how many CPU cycles were spent in those
+  * instructions (including e.g. memory wait states and the time spent in
+  * HALT). The cycles between two instructions are attributed to the first of
+  * the two.
+  *
+  * The result can be written in the callgrind format (e.g. for KCachegrind).
+  */
+class CPUProfiler
+{
+public:
+	CPUProfiler(const CPUProfiler&) = delete;
+	CPUProfiler& operator=(const CPUProfiler&) = delete;
+
+	CPUProfiler();
+	~CPUProfiler();
+
+	/** Called at the start of every instruction.
+	  * @param slot Slot selected in the page of 'address' (4 * ps + ss).
+	  * @param address The address of the instruction.
+	  * @param ticks The current time in (CPU specific) clock ticks.
+	  */
+	inline void instruction(unsigned slot, unsigned address, uint64_t ticks)
+	{
+		last->cycles += ticks - lastTicks;
+		lastTicks = ticks;
+		Entry* entries = slots[slot].get();
+		if (unlikely(!entries)) entries = allocate(slot);
+		last = &entries[address];
+		++last->count;
+	}
+
+	/** Don't attribute the cycles till the next instruction to the
+	  * previous instruction, e.g. because the time jumped. */
+	void skipCycles() { last = &dummy; }
+
+	/** Forget the collected profile. */
+	void clear();
+
+	/** Write the profile in callgrind format.
+	  * @param os Output stream.
+	  * @param name Name of the CPU, used as object name ('ob=...'). */
+	void write(std::ostream& os, string_view name) const;
+
+	/** Write the callgrind header (must be written once before the output
+	  * of one or more write() calls). */
+	static void writeHeader(std::ostream& os);
+
+private:
+	struct Entry {
+		uint64_t count;
+		uint64_t cycles;
+	};
+	Entry* allocate(unsigned slot);
+
+	static const unsigned NUM_SLOTS = 16;
+	static const unsigned NUM_ADDRESSES = 0x10000;
+	std::unique_ptr<Entry[]> slots[NUM_SLOTS]; // allocated on first use
+	Entry* last; // entry of the previous instruction
+	Entry dummy;
+	uint64_t lastTicks;
+};
+
+} // namespace openmsx
+
+#endif
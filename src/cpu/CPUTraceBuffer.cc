@@ -0,0 +1,57 @@
+#include "CPUTraceBuffer.hh"
+#include "Dasm.hh"
+#include "Math.hh"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+namespace openmsx {
+
+CPUTraceBuffer::CPUTraceBuffer(unsigned size)
+	: entries(Math::powerOfTwo(std::max(size, 1u)),
+	          Entry{EmuTime::zero, 0, 0, 0, 0, 0, 0, 0, 0, {0, 0, 0, 0}})
+	, count(0)
+	, mask(unsigned(entries.size()) - 1)
+{
+}
+
+unsigned CPUTraceBuffer::size() const
+{
+	return unsigned(std::min<uint64_t>(count, capacity()));
+}
+
+const CPUTraceBuffer::Entry& CPUTraceBuffer::operator[](unsigned n) const
+{
+	assert(n < size());
+	return entries[(count - size() + n) & mask];
+}
+
+void CPUTraceBuffer::write(std::ostream& os, unsigned num) const
+{
+	auto flags = os.flags();
+	auto fill = os.fill('0');
+	unsigned sz = size();
+	std::string dasmOutput;
+	for (unsigned i = sz - std::min(num, sz); i < sz; ++i) {
+		const Entry& e = (*this)[i];
+		dasmOutput.clear();
+		dasm(e.opcode, e.pc, dasmOutput);
+		os << std::dec << e.time << ' '
+		   << std::hex << std::setw(4) << e.pc
+		   << " : " << dasmOutput
+		   << " AF=" << std::setw(4) << e.af
+		   << " BC=" << std::setw(4) << e.bc
+		   << " DE=" << std::setw(4) << e.de
+		   << " HL=" << std::setw(4) << e.hl
+		   << " IX=" << std::setw(4) << e.ix
+		   << " IY=" << std::setw(4) << e.iy
+		   << " SP=" << std::setw(4) << e.sp
+		   << '\n';
+	}
+	os.fill(fill);
+	os.flags(flags);
+}
+
+} // namespace openmsx
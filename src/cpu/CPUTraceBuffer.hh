@@ -0,0 +1,74 @@
+#ifndef CPUTRACEBUFFER_HH
+#define CPUTRACEBUFFER_HH
+
+#include "EmuTime.hh"
+#include "openmsx.hh"
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace openmsx {
+
+/** Remembers the last N executed CPU instructions.
+  *
+  * For every instruction the address, the opcode bytes, the main registers
+  * (as they were right before the instruction was executed) and the time are
+  * stored in a fixed-size ring buffer. Recording is cheap (no disassembly, no
+  * I/O, no memory allocation), the disassembly is only done when the buffer
+  * is written out (see write()).
+  *
+  * Both recording and writing happen in the emulation thread, so no locking
+  * is needed.
+  */
+class CPUTraceBuffer
+{
+public:
+	struct Entry {
+		EmuTime time;
+		word pc, af, bc, de, hl, ix, iy, sp;
+		byte opcode[4];
+	};
+
+	CPUTraceBuffer(const CPUTraceBuffer&) = delete;
+	CPUTraceBuffer& operator=(const CPUTraceBuffer&) = delete;
+
+	/** @param size Number of instructions to remember, rounded up to a
+	  *             power of 2. */
+	explicit CPUTraceBuffer(unsigned size);
+
+	/** Get the entry for a new instruction (overwrites the oldest entry
+	  * when the buffer is full). The caller must fill in all fields. */
+	inline Entry& next()
+	{
+		return entries[count++ & mask];
+	}
+
+	/** Capacity of the buffer. */
+	unsigned capacity() const { return mask + 1; }
+
+	/** Number of instructions currently in the buffer. */
+	unsigned size() const;
+
+	/** Total number of recorded instructions (including the ones that
+	  * are already overwritten). */
+	uint64_t getTotal() const { return count; }
+
+	/** Forget all recorded instructions. */
+	void clear() { count = 0; }
+
+	/** Get the n-th oldest entry still in the buffer, 0 <= n < size(). */
+	const Entry& operator[](unsigned n) const;
+
+	/** Disassemble the last (at most) 'num' instructions, one line per
+	  * instruction, oldest first. */
+	void write(std::ostream& os, unsigned num) const;
+
+private:
+	std::vector<Entry> entries;
+	uint64_t count;
+	const unsigned mask;
+};
+
+} // namespace openmsx
+
+#endif
@@ -9,11 +9,21 @@ namespace openmsx {
 
 class MSXCPUInterface;
 
+/** Disassemble
+  * @param opcode The bytes that form this opcode (max 4, the bytes beyond
+  *               the actual opcode length are ignored)
+  * @param pc The address of the opcode (needed for relative jumps)
+  * @param dest String representation of the disassembled opcode
+  * @return Length of the disassembled opcode in bytes
+  */
+unsigned dasm(const byte opcode[4], word pc, std::string& dest);
+
 /** Disassemble
   * @param interf The CPU interface, used to peek bytes from memory
   * @param pc The position (program counter) where to start disassembling
-  * @param buf The bytes that form this opcode (max 4). The buffer is only
-  *            filled with the min required bytes (see return value)
+  * @param buf The bytes that form this opcode (max 4). The buffer is
+  *            always filled with 4 bytes, see return value for the
+  *            actual length
   * @param dest String representation of the disassembled opcode
   * @param time TODO
   * @return Length of the disassembled opcode in bytes
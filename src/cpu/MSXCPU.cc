@@ -4,6 +4,8 @@
 #include "Scheduler.hh"
 #include "IntegerSetting.hh"
 #include "CPUCore.hh"
+#include "CPUProfiler.hh"
+#include "CPUTraceBuffer.hh"
 #include "Z80.hh"
 #include "R800.hh"
 #include "TclObject.hh"
@@ -42,6 +44,8 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 		: nullptr)
 	, debuggable(motherboard_)
 	, reference(EmuTime::zero)
+	, profiling(false)
+	, tracing(false)
 {
 	z80Active = true; // setActiveCPU(CPU_Z80);
 	newZ80Active = z80Active;
@@ -209,6 +213,55 @@ CPURegs& MSXCPU::getRegisters()
 	}
 }
 
+void MSXCPU::startProfiling()
+{
+	if (!z80Profiler) z80Profiler = make_unique<CPUProfiler>();
+	z80Profiler->clear();
+	z80->setProfiler(z80Profiler.get());
+	if (r800) {
+		if (!r800Profiler) r800Profiler = make_unique<CPUProfiler>();
+		r800Profiler->clear();
+		r800->setProfiler(r800Profiler.get());
+	}
+	profiling = true;
+}
+
+void MSXCPU::stopProfiling()
+{
+	          z80 ->setProfiler(nullptr);
+	if (r800) r800->setProfiler(nullptr);
+	profiling = false;
+}
+
+void MSXCPU::writeProfile(std::ostream& os) const
+{
+	// Z80 and R800 cycles have a different duration, so keep them
+	// separated.
+	CPUProfiler::writeHeader(os);
+	if (z80Profiler)  z80Profiler ->write(os, "z80");
+	if (r800Profiler) r800Profiler->write(os, "r800");
+}
+
+void MSXCPU::startTracing(unsigned size)
+{
+	traceBuffer = make_unique<CPUTraceBuffer>(size);
+	          z80 ->setTraceBuffer(traceBuffer.get());
+	if (r800) r800->setTraceBuffer(traceBuffer.get());
+	tracing = true;
+}
+
+void MSXCPU::stopTracing()
+{
+	          z80 ->setTraceBuffer(nullptr);
+	if (r800) r800->setTraceBuffer(nullptr);
+	tracing = false;
+}
+
+void MSXCPU::writeTrace(std::ostream& os, unsigned num) const
+{
+	if (traceBuffer) traceBuffer->write(os, num);
+}
+
 void MSXCPU::update(const Setting& setting)
 {
 	          z80 ->update(setting);
@@ -10,6 +10,7 @@
 #include "serialize_meta.hh"
 #include "openmsx.hh"
 #include "array_ref.hh"
+#include <iosfwd>
 #include <memory>
 
 namespace openmsx {
@@ -18,6 +19,8 @@ class MSXMotherBoard;
 class MSXCPUInterface;
 class CPUClock;
 class CPURegs;
+class CPUProfiler;
+class CPUTraceBuffer;
 class Z80TYPE;
 class R800TYPE;
 template <typename T> class CPUCore;
@@ -115,6 +118,23 @@ public:
 
 	CPURegs& getRegisters();
 
+	/** Start collecting a new execution profile (see CPUProfiler). */
+	void startProfiling();
+	/** Stop collecting, the profile collected so far is kept. */
+	void stopProfiling();
+	bool isProfiling() const { return profiling; }
+	/** Write the collected profile in callgrind format. */
+	void writeProfile(std::ostream& os) const;
+
+	/** Start recording the last 'size' executed instructions (see
+	  * CPUTraceBuffer), a previously recorded trace is discarded. */
+	void startTracing(unsigned size);
+	/** Stop recording, the trace recorded so far is kept. */
+	void stopTracing();
+	bool isTracing() const { return tracing; }
+	/** Write (at most) the last 'num' recorded instructions. */
+	void writeTrace(std::ostream& os, unsigned num) const;
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -165,9 +185,17 @@ private:
 		void write(unsigned address, byte value) override;
 	} debuggable;
 
+	// Created on first use, kept after profiling stops.
+	std::unique_ptr<CPUProfiler> z80Profiler;
+	std::unique_ptr<CPUProfiler> r800Profiler;
+	// Shared by Z80 and R800, only one of them is active at a time.
+	std::unique_ptr<CPUTraceBuffer> traceBuffer;
+
 	EmuTime reference;
 	bool z80Active;
 	bool newZ80Active;
+	bool profiling;
+	bool tracing;
 };
 SERIALIZE_CLASS_VERSION(MSXCPU, 2);
 
@@ -50,12 +50,6 @@ static std::unique_ptr<ReadOnlySetting> breakedSetting;
 static unsigned breakedSettingCount = 0;
 
 
-// Bitfields used in the disallowReadCache and disallowWriteCache arrays
-static const byte SECONDARY_SLOT_BIT = 0x01;
-static const byte MEMORY_WATCH_BIT   = 0x02;
-static const byte GLOBAL_RW_BIT      = 0x04;
-
-
 MSXCPUInterface::MSXCPUInterface(MSXMotherBoard& motherBoard_)
 	: memoryDebug       (motherBoard_)
 	, slottedMemoryDebug(motherBoard_)
@@ -751,6 +745,17 @@ void MSXCPUInterface::checkBreakPoints(
 	          BreakPoints::const_iterator> range,
 	MSXMotherBoard& motherBoard)
 {
+	// Usually (when there are no breakpoints on this address) this is
+	// called to evaluate the conditions after every instruction. Skip all
+	// the work below when all conditions are natively compiled and false.
+	auto isFalse = [&](const DebugCondition& c) {
+		return c.isCertainlyFalse(motherBoard);
+	};
+	if ((range.first == range.second) &&
+	    all_of(begin(conditions), end(conditions), isFalse)) {
+		return;
+	}
+
 	// create copy for the case that breakpoint/condition removes itself
 	//  - keeps object alive by holding a shared_ptr to it
 	//  - avoids iterating over a changing collection
@@ -758,11 +763,11 @@ void MSXCPUInterface::checkBreakPoints(
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	for (auto& p : bpCopy) {
-		p.checkAndExecute(globalCliComm, interp);
+		p.checkAndExecute(globalCliComm, interp, motherBoard);
 	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		c.checkAndExecute(globalCliComm, interp);
+		c.checkAndExecute(globalCliComm, interp, motherBoard);
 	}
 }
 
@@ -915,7 +920,7 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		if ((w->getBeginAddress() <= address) &&
 		    (w->getEndAddress()   >= address) &&
 		    (w->getType()         == type)) {
-			w->checkAndExecute(globalCliComm, interp);
+			w->checkAndExecute(globalCliComm, interp, motherBoard);
 		}
 	}
 
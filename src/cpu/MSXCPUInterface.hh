@@ -183,6 +183,42 @@ public:
 		return visibleDevices[start >> 14]->getWriteCacheLine(start);
 	}
 
+	/**
+	 * Like getReadCacheLine(), but for a region that is only uncacheable
+	 * because it contains read watchpoints. The CPU may then still read
+	 * the bytes without a watchpoint directly from the returned buffer
+	 * (see isReadWatched()). Returns a null pointer if the region has no
+	 * watchpoints or if it's also uncacheable for some other reason.
+	 */
+	inline const byte* getReadCacheLineIgnoreWatch(word start) const {
+		if (disallowReadCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+			return nullptr;
+		}
+		return visibleDevices[start >> 14]->getReadCacheLine(start);
+	}
+
+	/**
+	 * Same as getReadCacheLineIgnoreWatch(), but for writing.
+	 */
+	inline byte* getWriteCacheLineIgnoreWatch(word start) const {
+		if (disallowWriteCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+			return nullptr;
+		}
+		return visibleDevices[start >> 14]->getWriteCacheLine(start);
+	}
+
+	/** Is there a read watchpoint on the given address? */
+	inline bool isReadWatched(word address) const {
+		return readWatchSet[address >> CacheLine::BITS]
+		                   [address &  CacheLine::LOW];
+	}
+
+	/** Is there a write watchpoint on the given address? */
+	inline bool isWriteWatched(word address) const {
+		return writeWatchSet[address >> CacheLine::BITS]
+		                    [address &  CacheLine::LOW];
+	}
+
 	/**
 	 * CPU uses this method to read 'extra' data from the databus
 	 * used in interrupt routines. In MSX this returns always 255.
@@ -211,6 +247,12 @@ public:
 	inline bool isExpanded(int ps) const { return expanded[ps] != 0; }
 	void changeExpanded(bool isExpanded);
 
+	/** The slot that is selected in the given page, as 4 * ps + ss.
+	  * (The secondary slot is always 0 for non-expanded slots.) */
+	unsigned getSelectedSlot(int page) const {
+		return 4 * primarySlotState[page] + secondarySlotState[page];
+	}
+
 	DummyDevice& getDummyDevice() { return *dummyDevice; }
 
 	static void insertBreakPoint(const BreakPoint& bp);
@@ -374,6 +416,11 @@ private:
 
 	std::unique_ptr<VDPIODelay> delayDevice; // can be nullptr
 
+	// Bitfields used in the disallowReadCache and disallowWriteCache arrays
+	static const byte SECONDARY_SLOT_BIT = 0x01;
+	static const byte MEMORY_WATCH_BIT   = 0x02;
+	static const byte GLOBAL_RW_BIT      = 0x04;
+
 	byte disallowReadCache [CacheLine::NUM];
 	byte disallowWriteCache[CacheLine::NUM];
 	std::bitset<CacheLine::SIZE> readWatchSet [CacheLine::NUM];
@@ -0,0 +1,415 @@
+#include "NativeCondition.hh"
+#include "CommandException.hh"
+#include "unreachable.hh"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+
+using std::string;
+
+namespace openmsx {
+
+// Indices in the "CPU regs" debuggable, see share/scripts/_cpuregs.tcl.
+struct RegInfo {
+	const char* name;
+	byte index;
+	bool word;
+};
+static const RegInfo regInfos[] = {
+	{"A",    0, false}, {"F",    1, false}, {"B",    2, false}, {"C",    3, false},
+	{"D",    4, false}, {"E",    5, false}, {"H",    6, false}, {"L",    7, false},
+	{"A2",   8, false}, {"F2",   9, false}, {"B2",  10, false}, {"C2",  11, false},
+	{"D2",  12, false}, {"E2",  13, false}, {"H2",  14, false}, {"L2",  15, false},
+	{"IXH", 16, false}, {"IXL", 17, false}, {"IYH", 18, false}, {"IYL", 19, false},
+	{"PCH", 20, false}, {"PCL", 21, false}, {"SPH", 22, false}, {"SPL", 23, false},
+	{"I",   24, false}, {"R",   25, false}, {"IM",  26, false}, {"IFF", 27, false},
+	{"AF",   0, true }, {"BC",   2, true }, {"DE",   4, true }, {"HL",   6, true },
+	{"AF2",  8, true }, {"BC2", 10, true }, {"DE2", 12, true }, {"HL2", 14, true },
+	{"IX",  16, true }, {"IY",  18, true }, {"PC",  20, true }, {"SP",  22, true },
+};
+
+static const char* const CPU_REGS = "CPU regs";
+
+// Parses (a subset of) the Tcl expression syntax, see NativeCondition.hh.
+// All parse functions return false when they encounter something that is not
+// supported (or invalid), the caller then falls back to Tcl, which will also
+// report syntax errors.
+class NativeCondition::Parser
+{
+public:
+	Parser(NativeCondition& cond_, string_view str_)
+		: cond(cond_), str(str_), pos(0) {}
+
+	bool parse()
+	{
+		unsigned root;
+		if (!parseBinary(0, root)) return false;
+		skipSpace();
+		return pos == str.size();
+	}
+
+private:
+	// A word in a Tcl command: either a literal or a nested command.
+	struct Word {
+		string text;
+		unsigned node; // only valid if 'isCommand'
+		bool isCommand;
+	};
+
+	char peekChar(size_t offset = 0) const
+	{
+		return ((pos + offset) < str.size()) ? str[pos + offset] : '\0';
+	}
+	static bool isSpace(char c)
+	{
+		return isspace(static_cast<unsigned char>(c)) != 0;
+	}
+	void skipSpace()
+	{
+		while (isSpace(peekChar())) ++pos;
+	}
+
+	unsigned add(Op op, unsigned a = 0, unsigned b = 0, int64_t value = 0)
+	{
+		cond.nodes.push_back({op, a, b, value});
+		return unsigned(cond.nodes.size() - 1);
+	}
+	unsigned addRead(const string& debuggable, unsigned addr)
+	{
+		auto& names = cond.names;
+		auto it = find(begin(names), end(names), debuggable);
+		auto idx = it - begin(names);
+		if (it == end(names)) names.push_back(debuggable);
+		return add(READ, addr, 0, idx);
+	}
+	unsigned addRead16(const string& debuggable, unsigned addr, bool bigEndian)
+	{
+		unsigned lo = addRead(debuggable, addr);
+		unsigned hi = addRead(debuggable, add(ADD, addr, add(NUMBER, 0, 0, 1)));
+		if (bigEndian) std::swap(lo, hi);
+		return add(ADD, lo, add(MUL, hi, add(NUMBER, 0, 0, 256)));
+	}
+
+	// Operators grouped per precedence level, lowest first.
+	static const int NUM_LEVELS = 9;
+	bool matchOperator(int level, Op& op, size_t& len) const
+	{
+		char c0 = peekChar(0);
+		char c1 = peekChar(1);
+		len = 1;
+		switch (level) {
+		case 0: op = OR;  len = 2; return (c0 == '|') && (c1 == '|');
+		case 1: op = AND; len = 2; return (c0 == '&') && (c1 == '&');
+		case 2: op = BITOR;  return (c0 == '|') && (c1 != '|');
+		case 3: op = BITXOR; return c0 == '^';
+		case 4: op = BITAND; return (c0 == '&') && (c1 != '&');
+		case 5:
+			len = 2;
+			if ((c0 == '=') && (c1 == '=')) { op = EQ; return true; }
+			if ((c0 == '!') && (c1 == '=')) { op = NE; return true; }
+			return false;
+		case 6:
+			if ((c0 == '<') && (c1 == '=')) { op = LE; len = 2; return true; }
+			if ((c0 == '>') && (c1 == '=')) { op = GE; len = 2; return true; }
+			// '<<' and '>>' (shifts) are not supported
+			if ((c0 == '<') && (c1 != '<')) { op = LT; return true; }
+			if ((c0 == '>') && (c1 != '>')) { op = GT; return true; }
+			return false;
+		case 7:
+			if (c0 == '+') { op = ADD; return true; }
+			if (c0 == '-') { op = SUB; return true; }
+			return false;
+		case 8: op = MUL; return (c0 == '*') && (c1 != '*'); // no '**'
+		default: UNREACHABLE; return false;
+		}
+	}
+
+	bool parseBinary(int level, unsigned& result)
+	{
+		if (level == NUM_LEVELS) return parseUnary(result);
+		if (!parseBinary(level + 1, result)) return false;
+		while (true) {
+			skipSpace();
+			Op op; size_t len;
+			if (!matchOperator(level, op, len)) return true;
+			pos += len;
+			unsigned rhs;
+			if (!parseBinary(level + 1, rhs)) return false;
+			result = add(op, result, rhs);
+		}
+	}
+
+	bool parseUnary(unsigned& result)
+	{
+		skipSpace();
+		Op op;
+		switch (peekChar()) {
+		case '!': op = NOT;    break;
+		case '~': op = BITNOT; break;
+		case '-': op = NEG;    break;
+		case '+': ++pos; return parseUnary(result);
+		default:  return parsePrimary(result);
+		}
+		++pos;
+		unsigned operand;
+		if (!parseUnary(operand)) return false;
+		result = add(op, operand);
+		return true;
+	}
+
+	bool parsePrimary(unsigned& result)
+	{
+		char c = peekChar();
+		if (c == '(') {
+			++pos;
+			if (!parseBinary(0, result)) return false;
+			skipSpace();
+			if (peekChar() != ')') return false;
+			++pos;
+			return true;
+		} else if (c == '[') {
+			++pos;
+			return parseCommand(result);
+		} else if (('0' <= c) && (c <= '9')) {
+			int64_t value;
+			if (!parseNumber(value)) return false;
+			result = add(NUMBER, 0, 0, value);
+			return true;
+		}
+		return false;
+	}
+
+	// Tcl integer syntax: decimal, 0x.., 0o.. or 0b... Octal numbers
+	// without '0o' prefix (e.g. '017') are not supported, their meaning
+	// depends on the Tcl version.
+	bool parseNumber(int64_t& result)
+	{
+		unsigned base = 10;
+		if (peekChar() == '0') {
+			char p = char(tolower(peekChar(1)));
+			if      (p == 'x') { base = 16; pos += 2; }
+			else if (p == 'o') { base =  8; pos += 2; }
+			else if (p == 'b') { base =  2; pos += 2; }
+			else if (('0' <= p) && (p <= '9')) return false;
+		}
+		result = 0;
+		size_t start = pos;
+		while (true) {
+			char c = char(tolower(peekChar()));
+			unsigned digit;
+			if      (('0' <= c) && (c <= '9')) digit = c - '0';
+			else if (('a' <= c) && (c <= 'z')) digit = c - 'a' + 10;
+			else break;
+			if (digit >= base) return false; // also e.g. '1e3'
+			result = result * base + digit;
+			if (result >= (int64_t(1) << 48)) return false;
+			++pos;
+		}
+		if (pos == start) return false;
+		char c = peekChar();
+		return (c != '.') && (c != '_');
+	}
+
+	bool parseCommand(unsigned& result)
+	{
+		std::vector<Word> words;
+		while (true) {
+			while ((peekChar() == ' ') || (peekChar() == '\t')) ++pos;
+			char c = peekChar();
+			if (c == ']') { ++pos; break; }
+			Word w;
+			w.isCommand = false;
+			if (c == '[') {
+				++pos;
+				if (!parseCommand(w.node)) return false;
+				w.isCommand = true;
+			} else if ((c == '{') || (c == '"')) {
+				char close = (c == '{') ? '}' : '"';
+				auto len = str.substr(pos + 1).find(close);
+				if (len == string_view::npos) return false;
+				w.text = str.substr(pos + 1, len).str();
+				if (w.text.find_first_of("{$[\\") != string::npos) {
+					return false;
+				}
+				pos += len + 2;
+			} else {
+				while (true) {
+					char d = peekChar();
+					if ((d == '\0') || isSpace(d) || (d == ']')) break;
+					if ((d == '$') || (d == '[') || (d == '\\') ||
+					    (d == '{') || (d == '"') || (d == ';')) {
+						return false;
+					}
+					w.text += d;
+					++pos;
+				}
+			}
+			// The next word must be separated by a space.
+			char n = peekChar();
+			if ((n != ' ') && (n != '\t') && (n != ']')) return false;
+			words.push_back(std::move(w));
+		}
+		if (words.empty() || words[0].isCommand) return false;
+		return compileCommand(words, result);
+	}
+
+	bool getValue(const Word& arg, unsigned& result)
+	{
+		if (arg.isCommand) {
+			result = arg.node;
+			return true;
+		}
+		Parser sub(cond, arg.text);
+		int64_t value;
+		if (arg.text.empty() || !sub.parseNumber(value) ||
+		    (sub.pos != arg.text.size())) {
+			return false;
+		}
+		result = add(NUMBER, 0, 0, value);
+		return true;
+	}
+
+	bool getSlot(const Word& arg, int64_t& result, bool allowX)
+	{
+		if (arg.isCommand) return false;
+		if (allowX && (arg.text == "X")) {
+			result = -1;
+			return true;
+		}
+		if ((arg.text.size() != 1) ||
+		    (arg.text[0] < '0') || (arg.text[0] > '3')) {
+			return false;
+		}
+		result = arg.text[0] - '0';
+		return true;
+	}
+
+	bool compileCommand(const std::vector<Word>& words, unsigned& result)
+	{
+		const string& cmd = words[0].text;
+		auto size = words.size();
+		if (cmd == "reg") {
+			if ((size != 2) || words[1].isCommand) return false;
+			string name = words[1].text;
+			for (auto& c : name) c = char(toupper(c));
+			for (auto& info : regInfos) {
+				if (name != info.name) continue;
+				unsigned index = add(NUMBER, 0, 0, info.index);
+				result = info.word ? addRead16(CPU_REGS, index, true)
+				                   : addRead  (CPU_REGS, index);
+				return true;
+			}
+			return false;
+		} else if ((cmd == "peek")   || (cmd == "peek8") ||
+		           (cmd == "peek_u8") ||
+		           (cmd == "peek16") || (cmd == "peek_u16")) {
+			if ((size != 2) && (size != 3)) return false;
+			unsigned addr;
+			if (!getValue(words[1], addr)) return false;
+			string debuggable = "memory";
+			if (size == 3) {
+				if (words[2].isCommand) return false;
+				debuggable = words[2].text;
+			}
+			result = (cmd.find("16") != string::npos)
+			       ? addRead16(debuggable, addr, false)
+			       : addRead  (debuggable, addr);
+			return true;
+		} else if (cmd == "debug") {
+			if ((size != 4) || words[1].isCommand ||
+			    (words[1].text != "read") || words[2].isCommand) {
+				return false;
+			}
+			unsigned addr;
+			if (!getValue(words[3], addr)) return false;
+			result = addRead(words[2].text, addr);
+			return true;
+		} else if (cmd == "pc_in_slot") {
+			if ((size != 2) && (size != 3)) return false;
+			int64_t ps, ss = -1;
+			if (!getSlot(words[1], ps, false)) return false;
+			if ((size == 3) && !getSlot(words[2], ss, true)) return false;
+			result = add(PC_IN_SLOT, 0, unsigned(ss), ps);
+			return true;
+		}
+		return false;
+	}
+
+	NativeCondition& cond;
+	string_view str;
+	size_t pos;
+};
+
+bool NativeCondition::compile(string_view expression)
+{
+	nodes.clear();
+	names.clear();
+	Parser parser(*this, expression);
+	if (!parser.parse()) {
+		nodes.clear();
+		names.clear();
+		return false;
+	}
+	return true;
+}
+
+bool NativeCondition::eval(Reader& reader) const
+{
+	assert(!nodes.empty());
+	return eval(reader, unsigned(nodes.size() - 1)) != 0;
+}
+
+int64_t NativeCondition::eval(Reader& reader, unsigned n) const
+{
+	const Node& node = nodes[n];
+	auto a = [&] { return eval(reader, node.a); };
+	auto b = [&] { return eval(reader, node.b); };
+	switch (node.op) {
+	case NUMBER:
+		return node.value;
+	case READ: {
+		int64_t address = a();
+		if ((address < 0) || (address > 0xFFFFFFFF)) {
+			throw CommandException("Invalid address");
+		}
+		return reader.read(names[node.value], unsigned(address));
+	}
+	case PC_IN_SLOT: {
+		// Same as the pc_in_slot proc in share/scripts/_slot.tcl
+		// (but without support for the mapper block argument).
+		unsigned pc = 256 * reader.read(CPU_REGS, 20) +
+		                    reader.read(CPU_REGS, 21);
+		unsigned page = pc >> 14;
+		int ps = (reader.read("ioports", 0xA8) >> (2 * page)) & 3;
+		if (ps != node.value) return 0;
+		int ss = int(node.b);
+		if ((ss != -1) && reader.isExpanded(ps)) {
+			byte reg = reader.read("slotted memory",
+			                       0x40000 * ps + 0xFFFF);
+			if ((((reg ^ 255) >> (2 * page)) & 3) != ss) return 0;
+		}
+		return 1;
+	}
+	// Avoid signed overflow (undefined behaviour) in these operations.
+	case NEG:    return int64_t(0 - uint64_t(a()));
+	case MUL:    return int64_t(uint64_t(a()) * uint64_t(b()));
+	case ADD:    return int64_t(uint64_t(a()) + uint64_t(b()));
+	case SUB:    return int64_t(uint64_t(a()) - uint64_t(b()));
+	case NOT:    return !a();
+	case BITNOT: return ~a();
+	case LT:     return a() <  b();
+	case LE:     return a() <= b();
+	case GT:     return a() >  b();
+	case GE:     return a() >= b();
+	case EQ:     return a() == b();
+	case NE:     return a() != b();
+	case BITAND: return a() &  b();
+	case BITXOR: return a() ^  b();
+	case BITOR:  return a() |  b();
+	case AND:    return a() && b();
+	case OR:     return a() || b();
+	default:     UNREACHABLE; return 0;
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,81 @@
+#ifndef NATIVECONDITION_HH
+#define NATIVECONDITION_HH
+
+#include "openmsx.hh"
+#include "string_view.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** A breakpoint/watchpoint/debug condition compiled to a native expression
+  * tree.
+  *
+  * Conditions are Tcl expressions. Evaluating them via the Tcl interpreter
+  * after every emulated instruction is very slow. Most conditions are simple
+  * though, e.g. '[reg A] == 5 && [peek 0xC000] != 0'. Such conditions are
+  * compiled (once) to an expression tree that can be evaluated without Tcl.
+  *
+  * Supported are integer literals, the operators ! ~ - (unary) * + - < <=
+  * > >= == != & ^ | && || (with Tcl precedence), parentheses and these
+  * commands (with constant or nested-command arguments):
+  *   reg <name>
+  *   peek <addr> [<debuggable>]   (also peek8, peek_u8)
+  *   peek16 <addr> [<debuggable>] (also peek_u16)
+  *   debug read <debuggable> <addr>
+  *   pc_in_slot <ps> [<ss>]
+  * Those commands are evaluated with the same meaning as the corresponding
+  * procs in share/scripts (redefining those procs is not detected). Anything
+  * else (e.g. variables, string comparisons, other commands) makes
+  * compile() fail, then the condition must be evaluated via Tcl.
+  */
+class NativeCondition
+{
+public:
+	/** Access to the state of the emulated machine. */
+	class Reader
+	{
+	public:
+		/** Like 'debug read <name> <address>'.
+		  * @throws CommandException for unknown debuggables or
+		  *         addresses out of range. */
+		virtual byte read(string_view debuggable, unsigned address) = 0;
+		/** Like 'machine_info issubslotted <ps>'. */
+		virtual bool isExpanded(int ps) = 0;
+	protected:
+		~Reader() {}
+	};
+
+	/** Try to compile the given Tcl expression.
+	  * @return false if the expression uses unsupported constructs. */
+	bool compile(string_view expression);
+
+	/** Evaluate the compiled expression (compile() must have succeeded).
+	  * @throws CommandException, e.g. when reading an invalid address. */
+	bool eval(Reader& reader) const;
+
+private:
+	enum Op : uint8_t {
+		NUMBER, READ, PC_IN_SLOT,
+		NOT, BITNOT, NEG,
+		MUL, ADD, SUB, LT, LE, GT, GE, EQ, NE,
+		BITAND, BITXOR, BITOR, AND, OR,
+	};
+	struct Node {
+		Op op;
+		unsigned a, b; // operands, indices in 'nodes'
+		int64_t value; // NUMBER: the value, READ: index in 'names',
+		               // PC_IN_SLOT: primary slot (secondary in 'b')
+	};
+
+	int64_t eval(Reader& reader, unsigned n) const;
+
+	std::vector<Node> nodes; // the root is the last node
+	std::vector<std::string> names; // debuggable names
+	class Parser;
+};
+
+} // namespace openmsx
+
+#endif
@@ -10,12 +10,16 @@
 #include "MSXWatchIODevice.hh"
 #include "TclObject.hh"
 #include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
 #include "MemBuffer.hh"
 #include "KeyRange.hh"
+#include "sha1.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "memory.hh"
 #include <cassert>
+#include <fstream>
 #include <stdexcept>
 
 using std::shared_ptr;
@@ -70,6 +74,31 @@ Debuggable& Debugger::getDebuggable(string_view name)
 	return *result;
 }
 
+Sha1Sum Debugger::calcStateHash()
+{
+	std::vector<std::pair<string_view, Debuggable*>> sorted;
+	for (auto& p : debuggables) {
+		sorted.emplace_back(p.first, p.second);
+	}
+	sort(begin(sorted), end(sorted), LessTupleElement<0>());
+
+	SHA1 sha1;
+	std::vector<uint8_t> buf;
+	for (auto& p : sorted) {
+		// add a zero byte to separate the name from the content
+		sha1.update(reinterpret_cast<const uint8_t*>(p.first.data()),
+		            p.first.size());
+		sha1.update(reinterpret_cast<const uint8_t*>(""), 1);
+		auto& debuggable = *p.second;
+		buf.resize(debuggable.getSize());
+		for (unsigned i = 0; i < buf.size(); ++i) {
+			buf[i] = debuggable.read(i);
+		}
+		sha1.update(buf.data(), buf.size());
+	}
+	return sha1.digest();
+}
+
 void Debugger::registerProbe(ProbeBase& probe)
 {
 	assert(!probes.contains(probe.getName()));
@@ -271,6 +300,10 @@ void Debugger::Cmd::execute(
 		listConditions(tokens, result);
 	} else if (subCmd == "probe") {
 		probe(tokens, result);
+	} else if (subCmd == "profile") {
+		profile(tokens, result);
+	} else if (subCmd == "trace") {
+		trace(tokens, result);
 	} else {
 		throw SyntaxError();
 	}
@@ -754,6 +787,88 @@ void Debugger::Cmd::probeListBreakPoints(
 	result.setString(res);
 }
 
+void Debugger::Cmd::profile(array_ref<TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 3) {
+		throw CommandException("Missing argument");
+	}
+	auto& cpu = *debugger().cpu;
+	string_view subCmd = tokens[2].getString();
+	if (subCmd == "start") {
+		cpu.startProfiling();
+	} else if (subCmd == "stop") {
+		cpu.stopProfiling();
+	} else if (subCmd == "status") {
+		result.setInt(cpu.isProfiling());
+	} else if (subCmd == "dump") {
+		if (tokens.size() != 4) {
+			throw SyntaxError();
+		}
+		string filename = FileOperations::expandTilde(
+			tokens[3].getString().str());
+		std::ofstream file;
+		FileOperations::openofstream(file, filename);
+		if (!file.is_open()) {
+			throw CommandException("Couldn't open file: ", filename);
+		}
+		cpu.writeProfile(file);
+		if (file.fail()) {
+			throw CommandException("Error writing file: ", filename);
+		}
+	} else {
+		throw SyntaxError();
+	}
+}
+
+void Debugger::Cmd::trace(array_ref<TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 3) {
+		throw CommandException("Missing argument");
+	}
+	auto& cpu = *debugger().cpu;
+	auto& interp = getInterpreter();
+	string_view subCmd = tokens[2].getString();
+	if (subCmd == "start") {
+		if (tokens.size() > 4) {
+			throw SyntaxError();
+		}
+		int size = (tokens.size() == 4) ? tokens[3].getInt(interp) : 65536;
+		if ((size <= 0) || (size > (1 << 24))) {
+			throw CommandException("Invalid size: ", size);
+		}
+		cpu.startTracing(size);
+	} else if (subCmd == "stop") {
+		cpu.stopTracing();
+	} else if (subCmd == "status") {
+		result.setInt(cpu.isTracing());
+	} else if (subCmd == "dump") {
+		if ((tokens.size() != 4) && (tokens.size() != 5)) {
+			throw SyntaxError();
+		}
+		unsigned num = unsigned(-1);
+		if (tokens.size() == 5) {
+			int n = tokens[4].getInt(interp);
+			if (n < 0) {
+				throw CommandException("Invalid count: ", n);
+			}
+			num = n;
+		}
+		string filename = FileOperations::expandTilde(
+			tokens[3].getString().str());
+		std::ofstream file;
+		FileOperations::openofstream(file, filename);
+		if (!file.is_open()) {
+			throw CommandException("Couldn't open file: ", filename);
+		}
+		cpu.writeTrace(file, num);
+		if (file.fail()) {
+			throw CommandException("Error writing file: ", filename);
+		}
+	} else {
+		throw SyntaxError();
+	}
+}
+
 string Debugger::Cmd::help(const vector<string>& tokens) const
 {
 	static const string generalHelp =
@@ -776,6 +891,8 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    remove_condition  remove a certain condition\n"
 		"    list_conditions   list the active conditions\n"
 		"    probe             probe related subcommands\n"
+		"    profile           profile the emulated CPU\n"
+		"    trace             record the last executed instructions\n"
 		"    cont              continue execution after break\n"
 		"    step              execute one instruction\n"
 		"    break             break CPU at current position\n"
@@ -914,6 +1031,34 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		"    set_bp <probe> [<cond>] [<cmd>]  set a breakpoint on the given probe\n"
 		"    remove_bp <id>                   remove the given breakpoint\n"
 		"    list_bp                          returns a list of breakpoints that are set on probes\n";
+	static const string profileHelp =
+		"debug profile <subcommand> [<arguments>]\n"
+		"  Count, for every instruction address, how often it was "
+		"executed and how many CPU cycles were spent there. This has only "
+		"a small impact on the emulation speed.\n"
+		"  Possible subcommands are:\n"
+		"    start              start a new profile\n"
+		"    stop               stop profiling (the profile is kept)\n"
+		"    status             returns '1' while profiling, '0' otherwise\n"
+		"    dump <filename>    write the profile to a file in callgrind "
+		"format (e.g. for KCachegrind)\n";
+	static const string traceHelp =
+		"debug trace <subcommand> [<arguments>]\n"
+		"  Record the last executed instructions (address, opcode, "
+		"registers before the instruction and emulation time) in a "
+		"fixed-size buffer. Only raw data is recorded, it's disassembled "
+		"when the trace is dumped. So this is a lot faster than the "
+		"'cputrace' setting.\n"
+		"  Possible subcommands are:\n"
+		"    start [<size>]          start recording (the last <size> "
+		"instructions, default 65536), discards the previous trace\n"
+		"    stop                    stop recording (the trace is kept)\n"
+		"    status                  returns '1' while recording, '0' "
+		"otherwise\n"
+		"    dump <filename> [<num>] write (the last <num> instructions "
+		"of) the trace to a file\n"
+		"  To get the instructions leading up to a breakpoint, use e.g.:\n"
+		"    debug set_bp 0x1234 {} {debug trace dump trace.txt 1000}\n";
 	static const string contHelp =
 		"debug cont\n"
 		"  Continue execution after CPU was breaked.\n";
@@ -979,6 +1124,10 @@ string Debugger::Cmd::help(const vector<string>& tokens) const
 		return listCondHelp;
 	} else if (tokens[1] == "probe") {
 		return probeHelp;
+	} else if (tokens[1] == "profile") {
+		return profileHelp;
+	} else if (tokens[1] == "trace") {
+		return traceHelp;
 	} else if (tokens[1] == "cont") {
 		return contHelp;
 	} else if (tokens[1] == "step") {
@@ -1035,7 +1184,7 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 	static const char* const otherCmds[] = {
 		"disasm", "set_bp", "remove_bp", "set_watchpoint",
 		"remove_watchpoint", "set_condition", "remove_condition",
-		"probe",
+		"probe", "profile", "trace",
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -1073,6 +1222,16 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 					"remove_bp", "list_bp",
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "profile") {
+				static const char* const subCmds[] = {
+					"start", "stop", "status", "dump",
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "trace") {
+				static const char* const subCmds[] = {
+					"start", "stop", "status", "dump",
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -1085,6 +1244,9 @@ void Debugger::Cmd::tabCompletion(vector<string>& tokens) const
 				probeNames.emplace_back(p->getName());
 			}
 			completeString(tokens, probeNames);
+		} else if (((tokens[1] == "profile") || (tokens[1] == "trace")) &&
+		           (tokens[2] == "dump")) {
+			completeFileName(tokens, userFileContext());
 		}
 		break;
 	}
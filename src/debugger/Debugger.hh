@@ -18,6 +18,7 @@ class Debuggable;
 class ProbeBase;
 class ProbeBreakPoint;
 class MSXCPU;
+class Sha1Sum;
 
 class Debugger
 {
@@ -41,6 +42,12 @@ public:
 
 	void transfer(Debugger& other);
 
+	/** Calculate a SHA1 sum over the content of all debuggables (in
+	  * alphabetical order of their name). Two machines with the same
+	  * hash are (very likely) in the same state.
+	  */
+	Sha1Sum calcStateHash();
+
 	MSXMotherBoard& getMotherBoard() { return motherBoard; }
 
 private:
@@ -99,6 +106,8 @@ private:
 		void probeSetBreakPoint(array_ref<TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(array_ref<TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(array_ref<TclObject> tokens, TclObject& result);
+		void profile(array_ref<TclObject> tokens, TclObject& result);
+		void trace(array_ref<TclObject> tokens, TclObject& result);
 	} cmd;
 
 	struct NameFromProbe {
@@ -30,10 +30,11 @@ ProbeBreakPoint::~ProbeBreakPoint()
 
 void ProbeBreakPoint::update(const ProbeBase& /*subject*/)
 {
-	auto& reactor = debugger.getMotherBoard().getReactor();
+	auto& motherBoard = debugger.getMotherBoard();
+	auto& reactor = motherBoard.getReactor();
 	auto& cliComm = reactor.getGlobalCliComm();
 	auto& interp  = reactor.getInterpreter();
-	checkAndExecute(cliComm, interp);
+	checkAndExecute(cliComm, interp, motherBoard);
 }
 
 void ProbeBreakPoint::subjectDeleted(const ProbeBase& /*subject*/)
@@ -4,6 +4,7 @@
 #include "RTScheduler.hh"
 #include "Interpreter.hh"
 #include "InputEventGenerator.hh"
+#include "TclCallback.hh"
 #include "Thread.hh"
 #include "KeyRange.hh"
 #include "stl.hh"
@@ -82,8 +83,16 @@ void EventDistributor::deliverEvents()
 	reactor.getInputEventGenerator().poll();
 	reactor.getInterpreter().poll();
 	reactor.getRTScheduler().execute();
+	TclCallback::executeDeferred();
 
 	std::unique_lock<std::mutex> lock(mutex);
+	if (!scheduledEvents.empty()) {
+		// Listeners may access any machine, including the ones that
+		// are running in a background thread.
+		lock.unlock();
+		reactor.stopBackgroundBoards();
+		lock.lock();
+	}
 	// It's possible that executing an event triggers scheduling of another
 	// event. We also want to execute those secondary events. That's why
 	// we have this while loop here.
@@ -1,23 +1,38 @@
 #include "MSXCliComm.hh"
 #include "GlobalCliComm.hh"
 #include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "Thread.hh"
 
 namespace openmsx {
 
 MSXCliComm::MSXCliComm(MSXMotherBoard& motherBoard_, GlobalCliComm& cliComm_)
-	: motherBoard(motherBoard_)
+	: RTSchedulable(motherBoard_.getReactor().getRTScheduler())
+	, motherBoard(motherBoard_)
 	, cliComm(cliComm_)
 {
 }
 
 void MSXCliComm::log(LogLevel level, string_view message)
 {
+	if (!Thread::isMainThread()) {
+		std::lock_guard<std::mutex> lock(deferredMutex);
+		deferred.push_back(Deferred{true, level, LED, message.str(), {}});
+		if (deferred.size() == 1) scheduleRT(0);
+		return;
+	}
 	cliComm.log(level, message);
 }
 
 void MSXCliComm::update(UpdateType type, string_view name, string_view value)
 {
 	assert(type < NUM_UPDATES);
+	if (!Thread::isMainThread()) {
+		std::lock_guard<std::mutex> lock(deferredMutex);
+		deferred.push_back(Deferred{false, INFO, type, name.str(), value.str()});
+		if (deferred.size() == 1) scheduleRT(0);
+		return;
+	}
 	auto it = prevValues[type].find(name);
 	if (it != end(prevValues[type])) {
 		if (it->second == value) {
@@ -30,4 +45,20 @@ void MSXCliComm::update(UpdateType type, string_view name, string_view value)
 	cliComm.updateHelper(type, motherBoard.getMachineID(), name, value);
 }
 
+void MSXCliComm::executeRT()
+{
+	std::vector<Deferred> copy;
+	{
+		std::lock_guard<std::mutex> lock(deferredMutex);
+		swap(copy, deferred);
+	}
+	for (auto& d : copy) {
+		if (d.isLog) {
+			log(d.level, d.name);
+		} else {
+			update(d.type, d.name, d.value);
+		}
+	}
+}
+
 } // namespace openmsx
@@ -2,15 +2,19 @@
 #define MSXCLICOMM_HH
 
 #include "CliComm.hh"
+#include "RTSchedulable.hh"
 #include "hash_map.hh"
 #include "xxhash.hh"
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class GlobalCliComm;
 
-class MSXCliComm final : public CliComm
+class MSXCliComm final : public CliComm, private RTSchedulable
 {
 public:
 	MSXCliComm(MSXMotherBoard& motherBoard, GlobalCliComm& cliComm);
@@ -20,9 +24,23 @@ public:
 	            string_view value) override;
 
 private:
+	// Messages from a non-main thread are queued and delivered later by
+	// the main thread (see Thread::setEmulationThread()).
+	void executeRT() override;
+
+	struct Deferred {
+		bool isLog;
+		LogLevel level;
+		UpdateType type;
+		std::string name; // or message
+		std::string value;
+	};
+
 	MSXMotherBoard& motherBoard;
 	GlobalCliComm& cliComm;
 	hash_map<std::string, std::string, XXHasher> prevValues[NUM_UPDATES];
+	std::vector<Deferred> deferred;
+	std::mutex deferredMutex;
 };
 
 } // namespace openmsx
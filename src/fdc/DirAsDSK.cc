@@ -265,6 +265,8 @@ DirAsDSK::DirAsDSK(DiskChanger& diskChanger_, CliComm& cliComm_,
 	, hostDir(hostDir_.getResolved() + '/')
 	, syncMode(syncMode_)
 	, lastAccess(EmuTime::zero)
+	, watcher(hostDir)
+	, needFullSync(true)
 	, nofSectors((diskChanger_.isDoubleSidedDrive() ? 2 : 1) * SECTORS_PER_TRACK * NUM_TRACKS)
 	, nofSectorsPerFat((((3 * nofSectors) / (2 * SECTORS_PER_CLUSTER)) + SECTOR_SIZE - 1) / SECTOR_SIZE)
 	, firstSector2ndFAT(FIRST_FAT_SECTOR + nofSectorsPerFat)
@@ -341,7 +343,7 @@ void DirAsDSK::checkCaches()
 		// Happens when dirasdisk is used in virtual_drive.
 		needSync = true;
 	}
-	if (needSync) {
+	if (needSync && watcher.hasChanges()) {
 		flushCaches();
 	}
 }
@@ -365,8 +367,7 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 			// Happens when dirasdisk is used in virtual_drive.
 			needSync = true;
 		}
-		if (needSync) {
-			syncWithHost();
+		if (needSync && syncWithHost()) {
 			flushCaches(); // e.g. sha1sum
 			// Let the diskdrive report the disk has been ejected.
 			// E.g. a turbor machine uses this to flush its
@@ -379,8 +380,16 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 	memcpy(&buf, &sectors[sector], sizeof(buf));
 }
 
-void DirAsDSK::syncWithHost()
+bool DirAsDSK::syncWithHost()
 {
+	// If we know which host files changed, only look at those. Returns
+	// false if the virtual disk is certainly unchanged.
+	if (!needFullSync && watcher.getChanges(changedHostFiles)) {
+		if (changedHostFiles.empty()) return false;
+		return syncChangedHostFiles(changedHostFiles);
+	}
+	needFullSync = false;
+
 	// Check for removed host files. This frees up space in the virtual
 	// disk. Do this first because otherwise later actions may fail (run
 	// out of virtual disk space) for no good reason.
@@ -394,6 +403,76 @@ void DirAsDSK::syncWithHost()
 
 	// Last add new host files (this can only consume virtual disk space).
 	addNewHostFiles({}, firstDirSector);
+	return true;
+}
+
+bool DirAsDSK::syncChangedHostFiles(const vector<string>& changed)
+{
+	// Same steps as a full sync (see above), but only for the given host
+	// files. Changes in (sub)directories are not reported by the watcher,
+	// those always trigger a full sync.
+	for (auto& hostName : changed) {
+		DirIndex dirIndex = findHostFileInDSK(hostName);
+		if (dirIndex.sector == unsigned(-1)) continue;
+		bool isMSXDirectory = (msxDir(dirIndex).attrib &
+		                       MSXDirEntry::ATT_DIRECTORY) != 0;
+		FileOperations::Stat fst;
+		if ((!FileOperations::getStat(hostDir + hostName, fst)) ||
+		    (FileOperations::isDirectory(fst) != isMSXDirectory)) {
+			deleteMSXFile(dirIndex);
+		}
+	}
+	for (auto& hostName : changed) {
+		DirIndex dirIndex = findHostFileInDSK(hostName);
+		if (dirIndex.sector == unsigned(-1)) continue;
+		FileOperations::Stat fst;
+		if (!FileOperations::getStat(hostDir + hostName, fst)) continue;
+		MapDir& mapDir = mapDirs[dirIndex];
+		if ((mapDir.mtime    != fst.st_mtime) ||
+		    (mapDir.filesize != size_t(fst.st_size))) {
+			importHostFile(dirIndex, fst);
+		}
+	}
+	for (auto& hostName : changed) {
+		string_view hostSubDir, fileName;
+		StringOp::splitOnLast(hostName, '/', hostSubDir, fileName);
+		if (StringOp::startsWith(fileName, '.')) continue; // hidden file
+		if (checkFileUsedInDSK(hostName)) continue;
+
+		string fullHostName = hostDir + hostName;
+		FileOperations::Stat fst;
+		if (!FileOperations::getStat(fullHostName, fst)) {
+			continue; // created and removed again
+		}
+		unsigned msxDirSector = firstDirSector;
+		if (!hostSubDir.empty()) {
+			DirIndex dirIndex = findHostFileInDSK(hostSubDir.str());
+			if (dirIndex.sector == unsigned(-1)) {
+				// Parent directory is not (yet) on the virtual
+				// disk, e.g. because the disk is full.
+				needFullSync = true;
+				continue;
+			}
+			msxDirSector = clusterToSector(
+				msxDir(dirIndex).startCluster);
+		}
+		try {
+			if (!FileOperations::isRegularFile(fst)) {
+				throw MSXException("Not a regular file: ", fullHostName);
+			}
+			string subDir = hostSubDir.empty() ? string{}
+			                                   : strCat(hostSubDir, '/');
+			addNewHostFile(subDir, fileName.str(), msxDirSector, fst);
+		} catch (MSXException& e) {
+			cliComm.printWarning(e.getMessage());
+		}
+		if (!checkFileUsedInDSK(hostName)) {
+			// Retry (and warn again) in the next (full) sync, just
+			// like the polling sync does.
+			needFullSync = true;
+		}
+	}
+	return true;
 }
 
 void DirAsDSK::checkDeletedHostFiles()
@@ -4,8 +4,11 @@
 #include "SectorBasedDisk.hh"
 #include "DiskImageUtils.hh"
 #include "FileOperations.hh"
+#include "HostDirWatcher.hh"
 #include "EmuTime.hh"
 #include <map>
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
@@ -61,7 +64,8 @@ private:
 	void writeDataSector(unsigned sector, const SectorBuffer& buf);
 	void writeDIREntry(DirIndex dirIndex, DirIndex dirDirIndex,
 	                   const MSXDirEntry& newEntry);
-	void syncWithHost();
+	bool syncWithHost();
+	bool syncChangedHostFiles(const std::vector<std::string>& changed);
 	void checkDeletedHostFiles();
 	void deleteMSXFile(DirIndex dirIndex);
 	void deleteMSXFilesInDir(unsigned msxDirSector);
@@ -121,6 +125,11 @@ private:
 
 	EmuTime lastAccess; // last time there was a sector read/write
 
+	// Tells which host files changed since the last sync (if supported).
+	HostDirWatcher watcher;
+	std::vector<std::string> changedHostFiles; // avoid reallocations
+	bool needFullSync; // e.g. a new host file could not be added
+
 	// For each directory entry that has a mapped host file/directory we
 	// store the name, last modification time and size of the corresponding
 	// host file/dir.
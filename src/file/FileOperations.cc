@@ -17,6 +17,7 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <climits>
+#include <cstdio>
 #include <unistd.h>
 #endif // ifdef _WIN32_ ... else ...
 
@@ -282,6 +283,17 @@ int unlink(const std::string& path)
 #endif
 }
 
+int rename(const std::string& oldPath, const std::string& newPath)
+{
+#ifdef _WIN32
+	// _wrename() fails when the destination already exists
+	_wunlink(utf8to16(newPath).c_str());
+	return _wrename(utf8to16(oldPath).c_str(), utf8to16(newPath).c_str());
+#else
+	return ::rename(oldPath.c_str(), newPath.c_str());
+#endif
+}
+
 int rmdir(const std::string& path)
 {
 #ifdef _WIN32
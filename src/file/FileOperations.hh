@@ -56,6 +56,13 @@ namespace FileOperations {
 	 */
 	int unlink(const std::string& path);
 
+	/**
+	 * Call rename() in a platform-independent manner. On systems where
+	 * rename() is atomic, other processes either see the old or the new
+	 * file under 'newPath'.
+	 */
+	int rename(const std::string& oldPath, const std::string& newPath);
+
 	/**
 	 * Call rmdir() in a platform-independent manner
 	 */
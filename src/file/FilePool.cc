@@ -13,13 +13,15 @@
 #include "CliComm.hh"
 #include "Reactor.hh"
 #include "Timer.hh"
+#include "hash_map.hh"
 #include "memory.hh"
 #include "sha1.hh"
 #include "stl.hh"
-#include <fstream>
+#include "xxhash.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
-using std::ifstream;
-using std::ofstream;
 using std::string;
 using std::vector;
 
@@ -37,7 +39,47 @@ private:
 };
 
 
-const char* const FILE_CACHE = "/.filecache";
+const uint64_t FilePool::UNKNOWN_SIZE;
+
+const char* const FILE_CACHE = "/.filecache"; // old text format, only read
+const char* const FILE_INDEX = "/.filepool.idx";
+
+// The index file starts with this header, followed by 'numEntries'
+// IndexEntry structs (sorted on sha1sum) and 'stringSize' bytes of
+// (zero-terminated) filenames. All values are stored in native byte order.
+static const char INDEX_MAGIC[8] = { 'o', 'p', 'e', 'n', 'M', 'S', 'X', 'P' };
+static const uint32_t INDEX_VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct IndexHeader {
+	char magic[8];
+	uint32_t byteOrder;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t stringSize;
+};
+
+struct FilePool::IndexEntry {
+	PoolEntry toPoolEntry(const char* strings) const {
+		return PoolEntry(sum, time_t(time), size, strings + filename);
+	}
+
+	Sha1Sum sum;
+	uint32_t filename; // offset in the string table
+	int64_t time;
+	uint64_t size;
+};
+static_assert(sizeof(IndexHeader) == 24, "must not contain padding");
+
+// Compares PoolEntry, IndexEntry and Sha1Sum objects on sha1sum.
+static const Sha1Sum& getSum(const Sha1Sum& sum) { return sum; }
+template<typename Entry> static const Sha1Sum& getSum(const Entry& e) { return e.sum; }
+struct CompareSum {
+	template<typename X, typename Y>
+	bool operator()(const X& x, const Y& y) const {
+		return getSum(x) < getSum(y);
+	}
+};
 
 static string initialFilePoolSettingValue()
 {
@@ -68,16 +110,25 @@ FilePool::FilePool(CommandController& controller, Reactor& reactor_)
 		"instead use the 'filepool' command.",
 		initialFilePoolSettingValue())
 	, reactor(reactor_)
+	, index(nullptr)
+	, indexStrings(nullptr)
+	, indexSize(0)
+	, indexLoaded(false)
 	, quit(false)
+	, needWrite(false)
 {
 	filePoolSetting.attach(*this);
 	reactor.getEventDistributor().registerEventListener(OPENMSX_QUIT_EVENT, *this);
-	try {
-		readSha1sums();
-	} catch (MSXException&) {
-		// ignore, probably .filecache doesn't exist yet
+	if (!readIndex()) {
+		indexLoaded = true;
+		try {
+			// convert the .filecache of older openMSX versions
+			readSha1sums();
+			needWrite = true;
+		} catch (MSXException&) {
+			// ignore, probably .filecache doesn't exist yet
+		}
 	}
-	needWrite = false;
 
 	sha1SumCommand = make_unique<Sha1SumCommand>(controller, *this);
 }
@@ -85,23 +136,31 @@ FilePool::FilePool(CommandController& controller, Reactor& reactor_)
 FilePool::~FilePool()
 {
 	if (needWrite) {
-		writeSha1sums();
+		writeIndex();
 	}
 	reactor.getEventDistributor().unregisterEventListener(OPENMSX_QUIT_EVENT, *this);
 	filePoolSetting.detach(*this);
 }
 
-void FilePool::insert(const Sha1Sum& sum, time_t time, const string& filename)
+const char* FilePool::storeString(const string& str)
+{
+	stringBuffer.push_back(str);
+	return stringBuffer.back().c_str();
+}
+
+void FilePool::insert(const Sha1Sum& sum, time_t time, uint64_t size,
+                      const string& filename)
 {
+	assert(indexLoaded);
 	auto it = upper_bound(begin(pool), end(pool), sum,
 	                      ComparePool());
-	stringBuffer.push_back(filename);
-	pool.emplace(it, sum, time, stringBuffer.back().c_str());
+	pool.emplace(it, sum, time, size, storeString(filename));
 	needWrite = true;
 }
 
 void FilePool::remove(Pool::iterator it)
 {
+	assert(indexLoaded);
 	pool.erase(it);
 	needWrite = true;
 }
@@ -113,6 +172,7 @@ void FilePool::remove(Pool::iterator it)
 // Returns true  if the new position is after          the old position.
 bool FilePool::adjust(Pool::iterator it, const Sha1Sum& newSum)
 {
+	assert(indexLoaded);
 	needWrite = true;
 	auto newIt = upper_bound(begin(pool), end(pool), newSum,
 	                         ComparePool());
@@ -134,18 +194,11 @@ bool FilePool::adjust(Pool::iterator it, const Sha1Sum& newSum)
 	}
 }
 
-time_t FilePool::PoolEntry::getTime()
+uint64_t FilePool::getFileSize(const string& filename)
 {
-	if (time == time_t(-1)) {
-		time = Date::fromString(timeStr);
-	}
-	return time;
-}
-
-void FilePool::PoolEntry::setTime(time_t t)
-{
-	time = t;
-	timeStr = nullptr;
+	FileOperations::Stat st;
+	return FileOperations::getStat(filename, st) ? uint64_t(st.st_size)
+	                                             : UNKNOWN_SIZE;
 }
 
 static bool parse(char* line, char* line_end,
@@ -179,6 +232,70 @@ static bool parse(char* line, char* line_end,
 	return true;
 }
 
+bool FilePool::readIndex()
+{
+	assert(!indexFile.is_open());
+	try {
+		indexFile = File(FileOperations::getUserDataDir() + FILE_INDEX, "rb");
+		size_t size;
+		const byte* data = indexFile.mmap(size);
+
+		IndexHeader header;
+		if (size < sizeof(header)) throw MSXException("Index too small");
+		memcpy(&header, data, sizeof(header));
+		size_t entriesSize = size_t(header.numEntries) * sizeof(IndexEntry);
+		if ((memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) ||
+		    (header.byteOrder != BYTE_ORDER_MARK) ||
+		    (header.version != INDEX_VERSION) ||
+		    (size != (sizeof(header) + entriesSize + header.stringSize))) {
+			throw MSXException("Invalid index");
+		}
+		auto* entries = reinterpret_cast<const IndexEntry*>(
+			data + sizeof(header));
+		auto* strings = reinterpret_cast<const char*>(
+			data + sizeof(header) + entriesSize);
+
+		// Only some quick sanity checks, so that a corrupt file can't
+		// crash openMSX. The entries themselves are not parsed.
+		if ((header.stringSize != 0) &&
+		    (strings[header.stringSize - 1] != '\0')) {
+			throw MSXException("Invalid index");
+		}
+		for (unsigned i = 0; i < header.numEntries; ++i) {
+			if (entries[i].filename >= header.stringSize) {
+				throw MSXException("Invalid index");
+			}
+		}
+		if (!std::is_sorted(entries, entries + header.numEntries,
+		                    CompareSum())) {
+			throw MSXException("Invalid index");
+		}
+
+		index = entries;
+		indexStrings = strings;
+		indexSize = header.numEntries;
+		return true;
+	} catch (MSXException&) {
+		// ignore, index doesn't exist (yet) or is corrupt
+		indexFile.close();
+		return false;
+	}
+}
+
+// Copy all entries from the (read-only) index to 'pool', so that they can
+// be modified.
+void FilePool::loadIndex()
+{
+	if (indexLoaded) return;
+	indexLoaded = true;
+
+	assert(pool.empty());
+	pool.reserve(indexSize);
+	for (unsigned i = 0; i < indexSize; ++i) {
+		pool.push_back(index[i].toPoolEntry(indexStrings));
+	}
+}
+
 void FilePool::readSha1sums()
 {
 	assert(pool.empty());
@@ -204,7 +321,11 @@ void FilePool::readSha1sums()
 		const char* timeStr;
 		const char* filename;
 		if (parse(data, it, sum, timeStr, filename)) {
-			pool.emplace_back(sum, timeStr, filename);
+			time_t time = Date::fromString(timeStr);
+			if (time != time_t(-1)) {
+				// this format didn't store the file size
+				pool.emplace_back(sum, time, UNKNOWN_SIZE, filename);
+			}
 		}
 
 		data = std::find_if(it + 1, data_end, [](byte c) {
@@ -221,23 +342,41 @@ void FilePool::readSha1sums()
 	}
 }
 
-void FilePool::writeSha1sums()
+void FilePool::writeIndex()
 {
-	string cacheFile = FileOperations::getUserDataDir() + FILE_CACHE;
-	ofstream file;
-	FileOperations::openofstream(file, cacheFile);
-	if (!file.is_open()) {
-		return;
-	}
+	assert(indexLoaded);
+
+	// First build the complete content, some filenames may still point
+	// into the (mmap'ed) old index.
+	std::vector<IndexEntry> entries;
+	entries.reserve(pool.size());
+	string strings;
 	for (auto& p : pool) {
-		file << p.sum.toString() << "  ";
-		if (p.timeStr) {
-			file << p.timeStr;
-		} else {
-			assert(p.time != time_t(-1));
-			file << Date::toString(p.time);
-		}
-		file << "  " << p.filename << '\n';
+		IndexEntry e;
+		e.sum = p.sum;
+		e.filename = uint32_t(strings.size());
+		e.time = p.time;
+		e.size = p.size;
+		entries.push_back(e);
+		strings += p.filename;
+		strings += '\0';
+	}
+	IndexHeader header;
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = INDEX_VERSION;
+	header.numEntries = uint32_t(entries.size());
+	header.stringSize = uint32_t(strings.size());
+
+	indexFile.close();
+	try {
+		File file(FileOperations::getUserDataDir() + FILE_INDEX,
+		          File::SAVE_PERSISTENT);
+		file.write(&header, sizeof(header));
+		file.write(entries.data(), entries.size() * sizeof(IndexEntry));
+		file.write(strings.data(), strings.size());
+	} catch (FileException&) {
+		// ignore, the index is only a cache
 	}
 }
 
@@ -312,7 +451,10 @@ FilePool::Directories FilePool::getDirectories() const
 
 File FilePool::getFile(FileType fileType, const Sha1Sum& sha1sum)
 {
-	File result = getFromPool(sha1sum);
+	File result = getFromIndex(sha1sum);
+	if (result.is_open()) return result;
+
+	result = getFromPool(sha1sum);
 	if (result.is_open()) return result;
 
 	// not found in cache, need to scan directories
@@ -383,8 +525,35 @@ static Sha1Sum calcSha1sum(File& file, Reactor& reactor)
 	return sha1.digest();
 }
 
+// Try to find the file directly in the (not yet loaded) index. This only
+// succeeds if the file is still up to date, otherwise getFromPool() has to
+// update the pool.
+File FilePool::getFromIndex(const Sha1Sum& sha1sum)
+{
+	if (indexLoaded) return File();
+
+	auto bound = std::equal_range(index, index + indexSize, sha1sum,
+	                              CompareSum());
+	for (auto* e = bound.first; e != bound.second; ++e) {
+		auto entry = e->toPoolEntry(indexStrings);
+		FileOperations::Stat st;
+		if (FileOperations::getStat(entry.filename, st) &&
+		    entry.upToDate(FileOperations::getModificationDate(st),
+		                   uint64_t(st.st_size))) {
+			try {
+				return File(entry.filename);
+			} catch (FileException&) {
+				// handled in getFromPool()
+			}
+		}
+	}
+	return File();
+}
+
 File FilePool::getFromPool(const Sha1Sum& sha1sum)
 {
+	loadIndex();
+
 	auto bound = equal_range(begin(pool), end(pool), sha1sum,
 	                         ComparePool());
 	// use indices instead of iterators
@@ -392,23 +561,18 @@ File FilePool::getFromPool(const Sha1Sum& sha1sum)
 	auto last = distance(begin(pool), bound.second);
 	while (i != last) {
 		auto it = begin(pool) + i;
-		if (it->getTime() == time_t(-1)) {
-			// Invalid time/date format. Remove from
-			// database and continue searching.
-			remove(it);
-			--last;
-			continue;
-		}
 		try {
 			File file(it->filename);
 			auto newTime = file.getModificationDate();
-			if (it->time == newTime) {
+			auto newSize = getFileSize(it->filename);
+			if (it->upToDate(newTime, newSize)) {
 				// When modification time is unchanged, assume
 				// sha1sum is also unchanged. So avoid
 				// expensive sha1sum calculation.
 				return file;
 			}
-			it->setTime(newTime); // update timestamp
+			it->time = newTime; // update timestamp
+			it->size = newSize;
 			needWrite = true;
 			auto newSum = calcSha1sum(file, reactor);
 			if (newSum == sha1sum) {
@@ -438,98 +602,185 @@ File FilePool::getFromPool(const Sha1Sum& sha1sum)
 File FilePool::scanDirectory(
 	const Sha1Sum& sha1sum, const string& directory, const string& poolPath,
 	ScanProgress& progress)
+{
+	std::vector<ScanFile> files;
+	if (!collectFiles(directory, files)) {
+		// Scanning can take a long time. Allow to exit openmsx when it
+		// takes too long. Stop scanning by pretending we didn't find
+		// the file.
+		return File();
+	}
+	return scanFiles(sha1sum, files, poolPath, progress);
+}
+
+// Recursively collect all regular files in the given directory. Returns
+// false when openMSX is exiting.
+bool FilePool::collectFiles(const string& directory, std::vector<ScanFile>& files)
 {
 	ReadDir dir(directory);
 	while (dirent* d = dir.getEntry()) {
-		if (quit) {
-			// Scanning can take a long time. Allow to exit
-			// openmsx when it takes too long. Stop scanning
-			// by pretending we didn't find the file.
-			return File();
-		}
+		// deliverEvents() is relatively cheap when there are no events
+		// to deliver, so it's ok to call on each file.
+		reactor.getEventDistributor().deliverEvents();
+		if (quit) return false;
+
 		string file = d->d_name;
 		string path = strCat(directory, '/', file);
 		FileOperations::Stat st;
 		if (FileOperations::getStat(path, st)) {
-			File result;
 			if (FileOperations::isRegularFile(st)) {
-				result = scanFile(sha1sum, path, st, poolPath, progress);
+				files.push_back({std::move(path),
+				                 FileOperations::getModificationDate(st),
+				                 uint64_t(st.st_size)});
 			} else if (FileOperations::isDirectory(st)) {
 				if ((file != ".") && (file != "..")) {
-					result = scanDirectory(sha1sum, path, poolPath, progress);
+					if (!collectFiles(path, files)) return false;
 				}
 			}
-			if (result.is_open()) return result;
 		}
 	}
-	return File(); // not found
+	return true;
 }
 
-File FilePool::scanFile(const Sha1Sum& sha1sum, const string& filename,
-                        const FileOperations::Stat& st, const string& poolPath,
-                        ScanProgress& progress)
-{
-	++progress.amountScanned;
-	// Periodically send a progress message with the current filename
-	auto now = Timer::getTime();
-	if (now > (progress.lastTime + 250000)) { // 4Hz
-		progress.lastTime = now;
-		reactor.getCliComm().printProgress(
-                        "Searching for file with sha1sum ",
-			sha1sum.toString(), "...\nIndexing filepool ", poolPath,
-			": [", progress.amountScanned, "]: ",
-			string_view(filename).substr(poolPath.size()));
+// Search the given files for the given sha1sum, meanwhile add all files to
+// the pool. The sha1sums of new or modified files are calculated in parallel
+// (on 'threadPool'), but the results are processed in the same order as the
+// files were found. So the result is the same as for a sequential scan.
+File FilePool::scanFiles(const Sha1Sum& sha1sum, const std::vector<ScanFile>& files,
+                         const string& poolPath, ScanProgress& progress)
+{
+	loadIndex();
+
+	// Look up all files in the pool at once, before the pool gets modified
+	// (a findInDatabase() call per file would be quadratic).
+	struct Known {
+		bool inPool = false;
+		bool upToDate = false;
+		Sha1Sum sum;
+	};
+	std::vector<Known> known(files.size());
+	{
+		hash_map<string_view, const PoolEntry*, XXHasher> byName(pool.size());
+		for (auto& e : pool) {
+			byName[string_view(e.filename)] = &e;
+		}
+		for (size_t i = 0; i < files.size(); ++i) {
+			auto it = byName.find(string_view(files[i].path));
+			if (it == byName.end()) continue;
+			known[i].inPool = true;
+			known[i].upToDate = it->second->upToDate(
+				files[i].time, files[i].size);
+			known[i].sum = it->second->sum;
+		}
 	}
 
-	// deliverEvents() is relatively cheap when there are no events to
-	// deliver, so it's ok to call on each file.
-	reactor.getEventDistributor().deliverEvents();
-
-	auto it = findInDatabase(filename);
-	if (it == end(pool)) {
-		// not in pool
-		try {
-			File file(filename);
-			auto sum = calcSha1sum(file, reactor);
-			auto time = FileOperations::getModificationDate(st);
-			insert(sum, time, filename);
-			if (sum == sha1sum) {
-				return file;
-			}
-		} catch (FileException&) {
-			// ignore
+	auto showProgress = [&](const string& filename) {
+		// Periodically send a progress message with the current filename
+		auto now = Timer::getTime();
+		if (now > (progress.lastTime + 250000)) { // 4Hz
+			progress.lastTime = now;
+			reactor.getCliComm().printProgress(
+				"Searching for file with sha1sum ",
+				sha1sum.toString(), "...\nIndexing filepool ", poolPath,
+				": [", progress.amountScanned, "]: ",
+				string_view(filename).substr(poolPath.size()));
 		}
-	} else {
-		// already in pool
-		assert(filename == it->filename);
-		assert(it->time != time_t(-1));
-		try {
-			auto time = FileOperations::getModificationDate(st);
-			if (it->time == time) {
-				// db is still up to date
-				if (it->sum == sha1sum) {
-					return File(filename);
-				}
+	};
+
+	struct Pending {
+		size_t file; // index in 'files'
+		std::shared_future<void> done;
+		Sha1Sum sum;
+		bool ok = false;
+	};
+	std::deque<Pending> pending; // deque: push_back() keeps references valid
+	std::vector<PoolEntry> added; // new entries, merged into 'pool' at the end
+	const string* found = nullptr; // first matching file (in scan order)
+
+	auto processOldest = [&] {
+		auto& p = pending.front();
+		auto& f = files[p.file];
+		while (p.done.wait_for(std::chrono::milliseconds(100)) !=
+		       std::future_status::ready) {
+			reactor.getEventDistributor().deliverEvents();
+			showProgress(f.path);
+		}
+		if (known[p.file].inPool) {
+			// db outdated
+			auto it = findInDatabase(f.path);
+			assert(it != end(pool));
+			if (p.ok) {
+				it->time = f.time;
+				it->size = f.size;
+				adjust(it, p.sum);
 			} else {
-				// db outdated
-				File file(filename);
-				auto sum = calcSha1sum(file, reactor);
-				it->setTime(time);
-				adjust(it, sum);
-				if (sum == sha1sum) {
-					return file;
-				}
+				// error reading file, remove from db
+				remove(it);
 			}
-		} catch (FileException&) {
-			// error reading file, remove from db
-			remove(it);
+		} else if (p.ok) {
+			added.emplace_back(p.sum, f.time, f.size, storeString(f.path));
+		}
+		if (p.ok && !found && (p.sum == sha1sum)) {
+			found = &f.path;
+		}
+		pending.pop_front();
+	};
+
+	const size_t maxPending = 4 * threadPool.getMaxThreads();
+	for (size_t i = 0; (i < files.size()) && !found && !quit; ++i) {
+		auto& f = files[i];
+		++progress.amountScanned;
+		showProgress(f.path);
+		reactor.getEventDistributor().deliverEvents();
+
+		if (known[i].upToDate) {
+			// db is still up to date
+			if (known[i].sum == sha1sum) {
+				// but an earlier file might also match
+				while (!pending.empty()) processOldest();
+				if (!found) found = &f.path;
+			}
+			continue;
 		}
+
+		// not in pool or db outdated
+		if (pending.size() >= maxPending) processOldest();
+		pending.emplace_back();
+		auto& p = pending.back();
+		p.file = i;
+		p.done = threadPool.addTask([&p, &f] {
+			try {
+				File file(f.path);
+				size_t size;
+				const byte* data = file.mmap(size);
+				p.sum = SHA1::calc(data, size);
+				p.ok = true;
+			} catch (MSXException&) {
+				// error reading file
+			}
+		});
+	}
+	while (!pending.empty()) processOldest();
+
+	if (!added.empty()) {
+		// Same order for equal sha1sums as with insert().
+		std::stable_sort(begin(added), end(added), ComparePool());
+		auto middle = pool.insert(end(pool), begin(added), end(added));
+		std::inplace_merge(begin(pool), middle, end(pool), ComparePool());
+		needWrite = true;
+	}
+
+	if (!found || quit) return File(); // not found
+	try {
+		return File(*found);
+	} catch (FileException&) {
+		return File();
 	}
-	return File(); // not found
 }
 
 FilePool::Pool::iterator FilePool::findInDatabase(const string& filename)
 {
+	assert(indexLoaded);
 	// Linear search in pool for filename.
 	// Search from back to front because often, soon after this search, we
 	// will insert/remove an element from the vector. This requires
@@ -541,13 +792,6 @@ FilePool::Pool::iterator FilePool::findInDatabase(const string& filename)
 		--i;
 		auto it = begin(pool) + i;
 		if (it->filename == filename) {
-			// ensure 'time' is valid
-			if (it->getTime() == time_t(-1)) {
-				// invalid time/date format, remove from db
-				// and continue searching
-				pool.erase(it);
-				continue;
-			}
 			return it;
 		}
 	}
@@ -558,10 +802,22 @@ Sha1Sum FilePool::getSha1Sum(File& file)
 {
 	auto time = file.getModificationDate();
 	const auto& filename = file.getURL();
+	auto size = getFileSize(filename);
+
+	if (!indexLoaded) {
+		// Avoid loading the index when it's still up to date.
+		for (unsigned i = 0; i < indexSize; ++i) {
+			auto entry = index[i].toPoolEntry(indexStrings);
+			if ((entry.filename == filename) &&
+			    entry.upToDate(time, size)) {
+				return entry.sum;
+			}
+		}
+	}
 
+	loadIndex();
 	auto it = findInDatabase(filename);
-	assert((it == end(pool)) || (it->time != time_t(-1)));
-	if ((it != end(pool)) && (it->time == time)) {
+	if ((it != end(pool)) && it->upToDate(time, size)) {
 		// in database and modification time matches,
 		// assume sha1sum also matches
 		return it->sum;
@@ -571,10 +827,11 @@ Sha1Sum FilePool::getSha1Sum(File& file)
 	auto sum = calcSha1sum(file, reactor);
 	if (it == end(pool)) {
 		// was not yet in database, insert new entry
-		insert(sum, time, filename);
+		insert(sum, time, size, filename);
 	} else {
 		// was already in database, but with wrong timestamp (and sha1sum)
-		it->setTime(time);
+		it->time = time;
+		it->size = size;
 		adjust(it, sum);
 	}
 	return sum;
@@ -1,15 +1,17 @@
 #ifndef FILEPOOL_HH
 #define FILEPOOL_HH
 
+#include "File.hh"
 #include "FileOperations.hh"
 #include "StringSetting.hh"
 #include "Observer.hh"
 #include "EventListener.hh"
 #include "MemBuffer.hh"
+#include "ThreadPool.hh"
 #include "sha1.hh"
-#include <cassert>
 #include <cstdint>
 #include <ctime>
+#include <deque>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -19,7 +21,6 @@ namespace openmsx {
 
 class CommandController;
 class Reactor;
-class File;
 class Sha1SumCommand;
 
 class FilePool final : private Observer<Setting>, private EventListener
@@ -55,26 +56,24 @@ private:
 	};
 	using Directories = std::vector<Entry>;
 
+	static const uint64_t UNKNOWN_SIZE = uint64_t(-1);
 	struct PoolEntry {
-		PoolEntry(const Sha1Sum& s, time_t t, const char* f)
-			: filename(f), time(t), sum(s)
+		PoolEntry(const Sha1Sum& s, time_t t, uint64_t sz, const char* f)
+			: filename(f), time(t), size(sz), sum(s)
 		{
-			assert(time != time_t(-1));
-		}
-		PoolEntry(const Sha1Sum& s, const char* t, const char* f)
-			: filename(f), timeStr(t), sum(s)
-		{
-			assert(timeStr != nullptr);
 		}
 
-		time_t getTime();
-		void setTime(time_t t);
+		/** When the modification time and the size are unchanged,
+		  * assume the sha1sum is also unchanged.
+		  */
+		bool upToDate(time_t t, uint64_t sz) const {
+			return (time == t) && ((size == sz) || (size == UNKNOWN_SIZE));
+		}
 
-		// - At least one of 'timeStr' or 'time' is valid.
-		// - 'filename' and 'timeStr' are non-owning pointers.
+		// 'filename' is a non-owning pointer.
 		const char* filename;
-		const char* timeStr = nullptr; // might be nullptr
-		time_t time = time_t(-1);      // might be -1
+		time_t time;
+		uint64_t size; // UNKNOWN_SIZE for entries from the old .filecache
 		Sha1Sum sum;
 	};
 	struct ComparePool { // PoolEntry sorted on 'sum'
@@ -90,24 +89,40 @@ private:
 	};
 	using Pool = std::vector<PoolEntry>; // sorted with 'ComparePool'
 
-	void insert(const Sha1Sum& sum, time_t time, const std::string& filename);
+	struct IndexEntry; // on-disk format of the index, see FilePool.cc
+
+	/** A file that was found while scanning a pool directory. */
+	struct ScanFile {
+		std::string path;
+		time_t time;
+		uint64_t size;
+	};
+
+	const char* storeString(const std::string& str);
+	void insert(const Sha1Sum& sum, time_t time, uint64_t size,
+	            const std::string& filename);
 	void remove(Pool::iterator it);
 	bool adjust(Pool::iterator it, const Sha1Sum& newSum);
 
+	bool readIndex();
+	void loadIndex();
 	void readSha1sums();
-	void writeSha1sums();
+	void writeIndex();
 
+	File getFromIndex(const Sha1Sum& sha1sum);
 	File getFromPool(const Sha1Sum& sha1sum);
 	File scanDirectory(const Sha1Sum& sha1sum,
 	                   const std::string& directory,
 	                   const std::string& poolPath,
 	                   ScanProgress& progress);
-	File scanFile(const Sha1Sum& sha1sum,
-	              const std::string& filename,
-	              const FileOperations::Stat& st,
-	              const std::string& poolPath,
-	              ScanProgress& progress);
+	bool collectFiles(const std::string& directory,
+	                  std::vector<ScanFile>& files);
+	File scanFiles(const Sha1Sum& sha1sum,
+	               const std::vector<ScanFile>& files,
+	               const std::string& poolPath,
+	               ScanProgress& progress);
 	Pool::iterator findInDatabase(const std::string& filename);
+	static uint64_t getFileSize(const std::string& filename);
 
 	Directories getDirectories() const;
 
@@ -121,10 +136,22 @@ private:
 	StringSetting filePoolSetting;
 	Reactor& reactor;
 	std::unique_ptr<Sha1SumCommand> sha1SumCommand;
-	MemBuffer<char> fileMem; // content of initial .filecache
-	std::vector<std::string> stringBuffer; // owns strings that are not in 'fileMem'
+	MemBuffer<char> fileMem; // content of the old .filecache (if converted)
+	std::deque<std::string> stringBuffer; // owns strings that are not in 'fileMem' or 'indexFile'
+
+	/** The index file (written at exit) is mmap'ed. As long as only
+	  * lookups on sha1sum are needed (e.g. to find the system ROMs of a
+	  * machine) it's binary searched directly. On the first modification
+	  * it's copied into 'pool', see loadIndex().
+	  */
+	File indexFile;
+	const IndexEntry* index;
+	const char* indexStrings;
+	unsigned indexSize;
+	bool indexLoaded; // all entries of 'index' are also in 'pool'
 
 	Pool pool;
+	ThreadPool threadPool; // calculates sha1sums while scanning
 	bool quit;
 	bool needWrite;
 };
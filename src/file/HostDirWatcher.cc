@@ -0,0 +1,151 @@
+#include "HostDirWatcher.hh"
+#include "FileOperations.hh"
+#include "ReadDir.hh"
+#include "StringOp.hh"
+#include "strCat.hh"
+#include "systemfuncs.hh"
+#include <algorithm>
+#include <cassert>
+#if HAVE_INOTIFY_INIT1
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+#if HAVE_INOTIFY_INIT1
+static const uint32_t WATCH_MASK =
+	IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+	IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+	IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+HostDirWatcher::HostDirWatcher(string dir_)
+	: dir(std::move(dir_))
+	, fd(-1)
+	, valid(false)
+{
+	assert(StringOp::endsWith(dir, '/'));
+	restart();
+}
+
+HostDirWatcher::~HostDirWatcher()
+{
+#if HAVE_INOTIFY_INIT1
+	if (fd != -1) close(fd);
+#endif
+}
+
+bool HostDirWatcher::getChanges(vector<string>& changed)
+{
+	changed.clear();
+	if (fd == -1) return false; // not supported, use polling
+
+	if (valid) readEvents(changed);
+	if (!valid) {
+		// Watch the directory tree again, the caller will do a full
+		// rescan (so any changes before this point don't matter).
+		changed.clear();
+		restart();
+		return false;
+	}
+	sort(begin(changed), end(changed));
+	changed.erase(unique(begin(changed), end(changed)), end(changed));
+	return true;
+}
+
+bool HostDirWatcher::hasChanges() const
+{
+#if HAVE_INOTIFY_INIT1
+	if ((fd == -1) || !valid) return true;
+	pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	return poll(&pfd, 1, 0) != 0; // also on error
+#else
+	return true;
+#endif
+}
+
+void HostDirWatcher::restart()
+{
+#if HAVE_INOTIFY_INIT1
+	// Starting with a new inotify instance is the easiest way to get rid
+	// of the old watches and the events that are still queued.
+	if (fd != -1) close(fd);
+	watches.clear();
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd == -1) return; // not supported, use polling
+	valid = addWatches({});
+	if (!valid) {
+		// Most likely the limit on the number of watches is reached
+		// (/proc/sys/fs/inotify/max_user_watches), don't try again.
+		close(fd);
+		fd = -1;
+		watches.clear();
+	}
+#endif
+}
+
+bool HostDirWatcher::addWatches(const string& subDir)
+{
+#if HAVE_INOTIFY_INIT1
+	int wd = inotify_add_watch(fd, (dir + subDir).c_str(), WATCH_MASK);
+	if (wd == -1) return false;
+	watches[wd] = subDir;
+
+	// Hidden directories are skipped, DirAsDSK ignores those anyway.
+	ReadDir readDir(dir + subDir);
+	while (auto* d = readDir.getEntry()) {
+		if (d->d_name[0] == '.') continue;
+		string name = strCat(subDir, d->d_name);
+		if (FileOperations::isDirectory(dir + name)) {
+			if (!addWatches(name + '/')) return false;
+		}
+	}
+	return true;
+#else
+	(void)subDir;
+	return false;
+#endif
+}
+
+void HostDirWatcher::readEvents(vector<string>& changed)
+{
+#if HAVE_INOTIFY_INIT1
+	alignas(inotify_event) char buf[4096];
+	while (true) {
+		auto len = read(fd, buf, sizeof(buf));
+		if (len <= 0) break; // EAGAIN: no more events
+		for (char* p = buf; p < (buf + len); /**/) {
+			auto* event = reinterpret_cast<inotify_event*>(p);
+			p += sizeof(inotify_event) + event->len;
+
+			// Changes in the directory structure itself are rare,
+			// handle them with a full rescan. (We would need to
+			// update the watches, and we would only get events for
+			// the files in a new directory that are created after
+			// the watch is added.)
+			if (event->mask & (IN_Q_OVERFLOW | IN_ISDIR | IN_IGNORED |
+			                   IN_DELETE_SELF | IN_MOVE_SELF)) {
+				valid = false;
+				continue;
+			}
+			auto it = watches.find(event->wd);
+			if ((it == end(watches)) || (event->len == 0)) {
+				valid = false;
+				continue;
+			}
+			changed.push_back(it->second + event->name);
+		}
+	}
+#else
+	(void)changed;
+#endif
+}
+
+} // namespace openmsx
@@ -0,0 +1,56 @@
+#ifndef HOSTDIRWATCHER_HH
+#define HOSTDIRWATCHER_HH
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of the changes in a host directory (and its subdirectories).
+  *
+  * Code that mirrors a host directory (DirAsDSK) can use this to only look
+  * at the host files that actually changed, instead of stat()-ing all of
+  * them. This is only implemented with inotify (Linux). On other systems,
+  * or when the change notifications are incomplete (e.g. the event queue
+  * overflowed, or a subdirectory was created, removed or renamed),
+  * getChanges() returns false and the caller must rescan the full directory.
+  */
+class HostDirWatcher
+{
+public:
+	HostDirWatcher(const HostDirWatcher&) = delete;
+	HostDirWatcher& operator=(const HostDirWatcher&) = delete;
+
+	/** @param dir The directory to watch, must end with a '/'. */
+	explicit HostDirWatcher(std::string dir);
+	~HostDirWatcher();
+
+	/** Get the host files that changed (created, modified, removed or
+	  * renamed) since the previous call. The names are relative to the
+	  * watched directory, sorted and without duplicates.
+	  * @return false if the changes are not known, then the caller must
+	  *         rescan the full directory (changes after this call are
+	  *         tracked again, if possible).
+	  */
+	bool getChanges(std::vector<std::string>& changed);
+
+	/** Returns true if there may be changes that were not yet reported by
+	  * getChanges(). This does not consume the changes.
+	  */
+	bool hasChanges() const;
+
+private:
+	void restart();
+	bool addWatches(const std::string& subDir);
+	void readEvents(std::vector<std::string>& changed);
+
+	const std::string dir;
+	std::map<int, std::string> watches; // watch descriptor -> subdir
+	int fd;
+	bool valid; // all changes since the last getChanges() call are known
+};
+
+} // namespace openmsx
+
+#endif
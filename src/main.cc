@@ -8,6 +8,7 @@
 #include "Reactor.hh"
 #include "CommandLineParser.hh"
 #include "CliServer.hh"
+#include "ReplayBatch.hh"
 #include "Display.hh"
 #include "EventDistributor.hh"
 #include "RenderSettings.hh"
@@ -143,7 +144,11 @@ static int main(int argc, char **argv)
 				// 'ext gfx9000'.
 				reactor.getEventDistributor().deliverEvents();
 			}
-			if (parseStatus != CommandLineParser::TEST) {
+			if (parseStatus == CommandLineParser::BATCH) {
+				ReplayBatch batch(reactor);
+				err = batch.run(parser.getBatchReplays(),
+				                parser.getBatchJobs());
+			} else if (parseStatus != CommandLineParser::TEST) {
 				CliServer cliServer(reactor.getCommandController(),
 				                    reactor.getEventDistributor(),
 				                    reactor.getGlobalCliComm());
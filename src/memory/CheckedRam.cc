@@ -4,6 +4,7 @@
 #include "DeviceConfig.hh"
 #include "GlobalSettings.hh"
 #include "StringSetting.hh"
+#include "serialize.hh"
 #include "likely.hh"
 #include <cassert>
 
@@ -53,7 +54,7 @@ const byte* CheckedRam::getReadCacheLine(unsigned addr) const
 byte* CheckedRam::getWriteCacheLine(unsigned addr) const
 {
 	return (completely_initialized_cacheline[addr >> CacheLine::BITS])
-	     ? const_cast<byte*>(&ram[addr]) : nullptr;
+	     ? const_cast<TrackedRam&>(ram).getWriteCacheLine(addr) : nullptr;
 }
 
 void CheckedRam::write(unsigned addr, const byte value)
@@ -67,7 +68,7 @@ void CheckedRam::write(unsigned addr, const byte value)
 			                          CacheLine::SIZE);
 		}
 	}
-	ram[addr] = value;
+	ram.write(addr, value);
 }
 
 void CheckedRam::clear()
@@ -102,4 +103,18 @@ void CheckedRam::update(const Setting& setting)
 	init();
 }
 
+template<typename Archive>
+void CheckedRam::serialize(Archive& ar, unsigned version)
+{
+	ram.serialize(ar, version);
+	if (!ar.isLoader() && ar.isReverseSnapshot()) {
+		// The dirty pages are now marked clean. But the CPU may still
+		// hold write pointers (obtained via getWriteCacheLine()) into
+		// those pages, writes via those pointers would go unnoticed.
+		// So force the CPU to request them again.
+		msxcpu.invalidateMemCache(0x0000, 0x10000);
+	}
+}
+INSTANTIATE_SERIALIZE_METHODS(CheckedRam);
+
 } // namespace openmsx
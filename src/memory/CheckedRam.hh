@@ -1,7 +1,7 @@
 #ifndef CHECKEDRAM_HH
 #define CHECKEDRAM_HH
 
-#include "Ram.hh"
+#include "TrackedRam.hh"
 #include "TclCallback.hh"
 #include "CacheLine.hh"
 #include "Observer.hh"
@@ -46,12 +46,15 @@ public:
 	 * will just be no checking done! Keep in mind that you should use this
 	 * consistently, so that the initialized-administration will be always
 	 * up to date!
+	 * Writes via the unchecked Ram can't be tracked either, so this also
+	 * (permanently) disables the dirty page tracking for reverse.
 	 */
-	Ram& getUncheckedRam() { return ram; }
+	Ram& getUncheckedRam() { return ram.getUntrackedRam(); }
 
-	// TODO
-	//template<typename Archive>
-	//void serialize(Archive& ar, unsigned version);
+	// Note: only serializes the ram content (in the same format as the
+	// Ram class), not the initialized-administration.
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
 
 private:
 	void init();
@@ -61,7 +64,7 @@ private:
 
 	std::vector<bool> completely_initialized_cacheline;
 	std::vector<std::bitset<CacheLine::SIZE>> uninitialized;
-	Ram ram;
+	TrackedRam ram;
 	MSXCPU& msxcpu;
 	TclCallback umrCallback;
 };
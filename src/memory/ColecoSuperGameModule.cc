@@ -171,8 +171,8 @@ byte* ColecoSuperGameModule::getWriteCacheLine(word start) const
 template<typename Archive>
 void ColecoSuperGameModule::serialize(Archive& ar, unsigned /*version*/)
 {
-	ar.serialize("mainRam", mainRam.getUncheckedRam());
-	ar.serialize("sgmRam", sgmRam.getUncheckedRam());
+	ar.serialize("mainRam", mainRam);
+	ar.serialize("sgmRam", sgmRam);
 	ar.serialize("psg", psg);
 	ar.serialize("psgLatch", psgLatch);
 	ar.serialize("ramEnabled", ramEnabled);
@@ -4,7 +4,6 @@
 #include "serialize.hh"
 #include "memory.hh"
 #include "outer.hh"
-#include "Ram.hh" // because we serialize Ram instead of CheckedRam
 #include "Math.hh"
 
 namespace openmsx {
@@ -125,8 +124,7 @@ void MSXMemoryMapper::serialize(Archive& ar, unsigned version)
 	if (ar.versionAtLeast(version, 2)) {
 		ar.serialize("registers", registers);
 	}
-	// TODO ar.serialize("checkedRam", checkedRam);
-	ar.serialize("ram", checkedRam.getUncheckedRam());
+	ar.serialize("ram", checkedRam);
 }
 INSTANTIATE_SERIALIZE_METHODS(MSXMemoryMapper);
 REGISTER_MSXDEVICE(MSXMemoryMapper, "MemoryMapper");
@@ -32,6 +32,7 @@ Ram::Ram(const DeviceConfig& config, const string& name,
 	: xml(*config.getXML())
 	, ram(size_)
 	, size(size_)
+	, dirtyPages((size_ + DIRTY_PAGE_SIZE - 1) / DIRTY_PAGE_SIZE, true)
 	, debuggable(make_unique<RamDebuggable>(
 		config.getMotherBoard(), name, description, *this))
 {
@@ -42,6 +43,7 @@ Ram::Ram(const XMLElement& xml_, unsigned size_)
 	: xml(xml_)
 	, ram(size_)
 	, size(size_)
+	, dirtyPages((size_ + DIRTY_PAGE_SIZE - 1) / DIRTY_PAGE_SIZE, true)
 {
 	clear();
 }
@@ -50,6 +52,7 @@ Ram::~Ram() = default;
 
 void Ram::clear(byte c)
 {
+	markAllDirty();
 	if (const XMLElement* init = xml.findChild("initialContent")) {
 		// get pattern (and decode)
 		const string& encoding = init->getAttribute("encoding");
@@ -89,6 +92,16 @@ void Ram::clear(byte c)
 
 }
 
+void Ram::markAllDirty()
+{
+	dirtyPages.assign(dirtyPages.size(), true);
+}
+
+void Ram::markAllClean()
+{
+	dirtyPages.assign(dirtyPages.size(), false);
+}
+
 const string& Ram::getName() const
 {
 	return debuggable->getName();
@@ -109,6 +122,7 @@ byte RamDebuggable::read(unsigned address)
 
 void RamDebuggable::write(unsigned address, byte value)
 {
+	ram.markDirty(address);
 	ram[address] = value;
 }
 
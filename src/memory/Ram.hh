@@ -5,6 +5,7 @@
 #include "openmsx.hh"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -15,6 +16,10 @@ class RamDebuggable;
 class Ram
 {
 public:
+	/** Granularity of the dirty page administration, see TrackedRam. */
+	static const unsigned DIRTY_PAGE_BITS = 12; // 4kB
+	static const unsigned DIRTY_PAGE_SIZE = 1 << DIRTY_PAGE_BITS;
+
 	/** Create Ram object with an associated debuggable. */
 	Ram(const DeviceConfig& config, const std::string& name,
 	    const std::string& description, unsigned size);
@@ -37,6 +42,18 @@ public:
 	const std::string& getName() const;
 	void clear(byte c = 0xff);
 
+	// Dirty page administration. Writes via the non-const operator[] are
+	// *not* tracked, users that need this should go via TrackedRam.
+	// (Only writes via the debuggable and clear() are tracked here.)
+	void markDirty(unsigned addr) {
+		dirtyPages[addr >> DIRTY_PAGE_BITS] = true;
+	}
+	void markAllDirty();
+	void markAllClean();
+	const std::vector<bool>& getDirtyPages() const {
+		return dirtyPages;
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -44,6 +61,7 @@ private:
 	const XMLElement& xml;
 	MemBuffer<byte> ram;
 	unsigned size; // must come before debuggable
+	std::vector<bool> dirtyPages;
 	const std::unique_ptr<RamDebuggable> debuggable; // can be nullptr
 };
 
@@ -3,18 +3,22 @@
 #include "TclObject.hh"
 #include "FileContext.hh"
 #include "File.hh"
+#include "FileException.hh"
 #include "FileOperations.hh"
 #include "GlobalCommandController.hh"
 #include "CliComm.hh"
 #include "StringOp.hh"
 #include "String32.hh"
+#include "Version.hh"
 #include "hash_map.hh"
 #include "outer.hh"
 #include "rapidsax.hh"
 #include "unreachable.hh"
 #include "stl.hh"
 #include "xxhash.hh"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 
 using std::string;
@@ -560,18 +564,81 @@ static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
 	}
 }
 
+// The parsed database is stored in a cache file, so that parsing the
+// softwaredb.xml files can be skipped on the next start. The file starts
+// with this header, followed by 'numEntries' CacheEntry structs (sorted on
+// sha1sum), 'stringSize' bytes of (zero-terminated) strings and the
+// signature of the softwaredb.xml files it was created from (see
+// getSignature()). All values are stored in native byte order.
+static const char* const CACHE_FILE = "/.softwaredb.cache";
+static const char CACHE_MAGIC[8] = { 'o', 'p', 'e', 'n', 'M', 'S', 'X', 'S' };
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t byteOrder;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t stringSize;
+	uint32_t signatureSize;
+	uint32_t padding;
+};
+
+// All strings are offsets in the string table, offset 0 is the empty string.
+struct CacheEntry {
+	Sha1Sum sum;
+	uint32_t title;
+	uint32_t year;
+	uint32_t company;
+	uint32_t country;
+	uint32_t origType;
+	uint32_t remark;
+	uint32_t romType; // the name, the enum values are not stable
+	int32_t genMSXid;
+	uint32_t original;
+};
+
+// The cache is only valid for the same openMSX version and the same
+// softwaredb.xml files: same name, modification time and size (also the
+// non-existing ones, the cache becomes invalid when they're created).
+static string getSignature(const vector<string>& filenames)
+{
+	string result = Version::full();
+	result += '\0';
+	for (auto& name : filenames) {
+		int64_t info[2] = { -1, -1 };
+		FileOperations::Stat st;
+		if (FileOperations::getStat(name, st)) {
+			info[0] = FileOperations::getModificationDate(st);
+			info[1] = st.st_size;
+		}
+		result += name;
+		result += '\0';
+		result.append(reinterpret_cast<const char*>(info), sizeof(info));
+	}
+	return result;
+}
+
 RomDatabase::RomDatabase(GlobalCommandController& commandController, CliComm& cliComm)
-	: softwareInfoTopic(commandController.getOpenMSXInfoCommand())
+	: bufStart(nullptr)
+	, softwareInfoTopic(commandController.getOpenMSXInfoCommand())
 {
+	// first user- then system-directory
+	vector<string> filenames;
+	for (auto& p : systemFileContext().getPaths()) {
+		filenames.push_back(FileOperations::join(p, "softwaredb.xml"));
+	}
+	string signature = getSignature(filenames);
+	if (readCache(signature)) return;
+
 	db.reserve(3500);
 	UnknownTypes unknownTypes;
-	// first user- then system-directory
-	vector<string> paths = systemFileContext().getPaths();
 	vector<File> files;
 	size_t bufferSize = 0;
-	for (auto& p : paths) {
+	for (auto& filename : filenames) {
 		try {
-			files.emplace_back(FileOperations::join(p, "softwaredb.xml"));
+			files.emplace_back(filename);
 			bufferSize += files.back().getSize() + rapidsax::EXTRA_BUFFER_SPACE;
 		} catch (MSXException& /*e*/) {
 			// Ignore. It's not unusual the DB in the user
@@ -581,7 +648,9 @@ RomDatabase::RomDatabase(GlobalCommandController& commandController, CliComm& cl
 		}
 	}
 	buffer.resize(bufferSize);
+	bufStart = buffer.data();
 	size_t bufferOffset = 0;
+	bool parseError = false;
 	for (auto& file : files) {
 		try {
 			auto size = file.getSize();
@@ -594,6 +663,7 @@ RomDatabase::RomDatabase(GlobalCommandController& commandController, CliComm& cl
 		} catch (rapidsax::ParseError& e) {
 			cliComm.printWarning(
 				"Rom database parsing failed: ", e.what());
+			parseError = true;
 		} catch (MSXException& /*e*/) {
 			// Ignore, see above
 		}
@@ -611,6 +681,147 @@ RomDatabase::RomDatabase(GlobalCommandController& commandController, CliComm& cl
 		}
 		cliComm.printWarning(output);
 	}
+	// Don't cache a database with problems, the warnings above should
+	// be repeated on the next start.
+	if (!db.empty() && !parseError && unknownTypes.empty()) {
+		writeCache(signature);
+	}
+}
+
+bool RomDatabase::readCache(const string& signature)
+{
+	try {
+		cacheFile = File(FileOperations::getUserDataDir() + CACHE_FILE, "rb");
+		size_t size;
+		const byte* data = cacheFile.mmap(size);
+
+		CacheHeader header;
+		if (size < sizeof(header)) throw MSXException("Cache too small");
+		memcpy(&header, data, sizeof(header));
+		size_t entriesSize = size_t(header.numEntries) * sizeof(CacheEntry);
+		if ((memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) ||
+		    (header.byteOrder != BYTE_ORDER_MARK) ||
+		    (header.version != CACHE_VERSION) ||
+		    (size != (sizeof(header) + entriesSize + header.stringSize +
+		              header.signatureSize))) {
+			throw MSXException("Invalid cache");
+		}
+		auto* entries = reinterpret_cast<const CacheEntry*>(
+			data + sizeof(header));
+		auto* strings = reinterpret_cast<const char*>(
+			data + sizeof(header) + entriesSize);
+		if (string_view(strings + header.stringSize, header.signatureSize)
+		    != signature) {
+			throw MSXException("Outdated cache");
+		}
+		if ((header.stringSize == 0) || (strings[0] != '\0') ||
+		    (strings[header.stringSize - 1] != '\0')) {
+			throw MSXException("Invalid cache");
+		}
+
+		// The strings are used directly from the mmap'ed file, only
+		// the (small) entries are copied.
+		auto str = [&](uint32_t offset) {
+			if (offset >= header.stringSize) {
+				throw MSXException("Invalid cache");
+			}
+			String32 result;
+			toString32(strings, strings + offset, result);
+			return result;
+		};
+		db.reserve(header.numEntries);
+		for (unsigned i = 0; i < header.numEntries; ++i) {
+			auto& e = entries[i];
+			auto title    = str(e.title);
+			auto year     = str(e.year);
+			auto company  = str(e.company);
+			auto country  = str(e.country);
+			auto origType = str(e.origType);
+			auto remark   = str(e.remark);
+			RomType romType = RomInfo::nameToRomType(
+				fromString32(strings, str(e.romType)));
+			db.emplace_back(e.sum, RomInfo(
+				title, year, company, country,
+				e.original != 0, origType, remark, romType,
+				e.genMSXid));
+		}
+		if (!std::is_sorted(begin(db), end(db), LessTupleElement<0>())) {
+			throw MSXException("Invalid cache");
+		}
+		bufStart = strings;
+		return true;
+	} catch (MSXException&) {
+		// ignore, cache doesn't exist (yet), is outdated or corrupt
+		db.clear();
+		cacheFile.close();
+		return false;
+	}
+}
+
+void RomDatabase::writeCache(const string& signature) const
+{
+	// Only store each distinct string once, many entries have e.g. the
+	// same company or year.
+	string strings(1, '\0');
+	hash_map<string_view, uint32_t, XXHasher> offsets;
+	auto add = [&](string_view str) -> uint32_t {
+		if (str.empty()) return 0;
+		auto it = offsets.find(str);
+		if (it != end(offsets)) return it->second;
+		auto offset = uint32_t(strings.size());
+		strings.append(str.data(), str.size());
+		strings += '\0';
+		offsets.emplace_noDuplicateCheck(str, offset);
+		return offset;
+	};
+
+	vector<CacheEntry> entries;
+	entries.reserve(db.size());
+	for (auto& p : db) {
+		auto& info = p.second;
+		CacheEntry e;
+		e.sum = p.first;
+		e.title    = add(info.getTitle   (bufStart));
+		e.year     = add(info.getYear    (bufStart));
+		e.company  = add(info.getCompany (bufStart));
+		e.country  = add(info.getCountry (bufStart));
+		e.origType = add(info.getOrigType(bufStart));
+		e.remark   = add(info.getRemark  (bufStart));
+		e.romType  = (info.getRomType() == ROM_UNKNOWN) ? 0 :
+		             add(RomInfo::romTypeToName(info.getRomType()));
+		e.genMSXid = info.getGenMSXid();
+		e.original = info.getOriginal();
+		entries.push_back(e);
+	}
+
+	CacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = CACHE_VERSION;
+	header.numEntries = uint32_t(entries.size());
+	header.stringSize = uint32_t(strings.size());
+	header.signatureSize = uint32_t(signature.size());
+	header.padding = 0;
+
+	// Write to a temporary file and then rename it, so that other openMSX
+	// instances (that are starting at the same time) never see a partially
+	// written cache.
+	string filename = FileOperations::getUserDataDir() + CACHE_FILE;
+	string tmpName = filename + ".tmp";
+	try {
+		{
+			File file(tmpName, File::SAVE_PERSISTENT);
+			file.write(&header, sizeof(header));
+			file.write(entries.data(), entries.size() * sizeof(CacheEntry));
+			file.write(strings.data(), strings.size());
+			file.write(signature.data(), signature.size());
+		}
+		if (FileOperations::rename(tmpName, filename) != 0) {
+			FileOperations::unlink(tmpName);
+		}
+	} catch (FileException&) {
+		// ignore, the cache is only an optimization
+	}
 }
 
 const RomInfo* RomDatabase::fetchRomInfo(const Sha1Sum& sha1sum) const
@@ -2,9 +2,11 @@
 #define ROMDATABASE_HH
 
 #include "RomInfo.hh"
+#include "File.hh"
 #include "MemBuffer.hh"
 #include "InfoTopic.hh"
 #include "sha1.hh"
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,11 +27,16 @@ public:
 	 */
 	const RomInfo* fetchRomInfo(const Sha1Sum& sha1sum) const;
 
-	const char* getBufferStart() const { return buffer.data(); }
+	const char* getBufferStart() const { return bufStart; }
 
 private:
+	bool readCache(const std::string& signature);
+	void writeCache(const std::string& signature) const;
+
 	RomDB db;
-	MemBuffer<char> buffer;
+	MemBuffer<char> buffer; // the parsed softwaredb.xml files
+	File cacheFile;         // or the mmap'ed cache
+	const char* bufStart;   // start of one of the above
 
 	struct SoftwareInfoTopic final : InfoTopic {
 		explicit SoftwareInfoTopic(InfoCommand& openMSXInfoCommand);
@@ -9,9 +9,15 @@ void TrackedRam::serialize(Archive& ar, unsigned /*version*/)
 	// Note: This is the exact same serialization format as the Ram class.
 	//  This allows to change from Ram to TrackedRam without having to
 	//  increase the class serialization version (of the user).
-	bool diff = writeSinceLastReverseSnapshot || !ar.isReverseSnapshot();
-	ar.serialize_blob("ram", &ram[0], getSize(), diff);
-	if (ar.isReverseSnapshot()) writeSinceLastReverseSnapshot = false;
+	//  (Only memory archives split the blob in pages.)
+	if (untracked) ram.markAllDirty();
+	ar.serialize_blob_pages("ram", &ram[0], getSize(),
+	                        Ram::DIRTY_PAGE_SIZE, ram.getDirtyPages());
+	if (ar.isLoader()) {
+		ram.markAllDirty();
+	} else if (ar.isReverseSnapshot()) {
+		ram.markAllClean();
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(TrackedRam);
 
@@ -6,6 +6,10 @@
 namespace openmsx {
 
 // Ram with dirty tracking
+//
+// The ram is divided in pages of Ram::DIRTY_PAGE_SIZE bytes. For each page we
+// track whether it was written since the last reverse snapshot. Clean pages
+// don't need to be compared with the previous snapshot at all.
 class TrackedRam
 {
 public:
@@ -36,13 +40,12 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(unsigned addr, byte value) {
-		writeSinceLastReverseSnapshot = true;
+		ram.markDirty(addr);
 		ram[addr] = value;
 	}
 
 	void clear(byte c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
-		ram.clear(c);
+		ram.clear(c); // marks all pages dirty
 	}
 
 	// Some write operations are more efficient in bulk. For those this
@@ -50,16 +53,33 @@ public:
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	byte* getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		ram.markAllDirty();
 		return &ram[0];
 	}
 
+	// Write access to the (aligned) CacheLine that contains 'addr'. This
+	// marks the corresponding page as dirty. The resulting pointer may
+	// only be used till the next reverse snapshot is taken, so the user
+	// must drop it (e.g. invalidate the CPU cache) after serialize().
+	byte* getWriteCacheLine(unsigned addr) {
+		ram.markDirty(addr);
+		return &ram[addr];
+	}
+
+	// Give up on dirty tracking: from now on the whole ram is always
+	// considered dirty. Needed when write access to the ram is given out
+	// in a way that cannot be tracked.
+	Ram& getUntrackedRam() {
+		untracked = true;
+		return ram;
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	bool untracked = false;
 };
 
 } // namespace openmsx
@@ -11,6 +11,7 @@
 #include "Version.hh"
 #include "Date.hh"
 #include "cstdiop.hh" // for dup()
+#include <algorithm>
 #include <cstring>
 #include <limits>
 
@@ -232,6 +233,19 @@ void MemOutputArchive::serialize_blob(const char*, const void* data, size_t len,
 
 }
 
+void MemOutputArchive::serialize_blob_pages(
+	const char* tag, const void* data, size_t len,
+	size_t pageSize, const std::vector<bool>& dirty)
+{
+	// Each page becomes a separate blob (with its own DeltaBlock). Outside
+	// of reverse snapshots all pages must be compared.
+	auto* p = static_cast<const byte*>(data);
+	for (size_t offset = 0, page = 0; offset < len; offset += pageSize, ++page) {
+		bool diff = !reverseSnapshot || dirty[page];
+		serialize_blob(tag, p + offset, std::min(pageSize, len - offset), diff);
+	}
+}
+
 void MemInputArchive::serialize_blob(const char*, void* data, size_t len, bool /*diff*/)
 {
 	if (len > SMALL_SIZE) {
@@ -251,6 +265,16 @@ void MemInputArchive::serialize_blob(const char*, void* data, size_t len, bool /
 	}
 }
 
+void MemInputArchive::serialize_blob_pages(
+	const char* tag, void* data, size_t len,
+	size_t pageSize, const std::vector<bool>& /*dirty*/)
+{
+	auto* p = static_cast<byte*>(data);
+	for (size_t offset = 0; offset < len; offset += pageSize) {
+		serialize_blob(tag, p + offset, std::min(pageSize, len - offset));
+	}
+}
+
 ////
 
 XmlOutputArchive::XmlOutputArchive(const string& filename)
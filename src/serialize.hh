@@ -135,6 +135,16 @@ public:
 	//   type).
 	//
 	//
+	// void serialize_blob_pages(const char* tag, const void* data, size_t len,
+	//                           size_t pageSize, const std::vector<bool>& dirty)
+	//
+	//   Like serialize_blob(), but memory archives split the blob in pages
+	//   of 'pageSize' bytes. In a reverse snapshot, pages for which 'dirty'
+	//   is not set are not compared with the previous snapshot at all, they
+	//   simply reuse its data. Other archives store the blob in exactly the
+	//   same way as serialize_blob() does.
+	//
+	//
 	// template<typename T> void serialize(const char* tag, const T& t)
 	//
 	//   This is much like the serializeWithID() method above, but it doesn't
@@ -439,6 +449,11 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, const void* data, size_t len,
+	                          size_t /*pageSize*/, const std::vector<bool>& /*dirty*/)
+	{
+		this->self().serialize_blob(tag, data, len);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -534,6 +549,11 @@ public:
 	}
 	void serialize_blob(const char* tag, void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, void* data, size_t len,
+	                          size_t /*pageSize*/, const std::vector<bool>& /*dirty*/)
+	{
+		this->self().serialize_blob(tag, data, len);
+	}
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -624,6 +644,8 @@ public:
 	void save(const std::string& s);
 	void serialize_blob(const char*, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, const void* data, size_t len,
+	                          size_t pageSize, const std::vector<bool>& dirty);
 
 	void beginSection()
 	{
@@ -692,6 +714,8 @@ public:
 	string_view loadStr();
 	void serialize_blob(const char*, void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, void* data, size_t len,
+	                          size_t pageSize, const std::vector<bool>& dirty);
 
 	void skipSection(bool skip)
 	{
@@ -8,6 +8,7 @@
 #include "XMLElement.hh"
 #include "MSXException.hh"
 #include "checked_cast.hh"
+#include <atomic>
 
 using std::string;
 
@@ -27,6 +28,22 @@ BaseSetting::BaseSetting(const TclObject& name_)
 {
 }
 
+static std::atomic<bool> settingsFrozen(false);
+
+void BaseSetting::setFrozen(bool frozen)
+{
+	settingsFrozen = frozen;
+}
+
+void BaseSetting::checkNotFrozen() const
+{
+	if (settingsFrozen) {
+		throw MSXException(
+			"Can't change setting '", getFullName(),
+			"' while replays are running in parallel.");
+	}
+}
+
 void BaseSetting::info(TclObject& result) const
 {
 	result.addListElement(getTypeString());
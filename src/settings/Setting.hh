@@ -109,6 +109,18 @@ public:
 	 */
 	virtual void setDontSaveValue(const TclObject& dontSaveValue) = 0;
 
+	/** While machines are emulated in parallel (see ReplayBatch), the
+	  * settings are shared between those threads without any locking.
+	  * Then all settings are read-only: a change of value (via Tcl or via
+	  * setValue()) is rejected. Only to be called from the main thread.
+	  */
+	static void setFrozen(bool frozen);
+
+	/** Throws an MSXException when settings are currently frozen.
+	  * Called by the Interpreter before the value gets changed.
+	  */
+	void checkNotFrozen() const;
+
 private:
 	      TclObject fullName;
 	const TclObject baseName;
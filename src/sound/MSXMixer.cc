@@ -48,6 +48,7 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
 	, recorder(nullptr)
 	, synchronousCounter(0)
+	, seekMode(false)
 {
 	hostSampleRate = 44100;
 	fragmentSize = 0;
@@ -171,6 +172,12 @@ void MSXMixer::updateStream(EmuTime::param time)
 	unsigned count = prevTime.getTicksTill(time);
 	assert(count <= 8192);
 
+	if (seekMode) {
+		// skip generate(), see setSeekMode()
+		prevTime += count;
+		return;
+	}
+
 	// call generate() even if count==0 and even if muted
 	generate(mixBuffer, time, count);
 
@@ -471,6 +478,7 @@ void MSXMixer::generate(int16_t* output, EmuTime::param time, unsigned samples)
 	if (samples == 0) {
 		SSE_ALIGNED(int32_t dummyBuf[4]);
 		for (auto& info : infos) {
+			if (info.device->isDormant()) continue;
 			info.device->updateBuffer(0, dummyBuf, time);
 		}
 		return;
@@ -491,6 +499,7 @@ void MSXMixer::generate(int16_t* output, EmuTime::param time, unsigned samples)
 	// devices are handled first
 	for (auto& info : infos) {
 		SoundDevice& device = *info.device;
+		if (device.isDormant()) continue; // silent, nothing to do
 		int l1 = info.left1;
 		int r1 = info.right1;
 		if (!device.isStereo()) {
@@ -645,6 +654,21 @@ void MSXMixer::setMixerParams(unsigned newFragmentSize, unsigned newSampleRate)
 	}
 }
 
+void MSXMixer::setSeekMode(bool seek)
+{
+	if (seek == seekMode) return;
+	seekMode = seek;
+	if (!seekMode) {
+		// The resamplers didn't see the skipped samples, restart them
+		// in sync with the (advanced) host sample clock.
+		reInit();
+		tl0 = tr0 = 0;
+		for (auto& info : infos) {
+			info.device->setOutputRate(hostSampleRate);
+		}
+	}
+}
+
 void MSXMixer::setRecorder(AviRecorder* newRecorder)
 {
 	if ((recorder != nullptr) != (newRecorder != nullptr)) {
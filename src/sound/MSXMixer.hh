@@ -114,6 +114,16 @@ public:
 
 	void reInit();
 
+	/** In seek mode no sound is generated at all. Sound devices still
+	  * handle register writes (and timers keep running), but they don't
+	  * calculate any samples and there's no resampling or mixing. This is
+	  * used to quickly fast-forward to a certain point in a replay.
+	  * When seek mode is turned off, the resamplers are restarted at the
+	  * current time.
+	  */
+	void setSeekMode(bool seek);
+	bool isSeekMode() const { return seekMode; }
+
 private:
 	struct SoundDeviceInfo {
 		SoundDevice* device;
@@ -174,6 +184,7 @@ private:
 
 	unsigned muteCount;
 	int32_t tl0, tr0; // internal DC-filter state
+	bool seekMode;
 };
 
 } // namespace openmsx
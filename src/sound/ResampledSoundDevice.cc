@@ -37,7 +37,18 @@ void ResampledSoundDevice::setOutputRate(unsigned /*sampleRate*/)
 bool ResampledSoundDevice::updateBuffer(unsigned length, int* buffer,
                                         EmuTime::param time)
 {
-	return algo->generateOutput(buffer, length, time);
+	bool result = algo->generateOutput(buffer, length, time);
+	// Only when the resampler output is silent as well (e.g. the tail
+	// of the filter has died out).
+	if (!result) checkDormant();
+	return result;
+}
+
+void ResampledSoundDevice::wakeUp()
+{
+	// The resampler didn't advance while dormant, restart it at the
+	// current host time.
+	createResampler();
 }
 
 bool ResampledSoundDevice::generateInput(int* buffer, unsigned num)
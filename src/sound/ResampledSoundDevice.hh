@@ -33,6 +33,7 @@ protected:
 	void setOutputRate(unsigned sampleRate) override;
 	bool updateBuffer(unsigned length, int* buffer,
 	                  EmuTime::param time) override;
+	void wakeUp() override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) override;
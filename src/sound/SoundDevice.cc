@@ -99,6 +99,8 @@ SoundDevice::SoundDevice(MSXMixer& mixer_, string_view name_,
 	, stereo(stereo_ ? 2 : 1)
 	, numRecordChannels(0)
 	, balanceCenter(true)
+	, silentChannels(false)
+	, dormant(false)
 {
 	assert(numChannels <= MAX_CHANNELS);
 	assert(stereo == 1 || stereo == 2);
@@ -122,6 +124,24 @@ int SoundDevice::getAmplificationFactorImpl() const
 	return 1;
 }
 
+bool SoundDevice::canBeDormant() const
+{
+	return false;
+}
+
+void SoundDevice::wakeUp()
+{
+}
+
+void SoundDevice::checkDormant()
+{
+	// While recording individual channels, keep on generating (silent)
+	// samples for the wav files.
+	if (silentChannels && (numRecordChannels == 0) && canBeDormant()) {
+		dormant = true;
+	}
+}
+
 void SoundDevice::registerSound(const DeviceConfig& config)
 {
 	const XMLElement& soundConfig = config.getChild("sound");
@@ -171,6 +191,21 @@ void SoundDevice::unregisterSound()
 void SoundDevice::updateStream(EmuTime::param time)
 {
 	mixer.updateStream(time);
+	// The caller is about to change the device state, so the last
+	// generated channel data no longer says anything about the future.
+	silentChannels = false;
+	if (unlikely(dormant)) {
+		// Output was silent till now, so we can start again from
+		// here. Must be done after mixer.updateStream().
+		leaveDormant();
+	}
+}
+
+void SoundDevice::leaveDormant()
+{
+	dormant = false;
+	silentChannels = false;
+	wakeUp();
 }
 
 void SoundDevice::setSoftwareVolume(VolumeType volume, EmuTime::param time)
@@ -199,6 +234,7 @@ void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 	bool recording = writer[channel] != nullptr;
 	if (recording != wasRecording) {
 		if (recording) {
+			if (dormant) leaveDormant();
 			if (numRecordChannels == 0) {
 				mixer.setSynchronousMode(true);
 			}
@@ -270,13 +306,15 @@ bool SoundDevice::mixChannels(int* dataOut, unsigned samples)
 
 	generateChannels(bufs, samples);
 
-	if (separateChannels == 0) {
-		for (unsigned i = 0; i < numChannels; ++i) {
-			if (bufs[i]) {
-				return true;
-			}
+	silentChannels = true;
+	for (unsigned i = 0; i < numChannels; ++i) {
+		if (bufs[i]) {
+			silentChannels = false;
+			break;
 		}
-		return false;
+	}
+	if (separateChannels == 0) {
+		return !silentChannels;
 	}
 
 	// record channels
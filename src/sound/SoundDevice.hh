@@ -69,6 +69,13 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	/** Is this device dormant?
+	  * A dormant device is known to produce only silence until its next
+	  * updateStream() call, so the Mixer can skip it completely.
+	  * @see canBeDormant()
+	  */
+	bool isDormant() const { return dormant; }
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -105,9 +112,37 @@ protected:
 	 */
 	void unregisterSound();
 
-	/** @see Mixer::updateStream */
+	/** @see Mixer::updateStream
+	  * This also wakes up the device when it was dormant.
+	  */
 	void updateStream(EmuTime::param time);
 
+	/** Can this device go dormant?
+	  * A device may only return true when, once all its channels are
+	  * silent (generateChannels() set all buffer pointers to nullptr), it
+	  * stays silent until after the next call to updateStream(). IOW all
+	  * state changes that can make it produce sound again (register
+	  * writes, reset, ...) must be preceded by updateStream().
+	  * Nothing is generated while dormant, so a device whose silent
+	  * channels still have state that advances and that influences the
+	  * output later on (e.g. the SCC phase counters of muted channels)
+	  * must return false. The default implementation returns false.
+	  */
+	virtual bool canBeDormant() const;
+
+	/** Called when a dormant device wakes up again (from updateStream()).
+	  * Subclasses can e.g. reset their resampler state here.
+	  */
+	virtual void wakeUp();
+
+	/** Should be called from updateBuffer() when the generated output
+	  * was completely silent. If all channels were silent during the
+	  * last mixChannels() call as well, and this device allows it (see
+	  * canBeDormant()), the device goes dormant: the Mixer won't call
+	  * updateBuffer() anymore until the device is woken up again.
+	  */
+	void checkDormant();
+
 	void setInputRate(unsigned sampleRate) { inputSampleRate = sampleRate; }
 	unsigned getInputRate() const { return inputSampleRate; }
 
@@ -185,6 +220,8 @@ protected:
 	double getEffectiveSpeed() const;
 
 private:
+	void leaveDormant();
+
 	MSXMixer& mixer;
 	const std::string name;
 	const std::string description;
@@ -200,6 +237,8 @@ private:
 	int channelBalance[MAX_CHANNELS];
 	bool channelMuted[MAX_CHANNELS];
 	bool balanceCenter;
+	bool silentChannels;
+	bool dormant;
 };
 
 } // namespace openmsx
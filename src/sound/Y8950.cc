@@ -803,6 +803,13 @@ int Y8950::getAmplificationFactorImpl() const
 	return 1 << (15 - DB2LIN_AMP_BITS);
 }
 
+bool Y8950::canBeDormant() const
+{
+	// When muted (see checkMuteHelper()) the internal state isn't
+	// updated anyway, so skipping generateChannels() changes nothing.
+	return true;
+}
+
 void Y8950::setEnabled(bool enabled_, EmuTime::param time)
 {
 	updateStream(time);
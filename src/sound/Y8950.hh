@@ -75,6 +75,7 @@ private:
 	// SoundDevice
 	int getAmplificationFactorImpl() const override;
 	void generateChannels(int** bufs, unsigned num) override;
+	bool canBeDormant() const override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
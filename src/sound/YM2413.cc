@@ -79,6 +79,13 @@ int YM2413::getAmplificationFactorImpl() const
 	return core->getAmplificationFactor();
 }
 
+bool YM2413::canBeDormant() const
+{
+	// Both cores only report silence for channels that are keyed off and
+	// whose envelope has finished. Only a register write can change that.
+	return true;
+}
+
 
 template<typename Archive>
 void YM2413::serialize(Archive& ar, unsigned /*version*/)
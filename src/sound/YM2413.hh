@@ -28,6 +28,7 @@ private:
 	// SoundDevice
 	void generateChannels(int** bufs, unsigned num) override;
 	int getAmplificationFactorImpl() const override;
+	bool canBeDormant() const override;
 
 	const std::unique_ptr<YM2413Core> core;
 
@@ -1554,6 +1554,13 @@ int YMF262::getAmplificationFactorImpl() const
 	return 1 << 3;
 }
 
+bool YMF262::canBeDormant() const
+{
+	// When muted (see checkMuteHelper()) the internal state isn't
+	// updated anyway, so skipping generateChannels() changes nothing.
+	return true;
+}
+
 void YMF262::generateChannels(int** bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
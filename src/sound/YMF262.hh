@@ -144,6 +144,7 @@ private:
 	// SoundDevice
 	int getAmplificationFactorImpl() const override;
 	void generateChannels(int** bufs, unsigned num) override;
+	bool canBeDormant() const override;
 
 	void callback(byte flag) override;
 
@@ -459,6 +459,13 @@ void YMF278::setMixLevel(uint8_t x, EmuTime::param time)
 	setSoftwareVolume(level[x & 7], level[(x >> 3) & 7], time);
 }
 
+bool YMF278::canBeDormant() const
+{
+	// All slots are off (see anyActive()), they can only be started
+	// again by a register write.
+	return true;
+}
+
 void YMF278::generateChannels(int** bufs, unsigned num)
 {
 	if (!anyActive()) {
@@ -91,6 +91,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(int** bufs, unsigned num) override;
+	bool canBeDormant() const override;
 
 	void writeRegDirect(byte reg, byte data, EmuTime::param time);
 	unsigned getRamAddress(unsigned addr) const;
@@ -6,6 +6,7 @@ namespace openmsx {
 namespace Thread {
 
 static std::thread::id mainThreadId;
+static thread_local bool emulationThread = false;
 
 void setMainThread()
 {
@@ -19,5 +20,16 @@ bool isMainThread()
 	return mainThreadId == std::this_thread::get_id();
 }
 
+void setEmulationThread(bool emulation)
+{
+	assert(!isMainThread());
+	emulationThread = emulation;
+}
+
+bool isEmulationThread()
+{
+	return emulationThread || isMainThread();
+}
+
 } // namespace Thread
 } // namespace openmsx
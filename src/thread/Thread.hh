@@ -14,6 +14,19 @@ namespace Thread {
 	  */
 	bool isMainThread();
 
+	/** Mark (or unmark) the calling thread as an emulation thread. Such a
+	  * thread runs a machine that is not the active machine (e.g. see
+	  * ReplayBatch). Like the main thread it may run the Scheduler and
+	  * the CPU of that machine, but all other services (CliComm, Tcl,
+	  * ...) remain main-thread only.
+	  */
+	void setEmulationThread(bool emulation);
+
+	/** Returns true when called from the main thread or from a thread
+	  * that is marked with setEmulationThread().
+	  */
+	bool isEmulationThread();
+
 } // namespace Thread
 } // namespace openmsx
 
@@ -0,0 +1,70 @@
+#include "ThreadPool.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+ThreadPool::ThreadPool(unsigned maxThreads_)
+	: maxThreads(maxThreads_ ? maxThreads_
+	                         : std::max(1u, std::thread::hardware_concurrency()))
+	, idle(0), running(0), exiting(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exiting = true;
+	}
+	taskCond.notify_all();
+	for (auto& t : threads) {
+		t.join();
+	}
+	assert(tasks.empty());
+}
+
+std::shared_future<void> ThreadPool::addTask(std::function<void()> task)
+{
+	std::packaged_task<void()> pt(std::move(task));
+	std::shared_future<void> result = pt.get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(!exiting);
+		tasks.push_back(std::move(pt));
+		if ((idle < tasks.size()) && (threads.size() < maxThreads)) {
+			threads.emplace_back([this]() { run(); });
+		}
+	}
+	taskCond.notify_one();
+	return result;
+}
+
+void ThreadPool::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idleCond.wait(lock, [&] { return tasks.empty() && (running == 0); });
+}
+
+void ThreadPool::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		++idle;
+		taskCond.wait(lock, [&] { return exiting || !tasks.empty(); });
+		--idle;
+		// Even when exiting, first finish all pending tasks.
+		if (tasks.empty()) return;
+
+		auto task = std::move(tasks.front());
+		tasks.pop_front();
+		++running;
+		lock.unlock();
+		task(); // exceptions are stored in the future
+		lock.lock();
+		--running;
+		idleCond.notify_all();
+	}
+}
+
+} // namespace openmsx
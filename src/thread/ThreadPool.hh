@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A small set of worker threads that execute tasks in FIFO order.
+  *
+  * Worker threads are only started when there are tasks for them, so
+  * creating a (possibly never used) ThreadPool is cheap. The destructor
+  * first finishes all pending tasks before it joins the worker threads.
+  *
+  * Because tasks are dequeued in FIFO order, a task may (safely) wait for
+  * the result of a task that was added earlier to the same pool.
+  */
+class ThreadPool
+{
+public:
+	/** @param maxThreads Maximum number of worker threads. Zero means
+	  *                   use the number of hardware threads.
+	  */
+	explicit ThreadPool(unsigned maxThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** Schedule a task for execution on one of the worker threads.
+	  * @return A future that becomes ready when the task has finished.
+	  *         When the task threw an exception, get() rethrows it.
+	  */
+	std::shared_future<void> addTask(std::function<void()> task);
+
+	/** Block until all tasks added so far have finished.
+	  */
+	void waitIdle();
+
+	unsigned getMaxThreads() const { return maxThreads; }
+
+private:
+	void run();
+
+	std::vector<std::thread> threads;
+	std::deque<std::packaged_task<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskCond; // signaled on new task or on exit
+	std::condition_variable idleCond; // signaled when a task finishes
+	const unsigned maxThreads;
+	unsigned idle;    // number of threads waiting for work
+	unsigned running; // number of tasks currently executing
+	bool exiting;
+};
+
+} // namespace openmsx
+
+#endif
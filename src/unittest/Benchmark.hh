@@ -0,0 +1,25 @@
+#ifndef BENCHMARK_HH
+#define BENCHMARK_HH
+
+#include <chrono>
+
+namespace openmsx {
+
+/** Helper for the benchmarks in the unittests. Those test cases are tagged
+  * "[.][benchmark]", so they don't run by default. Use e.g.
+  * 'openmsx "[benchmark]"' to run them.
+  *
+  * Executes 'f' and returns how long that took, in seconds.
+  */
+template<typename F> double measureSeconds(F f)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto start = clock::now();
+	f();
+	std::chrono::duration<double> d = clock::now() - start;
+	return d.count();
+}
+
+} // namespace openmsx
+
+#endif
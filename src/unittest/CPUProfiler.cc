@@ -0,0 +1,48 @@
+#include "catch.hpp"
+#include "CPUProfiler.hh"
+#include <sstream>
+
+using namespace openmsx;
+
+TEST_CASE("CPUProfiler")
+{
+	CPUProfiler profiler;
+	// 'ld a,(hl) ; jr' loop in slot 3-1, called from slot 0
+	profiler.instruction(0, 0x0100, 1000);
+	for (int i = 0; i < 3; ++i) {
+		uint64_t t = 1005 + 20 * i;
+		profiler.instruction(13, 0x4000, t);
+		profiler.instruction(13, 0x4001, t + 8);
+	}
+	profiler.skipCycles(); // e.g. switch between Z80 and R800
+	profiler.instruction(0, 0x0102, 5000);
+	profiler.instruction(0, 0x0103, 5004);
+
+	std::ostringstream os;
+	CPUProfiler::writeHeader(os);
+	profiler.write(os, "z80");
+	CHECK(os.str() ==
+		"# callgrind format\n"
+		"version: 1\n"
+		"creator: openMSX\n"
+		"positions: instr\n"
+		"events: Instructions Cycles\n"
+		"\n"
+		"ob=z80\n"
+		"fl=slot 0-0\n"
+		"fn=slot 0-0\n"
+		"0x0100 1 5\n"
+		"0x0102 1 4\n"
+		"0x0103 1 0\n"
+		"\n"
+		"ob=z80\n"
+		"fl=slot 3-1\n"
+		"fn=slot 3-1\n"
+		"0x4000 3 24\n"
+		"0x4001 3 24\n"); // last one skipped
+
+	profiler.clear();
+	std::ostringstream os2;
+	profiler.write(os2, "z80");
+	CHECK(os2.str().empty());
+}
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "CPUTraceBuffer.hh"
+#include "Dasm.hh"
+#include <sstream>
+
+using namespace openmsx;
+
+static void record(CPUTraceBuffer& buf, word pc, byte op0, byte op1 = 0,
+                   byte op2 = 0, byte op3 = 0)
+{
+	auto& e = buf.next();
+	e.time = EmuTime::zero;
+	e.pc = pc;
+	e.af = 0x1234; e.bc = 1; e.de = 2; e.hl = 3;
+	e.ix = 4; e.iy = 5; e.sp = 0xF000;
+	e.opcode[0] = op0; e.opcode[1] = op1;
+	e.opcode[2] = op2; e.opcode[3] = op3;
+}
+
+TEST_CASE("CPUTraceBuffer: ring")
+{
+	CPUTraceBuffer buf(3); // rounded up to 4
+	CHECK(buf.capacity() == 4);
+	CHECK(buf.size() == 0);
+	for (word pc = 0; pc < 6; ++pc) record(buf, pc, 0x00);
+	CHECK(buf.size() == 4);
+	CHECK(buf.getTotal() == 6);
+	CHECK(buf[0].pc == 2); // oldest
+	CHECK(buf[3].pc == 5); // newest
+	buf.clear();
+	CHECK(buf.size() == 0);
+}
+
+TEST_CASE("CPUTraceBuffer: write")
+{
+	CPUTraceBuffer buf(16);
+	record(buf, 0x4000, 0x3E, 0x12);             // ld a,#12
+	record(buf, 0x4002, 0x18, 0xFE);             // jr #4002
+	record(buf, 0x4004, 0xDD, 0x36, 0xFE, 0x55); // ld (ix-#02),#55
+
+	std::ostringstream os;
+	buf.write(os, 2);
+	CHECK(os.str() ==
+		"0 4002 : jr     #4002       "
+		" AF=1234 BC=0001 DE=0002 HL=0003 IX=0004 IY=0005 SP=f000\n"
+		"0 4004 : ld     (ix-#02),#55"
+		" AF=1234 BC=0001 DE=0002 HL=0003 IX=0004 IY=0005 SP=f000\n");
+}
+
+TEST_CASE("Dasm: from bytes")
+{
+	std::string s;
+	const byte op1[4] = { 0xCD, 0x34, 0x12, 0xFF };
+	CHECK(dasm(op1, 0, s) == 3);
+	CHECK(s == "call   #1234       ");
+	s.clear();
+	const byte op2[4] = { 0xFD, 0xCB, 0x03, 0x46 };
+	CHECK(dasm(op2, 0, s) == 4);
+	CHECK(s == "bit    0,iy+#03    ");
+}
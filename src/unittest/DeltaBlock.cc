@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "Benchmark.hh"
+#include "DeltaBlock.hh"
+#include "ThreadPool.hh"
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Create a sequence of 'count' memory images, each one derived from the
+// previous by changing 'changes' random bytes. When 'runs' is true the changes
+// are clustered in short runs (like e.g. a VRAM name table update), otherwise
+// they're scattered (like e.g. variables in RAM).
+static std::vector<std::vector<uint8_t>> createImages(
+	size_t size, int count, int changes, bool runs)
+{
+	std::mt19937 rng(12345);
+	std::vector<std::vector<uint8_t>> result;
+	std::vector<uint8_t> img(size);
+	for (auto& b : img) b = rng() & 0x07;
+	for (int i = 0; i < count; ++i) {
+		for (int j = 0; j < changes; /**/) {
+			size_t addr = rng() % size;
+			int len = runs ? (1 + rng() % 40) : 1;
+			for (int k = 0; (k < len) && (addr < size); ++k, ++j) {
+				img[addr++] = rng();
+			}
+		}
+		result.push_back(img);
+	}
+	return result;
+}
+
+static void checkRoundTrip(size_t size, int changes, bool runs)
+{
+	auto images = createImages(size, 20, changes, runs);
+	ThreadPool pool;
+	LastDeltaBlocks lastBlocks(pool);
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	for (auto& img : images) {
+		blocks.push_back(lastBlocks.createNew(&lastBlocks, img.data(), size));
+	}
+	lastBlocks.clear();
+
+	std::vector<uint8_t> out(size);
+	for (size_t i = 0; i < images.size(); ++i) {
+		blocks[i]->apply(out.data(), size);
+		CHECK(out == images[i]);
+	}
+}
+
+TEST_CASE("DeltaBlock: round trip")
+{
+	SECTION("no changes") {
+		checkRoundTrip(0x10000, 0, false);
+	}
+	SECTION("scattered changes") {
+		checkRoundTrip(0x10000, 500, false);
+	}
+	SECTION("clustered changes") {
+		checkRoundTrip(0x10000, 500, true);
+	}
+	SECTION("everything changes") {
+		checkRoundTrip(0x1000, 0x10000, false);
+	}
+	SECTION("odd sizes") {
+		for (size_t size : {1, 2, 3, 31, 33, 63, 65, 257}) {
+			checkRoundTrip(size, 3, false);
+		}
+	}
+}
+
+TEST_CASE("DeltaBlock: throughput", "[.][benchmark]")
+{
+	const size_t SIZE = 0x20000; // typical VRAM size
+	const int COUNT = 200;
+	auto images = createImages(SIZE, COUNT, 2000, true);
+	ThreadPool pool;
+	LastDeltaBlocks lastBlocks(pool);
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<uint8_t> out(SIZE);
+
+	auto report = [&](const char* what, double seconds) {
+		std::cout << what << ": "
+		          << (double(SIZE) * COUNT / seconds) / (1024 * 1024)
+		          << " MB/s" << std::endl;
+	};
+
+	report("encode", measureSeconds([&] {
+		for (auto& img : images) {
+			blocks.push_back(lastBlocks.createNew(
+				&lastBlocks, img.data(), SIZE));
+		}
+		// wait for the delta calculation
+		for (auto& b : blocks) b->getDataSize();
+	}));
+	report("decode", measureSeconds([&] {
+		for (auto& b : blocks) b->apply(out.data(), SIZE);
+	}));
+	CHECK(out == images.back());
+}
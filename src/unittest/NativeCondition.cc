@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "NativeCondition.hh"
+#include "CommandException.hh"
+#include <cstring>
+
+using namespace openmsx;
+
+class TestReader final : public NativeCondition::Reader
+{
+public:
+	TestReader()
+	{
+		memset(regs, 0, sizeof(regs));
+		memset(mem, 0, sizeof(mem));
+		regs[0] = 0x12; regs[1] = 0x34; // AF
+		regs[6] = 0x40; regs[7] = 0x01; // HL
+		regs[20] = 0x45; regs[21] = 0x67; // PC (page 1)
+		mem[0x4001] = 0x99; mem[0x4002] = 0x88;
+		ioports = 0x04; // page 1 in slot 1
+		subslot = 0xFF ^ 0x08; // page 1 in subslot 2
+	}
+
+	byte read(string_view name, unsigned address) override
+	{
+		if (name == "CPU regs") return regs[address];
+		if (name == "memory") {
+			if (address >= 0x10000) {
+				throw CommandException("Invalid address");
+			}
+			return mem[address];
+		}
+		if (name == "ioports") return ioports;
+		if (name == "slotted memory") return subslot;
+		throw CommandException("No such debuggable: ", name);
+	}
+	bool isExpanded(int ps) override { return ps == 1; }
+
+	byte regs[28];
+	byte mem[0x10000];
+	byte ioports;
+	byte subslot;
+};
+
+TEST_CASE("NativeCondition: compile")
+{
+	NativeCondition cond;
+	// supported
+	CHECK(cond.compile("1"));
+	CHECK(cond.compile("[reg A] == 0x12"));
+	CHECK(cond.compile(" [reg hl]==16385 && ([peek 0xC000] != 0 || ![reg F])"));
+	CHECK(cond.compile("[peek16 [reg HL] {slotted memory}] >= 0b101"));
+	CHECK(cond.compile("[debug read \"CPU regs\" 20] < 0x80"));
+	CHECK(cond.compile("[pc_in_slot 1 X]"));
+	CHECK(cond.compile("(-[reg A] + 3 * 0o17) & ~1 ^ 2 | 8"));
+
+	// not supported (fall back to Tcl)
+	CHECK(!cond.compile(""));
+	CHECK(!cond.compile("$::wp_last_value == 3"));
+	CHECK(!cond.compile("[reg A] << 1"));
+	CHECK(!cond.compile("[reg A] / 2"));
+	CHECK(!cond.compile("[reg A] eq 5"));
+	CHECK(!cond.compile("[reg XYZ]"));
+	CHECK(!cond.compile("[peek $addr]"));
+	CHECK(!cond.compile("[my_proc]"));
+	CHECK(!cond.compile("[pc_in_slot 1 0 3]"));
+	CHECK(!cond.compile("010")); // octal or decimal, depends on Tcl version
+	CHECK(!cond.compile("1.5"));
+	CHECK(!cond.compile("1e3"));
+	CHECK(!cond.compile("[reg A]]"));
+	CHECK(!cond.compile("([reg A]"));
+	CHECK(!cond.compile("true"));
+}
+
+TEST_CASE("NativeCondition: eval")
+{
+	TestReader reader;
+	auto eval = [&](const char* expr) {
+		NativeCondition cond;
+		REQUIRE(cond.compile(expr));
+		return cond.eval(reader);
+	};
+	CHECK( eval("1"));
+	CHECK(!eval("0"));
+	CHECK( eval("[reg A] == 0x12"));
+	CHECK( eval("[reg a] == 18 && [reg F] == 0x34"));
+	CHECK( eval("[reg AF] == 0x1234"));
+	CHECK( eval("[reg HL] == 0x4001"));
+	CHECK( eval("[peek [reg HL]] == 0x99"));
+	CHECK( eval("[peek16 [reg HL]] == 0x8899"));
+	CHECK( eval("[peek_u16 0x4001 memory] == 0x8899"));
+	CHECK( eval("[debug read {CPU regs} 21] == 0x67"));
+	CHECK( eval("([reg F] & 0x04) != 0"));
+	CHECK( eval("[reg A] - 20 == -2"));
+	CHECK( eval("1 + 2 * 3 == 7"));
+	CHECK( eval("(1 + 2) * 3 == 9"));
+	CHECK( eval("1 | 2 ^ 3 & 6 == 3"));
+	CHECK(!eval("!([reg A] < 0x13)"));
+	CHECK( eval("~0 == -1"));
+	CHECK( eval("0 || [reg A] > 1 && [reg A] <= 0x12"));
+	CHECK(!eval("[reg A] >= 0x13 || [reg A] != 0x12"));
+
+	CHECK( eval("[pc_in_slot 1]"));
+	CHECK( eval("[pc_in_slot 1 2]"));
+	CHECK( eval("[pc_in_slot 1 X]"));
+	CHECK(!eval("[pc_in_slot 1 3]"));
+	CHECK(!eval("[pc_in_slot 0]"));
+
+	// short-circuit, the invalid read is not evaluated
+	CHECK(!eval("0 && [peek 0x10000]"));
+	CHECK_THROWS_AS(eval("[peek 0x10000]"), CommandException);
+	CHECK_THROWS_AS(eval("[peek 0 foo]"), CommandException);
+}
@@ -0,0 +1,274 @@
+#include "catch.hpp"
+#include "Benchmark.hh"
+#include "TestPixelFormat.hh"
+#include "RawFrame.hh"
+#include "ScalerOutput.hh"
+#include "PixelOperations.hh"
+#include "Scaler1.hh"
+#include "SaI2xScaler.hh"
+#include "SaI3xScaler.hh"
+#include "Scale2xScaler.hh"
+#include "Scale3xScaler.hh"
+#include "HQ2xScaler.hh"
+#include "HQ3xScaler.hh"
+#include "HQ2xLiteScaler.hh"
+#include "HQ3xLiteScaler.hh"
+#include "MLAAScaler.hh"
+#include "LineScalers.hh"
+#include "Scanline.hh"
+#include "HostCPU.hh"
+#include "ThreadPool.hh"
+#include "memory.hh"
+#include <SDL.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+using Pixel = uint32_t;
+
+// ScalerOutput that simply stores the scaled image.
+class MemoryScalerOutput final : public ScalerOutput<Pixel>
+{
+public:
+	MemoryScalerOutput(unsigned width_, unsigned height_)
+		: pixels(width_ * height_), width(width_), height(height_) {}
+
+	unsigned getWidth()  const override { return width; }
+	unsigned getHeight() const override { return height; }
+	Pixel* acquireLine(unsigned y) override { return &pixels[y * width]; }
+	void   releaseLine(unsigned /*y*/, Pixel* /*buf*/) override {}
+	void   fillLine(unsigned y, Pixel color) override {
+		std::fill_n(&pixels[y * width], width, color);
+	}
+
+	std::vector<Pixel> pixels;
+private:
+	const unsigned width;
+	const unsigned height;
+};
+
+// Fill a frame with something that looks a bit like a MSX screen: a border,
+// some tiles and a couple of sprites (so with lots of horizontal, vertical
+// and diagonal edges for the scalers to work on).
+static void fillFrame(RawFrame& frame, unsigned width, unsigned f)
+{
+	static const Pixel palette[8] = {
+		0x000000, 0x21C842, 0x5EDC78, 0x5455ED,
+		0x7D76FC, 0xD4524D, 0x42EBF5, 0xFCFCFC,
+	};
+	unsigned scale = width / 320;
+	for (unsigned y = 0; y < frame.getHeight(); ++y) {
+		auto* line = frame.getLinePtrDirect<Pixel>(y);
+		for (unsigned x = 0; x < width; ++x) {
+			unsigned mx = x / scale;
+			unsigned c = 4; // border
+			if ((24 <= y) && (y < 216) && (32 <= mx) && (mx < 288)) {
+				unsigned sx = mx + f;
+				unsigned tile = ((sx / 8) * 7 + (y / 8) * 3) % 5;
+				c = (((sx ^ y) & 4) || ((sx + y) % 7 == 0)) ? tile : 0;
+				unsigned s = (y + f) / 32;
+				unsigned sy = (y + f) % 32;
+				if ((sy < 16) && ((mx - 40 - s * 30) < 16)) {
+					c = 5 + (s % 3);
+				}
+			}
+			line[x] = palette[c];
+		}
+		frame.setLineWidth(y, width);
+	}
+}
+
+struct ScalerInfo {
+	const char* name;
+	std::unique_ptr<Scaler<Pixel>> (*create)(const PixelOperations<Pixel>&);
+	unsigned factor;
+};
+
+template<typename S> static std::unique_ptr<Scaler<Pixel>> create(
+	const PixelOperations<Pixel>& pixelOps)
+{
+	return make_unique<S>(pixelOps);
+}
+template<unsigned WIDTH> static std::unique_ptr<Scaler<Pixel>> createMLAA(
+	const PixelOperations<Pixel>& pixelOps)
+{
+	return make_unique<MLAAScaler<Pixel>>(WIDTH, pixelOps);
+}
+
+// The scalers that ScalerFactory creates. Not included are the scalers that
+// need RenderSettings (simple, tv, rgbtriplet), those are never scaled in
+// bands anyway (see Scaler::canScaleInBands()).
+static const ScalerInfo scalerInfos[] = {
+	{ "normal 1x", create<Scaler1       <Pixel>>, 1 },
+	{ "SaI 2x",    create<SaI2xScaler   <Pixel>>, 2 },
+	{ "ScaleNx 2x",create<Scale2xScaler <Pixel>>, 2 },
+	{ "hq 2x",     create<HQ2xScaler    <Pixel>>, 2 },
+	{ "hqlite 2x", create<HQ2xLiteScaler<Pixel>>, 2 },
+	{ "MLAA 2x",   createMLAA<640>,               2 },
+	{ "SaI 3x",    create<SaI3xScaler   <Pixel>>, 3 },
+	{ "ScaleNx 3x",create<Scale3xScaler <Pixel>>, 3 },
+	{ "hq 3x",     create<HQ3xScaler    <Pixel>>, 3 },
+	{ "hqlite 3x", create<HQ3xLiteScaler<Pixel>>, 3 },
+	{ "MLAA 3x",   createMLAA<960>,               3 },
+};
+
+// Scale the frame in the given number of bands, in the same way as
+// FBPostProcessor does (but all lines have the same width here). A scaler
+// that isn't local is always run on the whole image.
+static void scaleInBands(
+	std::vector<std::unique_ptr<Scaler<Pixel>>>& scalers,
+	ThreadPool& pool, RawFrame& frame, unsigned srcWidth,
+	ScalerOutput<Pixel>& dst, unsigned factor, unsigned numBands)
+{
+	if (!scalers[0]->isLocal()) numBands = 1;
+	unsigned srcHeight = frame.getHeight();
+	auto band = [&](unsigned b) {
+		unsigned first = (srcHeight * (b + 0)) / numBands;
+		unsigned last  = (srcHeight * (b + 1)) / numBands;
+		scalers[b]->scaleImage(frame, nullptr, first, last, srcWidth,
+		                       dst, first * factor, last * factor);
+	};
+	if (numBands == 1) {
+		band(0);
+		return;
+	}
+	std::vector<std::shared_future<void>> futures;
+	for (unsigned b = 0; b < numBands; ++b) {
+		futures.push_back(pool.addTask([&band, b] { band(b); }));
+	}
+	for (auto& f : futures) f.get();
+}
+
+TEST_CASE("Scaler: scale in bands")
+{
+	auto format = createFormat32();
+	PixelOperations<Pixel> pixelOps(format);
+	ThreadPool pool(4);
+	for (auto& info : scalerInfos) {
+		INFO(info.name);
+		unsigned srcHeight = 240;
+		unsigned dstWidth  = 320 * info.factor;
+		unsigned dstHeight = srcHeight * info.factor;
+		RawFrame frame(format, 640, srcHeight);
+		unsigned srcWidth = 320;
+		fillFrame(frame, srcWidth, 0);
+
+		std::vector<std::unique_ptr<Scaler<Pixel>>> scalers;
+		for (unsigned i = 0; i < 7; ++i) {
+			scalers.push_back(info.create(pixelOps));
+		}
+		MemoryScalerOutput expected(dstWidth, dstHeight);
+		scalers[0]->scaleImage(frame, nullptr, 0, srcHeight, srcWidth,
+		                       expected, 0, dstHeight);
+		for (unsigned numBands : {2, 3, 7}) {
+			MemoryScalerOutput output(dstWidth, dstHeight);
+			scaleInBands(scalers, pool, frame, srcWidth, output,
+			             info.factor, numBands);
+			CHECK(output.pixels == expected.pixels);
+		}
+	}
+}
+
+TEST_CASE("Scaler: AVX2 routines")
+{
+	if (!HostCPU::hasAVX2()) return;
+
+	auto format = createFormat32();
+	PixelOperations<Pixel> pixelOps(format);
+	RawFrame frame(format, 640, 240);
+	fillFrame(frame, 320, 3);
+	const Pixel* line0 = frame.getLinePtrDirect<Pixel>(100);
+	const Pixel* line1 = frame.getLinePtrDirect<Pixel>(101);
+
+	// Run the given routine with and without AVX2, compare the output.
+	auto check = [&](unsigned width, std::function<void(Pixel*)> f) {
+		std::vector<Pixel> out1(width), out2(width);
+		f(out1.data());
+		HostCPU::setAVX2(false);
+		f(out2.data());
+		HostCPU::setAVX2(true);
+		CHECK(out1 == out2);
+	};
+	for (unsigned width : {320, 333}) {
+		INFO(width);
+		check(2 * width, [&](Pixel* out) {
+			Scale_1on2<Pixel> scale;
+			scale(line0, out, 2 * width);
+		});
+		check(3 * width, [&](Pixel* out) {
+			Scale_1on3<Pixel> scale;
+			scale(line0, out, 3 * width);
+		});
+		check(width, [&](Pixel* out) {
+			BlendLines<Pixel> blend(pixelOps);
+			blend(line0, line1, out, width);
+		});
+	}
+	check(320, [&](Pixel* out) {
+		Scanline<Pixel> scanline(pixelOps);
+		scanline.draw(line0, line1, out, 200, 320);
+	});
+
+	// Complete scalers (the HQ scalers use AVX2 for the edge detection).
+	for (auto& info : scalerInfos) {
+		INFO(info.name);
+		auto scaler = info.create(pixelOps);
+		MemoryScalerOutput output1(320 * info.factor, 240 * info.factor);
+		MemoryScalerOutput output2(320 * info.factor, 240 * info.factor);
+		scaler->scaleImage(frame, nullptr, 0, 240, 320,
+		                   output1, 0, 240 * info.factor);
+		HostCPU::setAVX2(false);
+		scaler->scaleImage(frame, nullptr, 0, 240, 320,
+		                   output2, 0, 240 * info.factor);
+		HostCPU::setAVX2(true);
+		CHECK(output1.pixels == output2.pixels);
+	}
+}
+
+TEST_CASE("Scaler: benchmark", "[.][benchmark]")
+{
+	auto format = createFormat32();
+	PixelOperations<Pixel> pixelOps(format);
+	ThreadPool pool;
+	unsigned numThreads = pool.getMaxThreads();
+
+	const unsigned COUNT = 50;
+	std::vector<std::unique_ptr<RawFrame>> frames;
+	for (unsigned f = 0; f < COUNT; ++f) {
+		frames.push_back(make_unique<RawFrame>(format, 640, 240));
+		fillFrame(*frames.back(), 320, f);
+	}
+
+	bool avx2 = HostCPU::hasAVX2();
+	std::cout << "frames/s, 1 band and " << numThreads << " bands"
+	          << (avx2 ? ", 1 band without AVX2" : "") << ":\n";
+	for (auto& info : scalerInfos) {
+		std::vector<std::unique_ptr<Scaler<Pixel>>> scalers;
+		for (unsigned i = 0; i < numThreads; ++i) {
+			scalers.push_back(info.create(pixelOps));
+		}
+		MemoryScalerOutput output(320 * info.factor, 240 * info.factor);
+		auto measure = [&](unsigned numBands) {
+			double seconds = measureSeconds([&] {
+				for (auto& frame : frames) {
+					scaleInBands(scalers, pool, *frame, 320,
+					             output, info.factor, numBands);
+				}
+			});
+			std::cout << ' ' << COUNT / seconds;
+		};
+		std::cout << "  " << info.name << ':';
+		measure(1);
+		measure(numThreads);
+		if (avx2) {
+			HostCPU::setAVX2(false);
+			measure(1);
+			HostCPU::setAVX2(true);
+		}
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,131 @@
+#include "catch.hpp"
+#include "Scheduler.hh"
+#include "Schedulable.hh"
+#include "Thread.hh"
+#include "serialize.hh"
+#include "DeltaBlock.hh"
+#include "ThreadPool.hh"
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static EmuTime at(unsigned t)
+{
+	return EmuTime::zero + EmuDuration(uint64_t(t));
+}
+
+struct TestDevice final : Schedulable
+{
+	TestDevice(Scheduler& scheduler_, std::string& log_, char name_)
+		: Schedulable(scheduler_), log(log_), name(name_) {}
+	void executeUntil(EmuTime::param /*time*/) override { log += name; }
+	void set(unsigned t) { setSyncPoint(at(t)); }
+	bool remove() { return removeSyncPoint(); }
+	bool pending(EmuTime& t) const { return pendingSyncPoint(t); }
+	std::string& log;
+	char name;
+};
+
+// In a real machine there's always at least one pending sync point, the
+// scheduler relies on that.
+static void addGuard(TestDevice& guard)
+{
+	guard.set(1000000);
+}
+
+static void initThread()
+{
+	static bool done = false;
+	if (!done) {
+		Thread::setMainThread();
+		done = true;
+	}
+}
+
+TEST_CASE("Scheduler: removeSyncPoint removes the earliest")
+{
+	initThread();
+	Scheduler scheduler;
+	std::string log;
+	TestDevice a(scheduler, log, 'a');
+	TestDevice b(scheduler, log, 'b');
+	TestDevice c(scheduler, log, 'c');
+	TestDevice guard(scheduler, log, 'g');
+	addGuard(guard);
+	a.set(30);
+	c.set(5);
+	a.set(10);
+	b.set(10);
+	a.set(10);
+	EmuTime t = EmuTime::zero;
+	CHECK(a.pending(t));
+	CHECK(t == at(10));
+
+	// removes the first 'a' at time 10, not the one at time 30
+	CHECK(a.remove());
+	scheduler.schedule(at(100));
+	CHECK(log == "cbaa");
+	CHECK(!a.remove());
+}
+
+TEST_CASE("Scheduler: serialize sync points in order")
+{
+	initThread();
+	std::string log1;
+	ThreadPool pool;
+	std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	LastDeltaBlocks lastDeltaBlocks(pool);
+	MemBuffer<byte> buf;
+	size_t size;
+	{
+		Scheduler scheduler;
+		TestDevice a(scheduler, log1, 'a');
+		TestDevice b(scheduler, log1, 'b');
+		TestDevice guard(scheduler, log1, 'g');
+		addGuard(guard);
+		b.set(10);
+		a.set(30);
+		a.set(20);
+		b.set(25);
+		a.set(10);
+		a.set(20);
+
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		b.serialize(out, 0);
+		a.serialize(out, 0);
+		buf = out.releaseBuffer(size);
+
+		scheduler.schedule(at(100));
+		CHECK(log1 == "baaaba");
+	}
+	{
+		// the sync points of a device are saved in order
+		MemInputArchive in(buf.data(), size, deltaBlocks);
+		Scheduler::SyncPoints sb, sa;
+		in.serialize("syncPoints", sb);
+		in.serialize("syncPoints", sa);
+		REQUIRE(sb.size() == 2);
+		CHECK(sb[0].getTime() == at(10));
+		CHECK(sb[1].getTime() == at(25));
+		REQUIRE(sa.size() == 4);
+		CHECK(sa[0].getTime() == at(10));
+		CHECK(sa[1].getTime() == at(20));
+		CHECK(sa[2].getTime() == at(20));
+		CHECK(sa[3].getTime() == at(30));
+	}
+	{
+		// and restored in the same order
+		std::string log2;
+		Scheduler scheduler;
+		TestDevice a(scheduler, log2, 'a');
+		TestDevice b(scheduler, log2, 'b');
+		TestDevice guard(scheduler, log2, 'g');
+		addGuard(guard);
+		MemInputArchive in(buf.data(), size, deltaBlocks);
+		b.serialize(in, 0);
+		a.serialize(in, 0);
+		scheduler.schedule(at(100));
+		CHECK(log2 == "baaaba");
+	}
+}
@@ -0,0 +1,244 @@
+#include "catch.hpp"
+#include "Benchmark.hh"
+#include "SchedulerQueue.hh"
+#include "SchedulerHeap.hh"
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Stand-in for SynchronizationPoint: a time and a device number.
+struct Item {
+	uint64_t time;
+	int device;
+};
+struct LessItem {
+	bool operator()(const Item& x, const Item& y) const {
+		return x.time < y.time;
+	}
+};
+struct SetSentinelItem {
+	void operator()(Item& item) const {
+		item.time = std::numeric_limits<uint64_t>::max();
+	}
+};
+
+// A trace is a sequence of Scheduler operations, similar to the calls to
+// setSyncPoint(), removeSyncPoint() and the removal of the first sync point
+// in scheduleHelper().
+struct Op {
+	enum Type { INSERT, REMOVE, POP } type;
+	Item item; // for INSERT, for REMOVE/POP only 'device' is used
+};
+
+// Devices (roughly) modeled after the Schedulables in a real machine. Most
+// reschedule themselves after they got executed (e.g. VDP, RealTime, timers
+// in sound chips, FDCs, ...). Some also get rescheduled at random moments
+// (e.g. when the MSX program writes to a register).
+struct DeviceModel {
+	uint64_t period; // in us
+	bool jitter;     // execution time varies
+	double rescheduleChance; // per executed sync point (of any device)
+};
+
+// Generate a trace using a std::multimap as reference implementation. For
+// POP operations the trace records the expected device.
+static std::vector<Op> createTrace(const std::vector<DeviceModel>& devices,
+                                   size_t numOps)
+{
+	std::mt19937 rng(42);
+	std::multimap<uint64_t, int> ref; // insertion order for equal keys
+	std::vector<Op> trace;
+	auto insert = [&](uint64_t time, int device) {
+		ref.emplace(time, device);
+		trace.push_back({Op::INSERT, {time, device}});
+	};
+	for (int d = 0; d < int(devices.size()); ++d) {
+		insert(devices[d].period, d);
+	}
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	while (trace.size() < numOps) {
+		auto it = ref.begin();
+		uint64_t now = it->first;
+		int d = it->second;
+		ref.erase(it);
+		trace.push_back({Op::POP, {now, d}});
+
+		uint64_t p = devices[d].period;
+		insert(now + (devices[d].jitter ? (1 + rng() % (2 * p)) : p), d);
+
+		for (int r = 0; r < int(devices.size()); ++r) {
+			if (chance(rng) >= devices[r].rescheduleChance) continue;
+			auto it2 = std::find_if(ref.begin(), ref.end(),
+				[&](const std::pair<const uint64_t, int>& e) {
+					return e.second == r; });
+			if (it2 == ref.end()) continue;
+			ref.erase(it2);
+			trace.push_back({Op::REMOVE, {0, r}});
+			insert(now + 1 + rng() % devices[r].period, r);
+		}
+	}
+	return trace;
+}
+
+static std::vector<DeviceModel> msx1Devices()
+{
+	return {
+		{   228, false, 0.0  }, // VDP horizontal scan
+		{ 20000, false, 0.0  }, // VDP vertical sync
+		{ 16000, false, 0.01 }, // VDP display start
+		{ 80000, false, 0.0  }, // RealTime
+		{1000000,false, 0.0  }, // ReverseManager
+		{  5000, true,  0.0  }, // EventDelay
+	};
+}
+
+static std::vector<DeviceModel> manyDevices()
+{
+	auto result = msx1Devices();
+	for (int i = 0; i < 2; ++i) {
+		result.push_back({    80, false, 0.001 }); // FM timer 1
+		result.push_back({   320, false, 0.001 }); // FM timer 2
+	}
+	for (int i = 0; i < 4; ++i) {
+		result.push_back({  1000, true,  0.002 }); // FDC
+		result.push_back({ 200000, false, 0.0  }); // FDC motor off
+	}
+	for (int i = 0; i < 3; ++i) {
+		result.push_back({   100, true,  0.001 }); // i8254 counters (RS232)
+	}
+	result.push_back({   320, true,  0.002 }); // MIDI in/out
+	result.push_back({   318, true,  0.002 }); // MIDI
+	result.push_back({    64, false, 0.001 }); // V9990 horizontal scan
+	result.push_back({ 16666, false, 0.0   }); // V9990 vertical scan
+	result.push_back({   500, true,  0.01  }); // V9990 command engine
+	result.push_back({   500, true,  0.01  }); // VDP command engine
+	for (int i = 0; i < 8; ++i) {
+		result.push_back({ 30000, true, 0.0005 }); // after time commands
+	}
+	return result;
+}
+
+template<typename Queue>
+static void replay(Queue& queue, const std::vector<Op>& trace, bool check)
+{
+	for (auto& op : trace) {
+		switch (op.type) {
+		case Op::INSERT:
+			queue.insert(op.item, SetSentinelItem(), LessItem());
+			break;
+		case Op::REMOVE: {
+			int d = op.item.device;
+			bool removed = queue.remove(
+				[&](const Item& i) { return i.device == d; });
+			if (check) REQUIRE(removed);
+			break;
+		}
+		case Op::POP:
+			if (check) {
+				REQUIRE(!queue.empty());
+				CHECK(queue.front().time   == op.item.time);
+				CHECK(queue.front().device == op.item.device);
+			}
+			queue.remove_front();
+			break;
+		}
+	}
+}
+
+template<typename Queue>
+static void checkTrace(const std::vector<Op>& trace)
+{
+	Queue queue;
+	replay(queue, trace, true);
+
+	// All devices still have exactly one sync point, remove the even ones.
+	auto n = queue.size();
+	queue.remove_all([](const Item& i) { return (i.device & 1) == 0; });
+	CHECK(queue.size() == n / 2);
+	uint64_t prev = 0;
+	while (!queue.empty()) {
+		CHECK((queue.front().device & 1) == 1);
+		CHECK(queue.front().time >= prev);
+		prev = queue.front().time;
+		queue.remove_front();
+	}
+}
+
+TEST_CASE("SchedulerQueue: order")
+{
+	SECTION("few devices") {
+		auto trace = createTrace(msx1Devices(), 20000);
+		checkTrace<SchedulerQueue<Item>>(trace);
+		checkTrace<SchedulerHeap<Item, LessItem>>(trace);
+	}
+	SECTION("many devices") {
+		auto trace = createTrace(manyDevices(), 20000);
+		checkTrace<SchedulerQueue<Item>>(trace);
+		checkTrace<SchedulerHeap<Item, LessItem>>(trace);
+	}
+	SECTION("equal times keep insertion order") {
+		std::vector<Op> trace;
+		for (int d = 0; d < 100; ++d) {
+			trace.push_back({Op::INSERT, {uint64_t(d % 3), d}});
+		}
+		for (int t = 0; t < 3; ++t) {
+			for (int d = t; d < 100; d += 3) {
+				trace.push_back({Op::POP, {uint64_t(t), d}});
+			}
+		}
+		SchedulerQueue<Item> queue;
+		replay(queue, trace, true);
+		SchedulerHeap<Item, LessItem> heap;
+		replay(heap, trace, true);
+	}
+	SECTION("remove takes the first in sorted order") {
+		std::vector<Op> trace = {
+			{Op::INSERT, {30, 0}},
+			{Op::INSERT, { 5, 2}},
+			{Op::INSERT, {10, 0}},
+			{Op::INSERT, {10, 1}},
+			{Op::INSERT, {10, 0}},
+			{Op::REMOVE, { 0, 0}}, // the first {10, 0}
+			{Op::POP,    { 5, 2}},
+			{Op::POP,    {10, 1}},
+			{Op::POP,    {10, 0}},
+			{Op::POP,    {30, 0}},
+		};
+		SchedulerQueue<Item> queue;
+		replay(queue, trace, true);
+		SchedulerHeap<Item, LessItem> heap;
+		replay(heap, trace, true);
+	}
+}
+
+template<typename Queue>
+static double measure(const std::vector<Op>& trace)
+{
+	double best = std::numeric_limits<double>::max();
+	for (int i = 0; i < 5; ++i) {
+		Queue queue;
+		best = std::min(best, measureSeconds([&] {
+			replay(queue, trace, false);
+		}));
+	}
+	return best * 1e9 / trace.size(); // ns per operation
+}
+
+TEST_CASE("SchedulerQueue: benchmark", "[.][benchmark]")
+{
+	auto run = [](const char* name, const std::vector<DeviceModel>& devices) {
+		auto trace = createTrace(devices, 2000000);
+		std::cout << name << " (" << devices.size() << " devices):\n"
+		          << "  SchedulerQueue: "
+		          << measure<SchedulerQueue<Item>>(trace) << " ns/op\n"
+		          << "  SchedulerHeap:  "
+		          << measure<SchedulerHeap<Item, LessItem>>(trace) << " ns/op"
+		          << std::endl;
+	};
+	run("few devices", msx1Devices());
+	run("many devices", manyDevices());
+}
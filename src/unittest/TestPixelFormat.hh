@@ -0,0 +1,26 @@
+#ifndef TESTPIXELFORMAT_HH
+#define TESTPIXELFORMAT_HH
+
+#include <SDL.h>
+#include <cstring>
+
+namespace openmsx {
+
+/** A 32bpp (0x00RRGGBB) pixel format, for tests that don't have a real
+  * SDL surface.
+  */
+inline SDL_PixelFormat createFormat32()
+{
+	SDL_PixelFormat format;
+	memset(&format, 0, sizeof(format));
+	format.BitsPerPixel = 32;
+	format.BytesPerPixel = 4;
+	format.Rmask = 0x00FF0000; format.Rshift = 16;
+	format.Gmask = 0x0000FF00; format.Gshift =  8;
+	format.Bmask = 0x000000FF; format.Bshift =  0;
+	return format;
+}
+
+} // namespace openmsx
+
+#endif
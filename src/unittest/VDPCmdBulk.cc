@@ -0,0 +1,255 @@
+#include "catch.hpp"
+#include "VDPCmdModes.hh"
+#include "VDPCmdBulk.hh"
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Stand-in for VDPVRAM: 128kB, of which 'size' bytes are present, with (at
+// most) one observed region [obsBegin, obsEnd].
+struct TestVRAM {
+	struct Window {
+		explicit Window(const std::vector<byte>& data_) : data(data_) {}
+		byte readNP(unsigned address) const { return data[address]; }
+		const std::vector<byte>& data;
+	};
+
+	TestVRAM()
+		: data(0x20000), cmdReadWindow(data), cmdWriteWindow(data)
+	{
+		std::mt19937 rng(1234);
+		for (auto& d : data) d = byte(rng());
+	}
+	void cmdWrite(unsigned address, byte value, EmuTime::param /*time*/) {
+		data[address] = value;
+	}
+	void cmdWriteUnobserved(unsigned address, byte value) {
+		REQUIRE(isUnobserved(address, address));
+		data[address] = value;
+	}
+	bool isUnobserved(unsigned begin, unsigned end) const {
+		if (end >= size) return false;
+		return (end < obsBegin) || (obsEnd < begin);
+	}
+
+	std::vector<byte> data;
+	Window cmdReadWindow;
+	Window cmdWriteWindow;
+	unsigned size = 0x20000;
+	unsigned obsBegin = 1, obsEnd = 0; // nothing observed
+};
+
+struct Regs {
+	unsigned SX, SY, DX, DY, NY, ASX, ADX, ANX;
+};
+static bool operator==(const Regs& x, const Regs& y) {
+	return x.SX  == y.SX  && x.SY  == y.SY  && x.DX  == y.DX  &&
+	       x.DY  == y.DY  && x.NY  == y.NY  && x.ASX == y.ASX &&
+	       x.ADX == y.ADX && x.ANX == y.ANX;
+}
+
+// Reference implementations, these follow the stepwise code in
+// VDPCmdEngine (without the timing).
+template<typename Mode, typename LogOp>
+static void stepLmmv(TestVRAM& vram, Regs& r, byte color,
+                     unsigned nx, unsigned ny, int tx, int ty)
+{
+	while (true) {
+		unsigned addr = Mode::addressOf(r.ADX, r.DY, false);
+		byte dst = vram.cmdWriteWindow.readNP(addr);
+		Mode::pset(EmuTime::zero, vram, r.ADX, addr, dst, color, LogOp());
+		r.ADX += tx;
+		if (--r.ANX == 0) {
+			r.DY += ty; --r.NY;
+			r.ADX = r.DX; r.ANX = nx;
+			if (--ny == 0) break;
+		}
+	}
+}
+template<typename Mode, typename LogOp>
+static void stepLmmm(TestVRAM& vram, Regs& r,
+                     unsigned nx, unsigned ny, int tx, int ty)
+{
+	while (true) {
+		byte src = Mode::point(vram, r.ASX, r.SY, false);
+		unsigned addr = Mode::addressOf(r.ADX, r.DY, false);
+		byte dst = vram.cmdWriteWindow.readNP(addr);
+		Mode::pset(EmuTime::zero, vram, r.ADX, addr, dst, src, LogOp());
+		r.ASX += tx; r.ADX += tx;
+		if (--r.ANX == 0) {
+			r.SY += ty; r.DY += ty; --r.NY;
+			r.ASX = r.SX; r.ADX = r.DX; r.ANX = nx;
+			if (--ny == 0) break;
+		}
+	}
+}
+template<typename Mode>
+static void stepHmmv(TestVRAM& vram, Regs& r, byte color,
+                     unsigned nx, unsigned ny, int tx, int ty)
+{
+	while (true) {
+		vram.cmdWrite(Mode::addressOf(r.ADX, r.DY, false), color,
+		              EmuTime::zero);
+		r.ADX += tx;
+		if (--r.ANX == 0) {
+			r.DY += ty; --r.NY;
+			r.ADX = r.DX; r.ANX = nx;
+			if (--ny == 0) break;
+		}
+	}
+}
+template<typename Mode>
+static void stepHmmm(TestVRAM& vram, Regs& r,
+                     unsigned nx, unsigned ny, int tx, int ty)
+{
+	while (true) {
+		byte p = vram.cmdReadWindow.readNP(
+			Mode::addressOf(r.ASX, r.SY, false));
+		vram.cmdWrite(Mode::addressOf(r.ADX, r.DY, false), p,
+		              EmuTime::zero);
+		r.ASX += tx; r.ADX += tx;
+		if (--r.ANX == 0) {
+			r.SY += ty; r.DY += ty; --r.NY;
+			r.ASX = r.SX; r.ADX = r.DX; r.ANX = nx;
+			if (--ny == 0) break;
+		}
+	}
+}
+template<typename Mode>
+static void stepYmmm(TestVRAM& vram, Regs& r,
+                     unsigned nx, unsigned ny, int tx, int ty)
+{
+	while (true) {
+		byte p = vram.cmdReadWindow.readNP(
+			Mode::addressOf(r.ADX, r.SY, false));
+		vram.cmdWrite(Mode::addressOf(r.ADX, r.DY, false), p,
+		              EmuTime::zero);
+		r.ADX += tx;
+		if (--r.ANX == 0) {
+			r.SY += ty; r.DY += ty; --r.NY;
+			r.ADX = r.DX; r.ANX = nx;
+			if (--ny == 0) break;
+		}
+	}
+}
+
+// Run all block commands both stepwise and in bulk, for a couple of
+// (clipped) positions, directions and sizes, including commands that
+// start halfway a row.
+template<typename Mode, typename LogOp>
+static void compare()
+{
+	const unsigned PPL = Mode::PIXELS_PER_LINE;
+	const unsigned PPB = Mode::PIXELS_PER_BYTE;
+	for (int dix = 0; dix < 2; ++dix) {
+	for (int diy = 0; diy < 2; ++diy) {
+	for (unsigned x : {0u, 3u, 101u, PPL - 5}) {
+	for (unsigned skip : {0u, 1u, 2u}) {
+		// clip like the command engine does
+		int txP = dix ? -1 : 1;
+		int txB = dix ? -int(PPB) : int(PPB);
+		int ty  = diy ? -1 : 1;
+		unsigned nxP = dix ? std::min(37u, x + 1) : std::min(37u, PPL - x);
+		unsigned xB = x & ~(PPB - 1);
+		unsigned nxB = nxP / PPB + 1;
+		nxB = dix ? std::min(nxB, xB / PPB + 1)
+		          : std::min(nxB, (PPL - xB) / PPB);
+		unsigned ny = 7;
+		Regs init = {};
+		init.SY = 300;
+		init.DY = 40;
+		init.NY = ny;
+
+		auto check = [&](unsigned nx, unsigned dx, int tx,
+		                 auto step, auto bulk) {
+			if (skip >= nx) return;
+			Regs r = init;
+			r.DX = dx; r.SX = dx ^ 1;
+			r.ASX = r.SX + skip * tx;
+			r.ADX = r.DX + skip * tx;
+			r.ANX = nx - skip;
+			TestVRAM vram1, vram2;
+			Regs r1 = r, r2 = r;
+			step(vram1, r1, nx, ny, tx, ty);
+			bulk(vram2, r2, nx, ny, tx, ty);
+			CHECK(r1 == r2);
+			CHECK(vram1.data == vram2.data);
+		};
+		byte cl = 0x56 & Mode::COLOR_MASK;
+		check(nxP, x, txP,
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				stepLmmv<Mode, LogOp>(v, r, cl, nx, ny2, tx, ty2); },
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				bulkLmmv<Mode, LogOp>(v, EmuTime::zero, cl, r.DX, nx, ny2,
+				                      tx, ty2, r.ADX, r.ANX, r.DY, r.NY); });
+		check(nxP, x, txP,
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				stepLmmm<Mode, LogOp>(v, r, nx, ny2, tx, ty2); },
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				bulkLmmm<Mode, LogOp>(v, EmuTime::zero, r.SX, r.DX, nx, ny2,
+				                      tx, ty2, r.ASX, r.ADX, r.ANX,
+				                      r.SY, r.DY, r.NY); });
+		check(nxB, xB, txB,
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				stepHmmv<Mode>(v, r, 0x9A, nx, ny2, tx, ty2); },
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				bulkHmmv<Mode>(v, 0x9A, r.DX, nx, ny2, tx, ty2,
+				               r.ADX, r.ANX, r.DY, r.NY); });
+		check(nxB, xB, txB,
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				stepHmmm<Mode>(v, r, nx, ny2, tx, ty2); },
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				bulkHmmm<Mode>(v, r.SX, r.DX, nx, ny2, tx, ty2,
+				               r.ASX, r.ADX, r.ANX, r.SY, r.DY, r.NY); });
+		check(nxB, xB, txB,
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				stepYmmm<Mode>(v, r, nx, ny2, tx, ty2); },
+			[&](TestVRAM& v, Regs& r, unsigned nx, unsigned ny2, int tx, int ty2) {
+				bulkYmmm<Mode>(v, r.DX, nx, ny2, tx, ty2,
+				               r.ADX, r.ANX, r.SY, r.DY, r.NY); });
+	}
+	}
+	}
+	}
+}
+
+TEST_CASE("VDPCmdBulk: bulk equals stepwise")
+{
+	SECTION("Graphic4") { compare<Graphic4Mode, ImpOp>();  compare<Graphic4Mode, TXorOp>(); }
+	SECTION("Graphic5") { compare<Graphic5Mode, ImpOp>();  compare<Graphic5Mode, TAndOp>(); }
+	SECTION("Graphic6") { compare<Graphic6Mode, ImpOp>();  compare<Graphic6Mode, NotOp>(); }
+	SECTION("Graphic7") { compare<Graphic7Mode, ImpOp>();  compare<Graphic7Mode, TOrOp>(); }
+	SECTION("NonBitmap") { compare<NonBitmapMode, ImpOp>(); compare<NonBitmapMode, XorOp>(); }
+}
+
+TEST_CASE("VDPCmdBulk: isUnobserved")
+{
+	TestVRAM vram;
+	SECTION("non-planar, 64kB VRAM") {
+		vram.size = 0x10000;
+		// rows 10-19 of a screen 5 page
+		CHECK( isUnobserved<Graphic4Mode>(vram, 0, 256, 0, 256, 10, 10, 1, 1));
+		// rows 510-519 are above 64kB
+		CHECK(!isUnobserved<Graphic4Mode>(vram, 0, 256, 0, 256, 510, 10, 1, 1));
+	}
+	SECTION("non-planar, observed region") {
+		vram.obsBegin = 0x0000; vram.obsEnd = 0x7FFF; // page 0
+		CHECK(!isUnobserved<Graphic4Mode>(vram, 0, 256, 0, 256, 250, 10, 1, 1));
+		CHECK( isUnobserved<Graphic4Mode>(vram, 0, 256, 0, 256, 256, 10, 1, 1));
+		// observed region at the same offset in the other 64kB bank
+		vram.obsBegin = 0x10000; vram.obsEnd = 0x17FFF;
+		CHECK( isUnobserved<Graphic4Mode>(vram, 0, 256, 0, 256, 0, 10, 1, 1));
+	}
+	SECTION("planar") {
+		// row 0 of screen 8 is at 0x00000-0x0007F and 0x10000-0x1007F
+		vram.obsBegin = 0x10040; vram.obsEnd = 0x10040;
+		CHECK(!isUnobserved<Graphic7Mode>(vram, 0, 256, 0, 256, 0, 1, 1, 1));
+		CHECK( isUnobserved<Graphic7Mode>(vram, 0, 256, 0, 256, 1, 1, 1, 1));
+		vram.obsBegin = 0x00040; vram.obsEnd = 0x00040;
+		CHECK(!isUnobserved<Graphic6Mode>(vram, 511, 512, 511, 512, 0, 1, -1, 1));
+		// 64kB VRAM: planar modes always need the second bank
+		vram.size = 0x10000;
+		CHECK(!isUnobserved<Graphic7Mode>(vram, 0, 256, 0, 256, 10, 1, 1, 1));
+	}
+}
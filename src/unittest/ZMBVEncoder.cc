@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "Benchmark.hh"
+#include "TestPixelFormat.hh"
+#include "ZMBVEncoder.hh"
+#include <SDL.h>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+
+// Create a sequence of frames that look a bit like a (scaled) MSX screen
+// while playing a game: a background pattern that scrolls horizontally in
+// the upper part of the screen, a static status bar in the lower part and
+// a couple of moving sprites.
+static std::vector<std::vector<uint32_t>> createFrames(
+	unsigned width, unsigned height, unsigned count)
+{
+	static const uint32_t palette[8] = {
+		0x000000, 0x21C842, 0x5EDC78, 0x5455ED,
+		0x7D76FC, 0xD4524D, 0x42EBF5, 0xFCFCFC,
+	};
+	unsigned scale = width / 320;
+	std::vector<std::vector<uint32_t>> result;
+	for (unsigned f = 0; f < count; ++f) {
+		std::vector<uint32_t> frame(width * height);
+		for (unsigned y = 0; y < height; ++y) {
+			for (unsigned x = 0; x < width; ++x) {
+				unsigned mx = x / scale;
+				unsigned my = y / scale;
+				unsigned c;
+				if (my < 192) {
+					unsigned sx = mx + f; // scrolling
+					unsigned tile = ((sx / 8) * 7 + (my / 8) * 3) % 5;
+					c = ((sx ^ my) & 4) ? tile : 0;
+				} else {
+					c = ((mx / 8 + my / 8) & 1) ? 7 : 3;
+				}
+				frame[y * width + x] = palette[c];
+			}
+		}
+		for (unsigned s = 0; s < 8; ++s) {
+			unsigned sx = (s * 37 + f * (s + 1)) % (320 - 16);
+			unsigned sy = (s * 23 + f * 2) % (192 - 16);
+			for (unsigned y = sy * scale; y < (sy + 16) * scale; ++y) {
+				for (unsigned x = sx * scale; x < (sx + 16) * scale; ++x) {
+					frame[y * width + x] = palette[5 + (s % 3)];
+				}
+			}
+		}
+		result.push_back(std::move(frame));
+	}
+	return result;
+}
+
+static std::vector<uint8_t> encode(ZMBVEncoder& encoder, bool keyFrame,
+                                   const void* pixels,
+                                   const SDL_PixelFormat& format)
+{
+	void* buffer;
+	unsigned written;
+	encoder.compressFrame(keyFrame, pixels, format, buffer, written);
+	auto* p = static_cast<uint8_t*>(buffer);
+	return std::vector<uint8_t>(p, p + written);
+}
+
+TEST_CASE("ZMBVEncoder: deterministic output")
+{
+	// The motion search runs in parallel, but that should not influence
+	// the result.
+	auto format = createFormat32();
+	auto frames = createFrames(320, 240, 10);
+	ZMBVEncoder encoder1(320, 240, 32);
+	ZMBVEncoder encoder2(320, 240, 32);
+	for (unsigned i = 0; i < frames.size(); ++i) {
+		bool keyFrame = (i == 0);
+		auto out1 = encode(encoder1, keyFrame, frames[i].data(), format);
+		auto out2 = encode(encoder2, keyFrame, frames[i].data(), format);
+		CHECK(out1 == out2);
+	}
+
+	// Repeating the previous frame (no pixel data) is the same as passing
+	// the previous frame again.
+	auto out1 = encode(encoder1, false, nullptr, format);
+	auto out2 = encode(encoder2, false, frames.back().data(), format);
+	CHECK(out1 == out2);
+}
+
+TEST_CASE("ZMBVEncoder: benchmark", "[.][benchmark]")
+{
+	auto format = createFormat32();
+	for (unsigned width : {320, 640, 960}) {
+		unsigned height = width * 3 / 4;
+		const unsigned COUNT = 100;
+		auto frames = createFrames(width, height, COUNT);
+		ZMBVEncoder encoder(width, height, 32);
+		size_t total = 0;
+
+		double seconds = measureSeconds([&] {
+			for (unsigned i = 0; i < COUNT; ++i) {
+				void* buffer;
+				unsigned written;
+				encoder.compressFrame((i % 300) == 0, frames[i].data(),
+				                      format, buffer, written);
+				total += written;
+			}
+		});
+		std::cout << width << 'x' << height << ": "
+		          << COUNT / seconds << " frames/s, "
+		          << total / COUNT << " bytes/frame" << std::endl;
+	}
+}
@@ -1,6 +1,11 @@
 #include "catch.hpp"
+#include "Benchmark.hh"
 #include "sha1.hh"
+#include "HostCPU.hh"
+#include <cstring>
+#include <iostream>
 #include <sstream>
+#include <vector>
 
 using namespace openmsx;
 
@@ -131,3 +136,58 @@ TEST_CASE("sha1: update,digest")
 		CHECK(sum.toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
 	}
 }
+
+static std::vector<uint8_t> createData(size_t size)
+{
+	std::vector<uint8_t> result(size);
+	uint32_t x = 12345;
+	for (auto& r : result) {
+		x = x * 1103515245 + 12345;
+		r = x >> 24;
+	}
+	return result;
+}
+
+TEST_CASE("sha1: SHA extensions")
+{
+	if (!HostCPU::hasSHA()) return;
+
+	auto data = createData(10000);
+	for (size_t len : {0, 1, 55, 56, 63, 64, 65, 127, 128, 129, 1000, 10000}) {
+		INFO(len);
+		Sha1Sum sum1 = SHA1::calc(data.data(), len);
+		HostCPU::setSHA(false);
+		Sha1Sum sum2 = SHA1::calc(data.data(), len);
+		HostCPU::setSHA(true);
+		CHECK(sum1 == sum2);
+	}
+
+	// several blocks in one update() call, with a partial block before
+	SHA1 sha1a, sha1b;
+	sha1a.update(data.data(), 10);
+	sha1a.update(data.data() + 10, 9990);
+	HostCPU::setSHA(false);
+	sha1b.update(data.data(), 10);
+	sha1b.update(data.data() + 10, 9990);
+	HostCPU::setSHA(true);
+	CHECK(sha1a.digest() == sha1b.digest());
+}
+
+TEST_CASE("sha1: benchmark", "[.][benchmark]")
+{
+	const size_t SIZE = 64 * 1024 * 1024;
+	auto data = createData(SIZE);
+	auto measure = [&](const char* name) {
+		Sha1Sum sum;
+		double seconds = measureSeconds([&] {
+			sum = SHA1::calc(data.data(), SIZE);
+		});
+		std::cout << name << ": " << SIZE / seconds / (1024 * 1024)
+		          << " MB/s (" << sum << ')' << std::endl;
+	};
+	bool sha = HostCPU::hasSHA();
+	if (sha) measure("sha1 SHA extensions");
+	HostCPU::setSHA(false);
+	measure("sha1 generic");
+	HostCPU::setSHA(sha);
+}
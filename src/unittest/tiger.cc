@@ -0,0 +1,139 @@
+#include "catch.hpp"
+#include "Benchmark.hh"
+#include "tiger.hh"
+#include "TigerTree.hh"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+class TTTestData final : public TTData
+{
+public:
+	explicit TTTestData(size_t size)
+		: buffer(size + 1) {}
+
+	uint8_t* getData(size_t offset, size_t /*size*/) override
+	{
+		return get() + offset;
+	}
+	bool isCacheStillValid(time_t& /*time*/) override
+	{
+		return false;
+	}
+	uint8_t* get() { return buffer.data() + 1; }
+
+private:
+	std::vector<uint8_t> buffer; // one extra byte in front, see getData()
+};
+
+TEST_CASE("tiger: leaves")
+{
+	std::vector<uint8_t> buffer(7 * 1024 + 1);
+	for (size_t i = 0; i < buffer.size(); ++i) {
+		buffer[i] = uint8_t(i * 7 + (i >> 10));
+	}
+	uint8_t* data = buffer.data() + 1;
+
+	TigerHash expected[7];
+	for (int i = 0; i < 7; ++i) {
+		tiger_leaf(data + i * 1024, expected[i]);
+	}
+	for (size_t count = 1; count <= 7; ++count) {
+		INFO(count);
+		const uint8_t* blocks[7];
+		TigerHash hashes[7];
+		TigerHash* results[7];
+		for (size_t i = 0; i < count; ++i) {
+			blocks[i] = data + i * 1024;
+			results[i] = &hashes[i];
+		}
+		tiger_leaves(blocks, results, count);
+		for (size_t i = 0; i < count; ++i) {
+			CHECK(hashes[i].toString() == expected[i].toString());
+		}
+	}
+}
+
+TEST_CASE("TigerTree")
+{
+	auto calc = [](TigerTree& tt) {
+		return tt.calcHash(nullptr).toString();
+	};
+
+	SECTION("zero sized buffer") {
+		TTTestData data(0);
+		TigerTree tt(data, 0, "tt0");
+		CHECK(calc(tt) == "LWPNACQDBZRYXW3VHJVCJ64QBZNGHOHHHZWCLNQ");
+	}
+	SECTION("size less than one block") {
+		TTTestData data(100);
+		TigerTree tt(data, 100, "tt1");
+		CHECK(calc(tt) == "EOIEKIQO6BSNCNRX2UB2MB466INV6LICZ6MPUWQ");
+		memset(data.get() + 20, 1, 10);
+		tt.notifyChange(20, 10, 0);
+		CHECK(calc(tt) == "GOTZVYW3WIE37XFCDOY66PLLXWGP6DPN3CQRHWA");
+	}
+	SECTION("3 full and one partial block") {
+		TTTestData data(4000);
+		TigerTree tt(data, 4000, "tt2");
+		CHECK(calc(tt) == "YC44NFWFCN3QWFRSS6ICGUJDLH7F654RCKVT7VY");
+		memset(data.get() + 1500, 1, 10);
+		tt.notifyChange(1500, 10, 0); // change a single block
+		CHECK(calc(tt) == "JU5RYR446PVZSPMOJML4IQ2FXLDDKE522CEYIBA");
+		memset(data.get() + 2000, 1, 100);
+		tt.notifyChange(2000, 100, 0); // change two blocks
+		CHECK(calc(tt) == "IPV53CDVB2I63HXIXVK2OUPNS26YB7V7G2Y7XIA");
+	}
+	SECTION("7 full blocks (unbalanced internal binary tree)") {
+		TTTestData data(7 * 1024);
+		TigerTree tt(data, 7 * 1024, "tt3");
+		CHECK(calc(tt) == "FPSZ35773WS4WGBVXM255KWNETQZXMTEJGFMLTA");
+		memset(data.get() + 512, 1, 512);
+		tt.notifyChange(512, 512, 0); // part of block-0
+		CHECK(calc(tt) == "Z32BC2WSHPW5DYUSNSZGLDIFTEIP3DBFJ7MG2MQ");
+		memset(data.get() + 3 * 1024, 1, 4 * 1024);
+		tt.notifyChange(3 * 1024, 4 * 1024, 0); // blocks 3-6
+		CHECK(calc(tt) == "SJUYB3QVIJXNKZMSQZGIMHA7GA2MYU2UECDA26A");
+	}
+}
+
+TEST_CASE("tiger: benchmark", "[.][benchmark]")
+{
+	const size_t NUM_BLOCKS = 64 * 1024; // 64MB
+	TTTestData data(NUM_BLOCKS * 1024);
+	for (size_t i = 0; i < NUM_BLOCKS * 1024; ++i) {
+		data.get()[i] = uint8_t(i * 7 + (i >> 10));
+	}
+	std::vector<TigerHash> hashes(NUM_BLOCKS);
+
+	auto report = [&](const char* name, double seconds) {
+		std::cout << name << ": " << NUM_BLOCKS / seconds / 1024
+		          << " MB/s" << std::endl;
+	};
+
+	report("tiger_leaf", measureSeconds([&] {
+		for (size_t i = 0; i < NUM_BLOCKS; ++i) {
+			tiger_leaf(data.get() + i * 1024, hashes[i]);
+		}
+	}));
+	report("tiger_leaves", measureSeconds([&] {
+		for (size_t i = 0; i < NUM_BLOCKS; i += 4) {
+			const uint8_t* blocks[4];
+			TigerHash* results[4];
+			for (int j = 0; j < 4; ++j) {
+				blocks [j] = data.get() + (i + j) * 1024;
+				results[j] = &hashes[i + j];
+			}
+			tiger_leaves(blocks, results, 4);
+		}
+	}));
+	std::string hash;
+	report("TigerTree", measureSeconds([&] {
+		TigerTree tt(data, NUM_BLOCKS * 1024, "benchmark");
+		hash = tt.calcHash(nullptr).toString();
+	}));
+	std::cout << "  " << hash << std::endl;
+}
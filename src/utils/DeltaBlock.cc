@@ -1,8 +1,10 @@
 #include "DeltaBlock.hh"
 #include "snappy.hh"
 #include "likely.hh"
+#include "Math.hh"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <tuple>
 #include <utility>
@@ -12,6 +14,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -44,32 +49,46 @@ static size_t loadUleb(const uint8_t*& data)
 }
 
 
-// --- Helper functions to compare {4,8,16} bytes at aligned memory locations ---
-
-template<int N> bool comp(const uint8_t* p, const uint8_t* q);
+// --- Helper functions to compare words of memory ---
 
-template<> bool comp<4>(const uint8_t* p, const uint8_t* q)
+// When AVX2 or SSE2 is available, we compare 32 or 16 bytes at-a-time using
+// vector instructions, otherwise we compare 4 or 8 bytes using integer
+// instructions. Note that (like the SSE4.1 and SSSE3 code elsewhere in
+// openMSX) this is a compile-time choice: the AVX2 path is only used when
+// compiling with e.g. -mavx2.
+//
+// The vector versions return a bitmask with a '1' for each pair of equal
+// bytes. This allows to locate the exact position of the first (mis)match
+// without an extra byte-at-a-time loop. The scalar version only tells whether
+// all bytes in the word are equal.
+#if defined(__AVX2__)
+static const int WORD_SIZE = sizeof(__m256i);
+static const unsigned ALL_EQUAL = 0xffffffff;
+static inline unsigned equalMask(const uint8_t* p, const uint8_t* q)
 {
-	return *reinterpret_cast<const uint32_t*>(p) ==
-	       *reinterpret_cast<const uint32_t*>(q);
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
 }
-
-template<> bool comp<8>(const uint8_t* p, const uint8_t* q)
-{
-	return *reinterpret_cast<const uint64_t*>(p) ==
-	       *reinterpret_cast<const uint64_t*>(q);
-}
-
-#ifdef __SSE2__
-template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
+#elif defined(__SSE2__)
+static const int WORD_SIZE = sizeof(__m128i);
+static const unsigned ALL_EQUAL = 0xffff;
+static inline unsigned equalMask(const uint8_t* p, const uint8_t* q)
 {
 	// Tests show that (on my machine) using 1 128-bit load is faster than
 	// 2 64-bit loads. Even though the actual comparison is slightly more
 	// complicated with SSE instructions.
-	__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
-	__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(q));
-	__m128i d = _mm_cmpeq_epi8(a, b);
-	return _mm_movemask_epi8(d) == 0xffff;
+	__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+}
+#else
+static const int WORD_SIZE = sizeof(void*);
+static inline bool comp(const uint8_t* p, const uint8_t* q)
+{
+	// Both pointers must be aligned.
+	return *reinterpret_cast<const uintptr_t*>(p) ==
+	       *reinterpret_cast<const uintptr_t*>(q);
 }
 #endif
 
@@ -89,24 +108,18 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 {
 	assert((p_end - p) == (q_end - q));
 
-	// When SSE is available, work with 16-byte words, otherwise 4 or 8
-	// bytes. This routine also benefits from AVX2 instructions. Though not
-	// all x86_64 CPUs have AVX2 (all have SSE2), so using them requires
-	// extra run-time checks and that's not worth it at this point.
-	static const int WORD_SIZE =
-#ifdef __SSE2__
-		sizeof(__m128i);
-#else
-		sizeof(void*);
-#endif
+	// Region too small.
+	if (unlikely((p_end - p) < (2 * WORD_SIZE))) goto end;
 
-	// Region too small or
-	// both buffers are differently aligned.
-	if (unlikely((p_end - p) < (2 * WORD_SIZE)) ||
-	    unlikely((reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
+#if !defined(__SSE2__)
+	// The scalar version requires both buffers to be equally aligned. The
+	// vector versions only align 'p' (unaligned loads are (nearly) as fast
+	// as aligned loads on CPUs that support SSE2).
+	if (unlikely((reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
 	             (reinterpret_cast<uintptr_t>(q) & (WORD_SIZE - 1)))) {
 		goto end;
 	}
+#endif
 
 	// Align to WORD_SIZE boundary. No need for end-of-buffer checks.
 	if (unlikely(reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1))) {
@@ -125,17 +138,30 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 		auto save = *sentinel;
 		*sentinel = ~q_end[-WORD_SIZE];
 
-		while (comp<WORD_SIZE>(p, q)) {
+#if defined(__SSE2__)
+		unsigned mask;
+		while ((mask = equalMask(p, q)) == ALL_EQUAL) {
 			p += WORD_SIZE; q += WORD_SIZE;
 		}
+		// Skip the equal bytes at the start of this word.
+		auto n = Math::findFirstSet(~mask) - 1;
+		p += n; q += n;
+#else
+		while (comp(p, q)) {
+			p += WORD_SIZE; q += WORD_SIZE;
+		}
+#endif
 
 		// Restore sentinel.
 		*sentinel = save;
 	}
 
 	// Slow path. This handles:
-	// - Small or differently aligned buffers.
+	// - Small or (for the scalar version) differently aligned buffers.
+	// - The remaining bytes in the mismatching word (scalar version).
 	// - The bytes at and after the (restored) sentinel.
+	// When the vector version found a real mismatch, this returns
+	// immediately.
 end:	return std::mismatch(p, p_end, q);
 }
 
@@ -145,17 +171,25 @@ end:	return std::mismatch(p, p_end, q);
 // Like scan_mismatch() above, but searches two buffers for the first
 // corresponding equal (instead of not-equal) bytes.
 //
-// Like scan_mismatch(), this places a temporary sentinel in the buffer, so the
+// The vector versions search word-at-a-time (no sentinel required), the tail
+// of the buffer (and the whole buffer for the scalar version) is handled
+// byte-at-a-time. The latter places a temporary sentinel in the buffer, so the
 // buffer cannot be read-only memory.
-//
-// Unlike scan_mismatch() it's less obvious how to perform this function
-// word-at-a-time (it's possible with some bit hacks). Though luckily this
-// function is also less performance critical.
 static std::pair<const uint8_t*, const uint8_t*> scan_match(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
 
+#if defined(__SSE2__)
+	while ((p_end - p) >= WORD_SIZE) {
+		if (unsigned mask = equalMask(p, q)) {
+			auto n = Math::findFirstSet(mask) - 1;
+			return {p + n, q + n};
+		}
+		p += WORD_SIZE; q += WORD_SIZE;
+	}
+#endif
+
 	// Code below is functionally equivalent to:
 	//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
 	//   return {p, q};
@@ -182,18 +216,21 @@ static std::pair<const uint8_t*, const uint8_t*> scan_match(
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
-static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, size_t size)
+// The scan functions (temporarily) place sentinels in their first buffer
+// argument. We pass 'newBuf' there because that's a private copy, while
+// 'oldBuf' may concurrently be read by other threads.
+static vector<uint8_t> calcDelta(const uint8_t* oldBuf, uint8_t* newBuf, size_t size)
 {
 	vector<uint8_t> result;
 
-	auto* p = oldBuf;
-	auto* q = newBuf;
+	const uint8_t* p = oldBuf;
+	const uint8_t* q = newBuf;
 	auto* p_end = p + size;
 	auto* q_end = q + size;
 
 	// scan equal bytes (possibly zero)
 	auto* q1 = q;
-	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+	std::tie(q, p) = scan_mismatch(q, q_end, p, p_end);
 	auto n1 = q - q1;
 	storeUleb(result, n1);
 
@@ -202,11 +239,11 @@ static vector<uint8_t> calcDelta(const uint8_t* oldBuf, const uint8_t* newBuf, s
 
 		auto* q2 = q;
 	different:
-		std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
+		std::tie(q, p) = scan_match(q + 1, q_end, p + 1, p_end);
 		auto n2 = q - q2;
 
 		auto* q3 = q;
-		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+		std::tie(q, p) = scan_mismatch(q, q_end, p, p_end);
 		auto n3 = q - q3;
 		if ((q != q_end) && (n3 <= 2)) goto different;
 
@@ -256,6 +293,7 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 	: block(size)
+	, uncompressedSize(size)
 	, compressedSize(0)
 {
 #ifdef DEBUG
@@ -273,6 +311,7 @@ DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 
 void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 {
+	std::lock_guard<std::mutex> lock(mutex);
 	if (compressed()) {
 		snappy::uncompress(
 			reinterpret_cast<const char*>(block.data()), compressedSize,
@@ -285,8 +324,16 @@ void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 #endif
 }
 
+size_t DeltaBlockCopy::getDataSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return compressed() ? compressedSize : uncompressedSize;
+}
+
 void DeltaBlockCopy::compress(size_t size)
 {
+	// Only the (single) thread calling compress() modifies 'block', so
+	// reading it without holding the lock is fine.
 	if (compressed()) return;
 
 	size_t dstLen = snappy::maxCompressedLength(size);
@@ -297,9 +344,12 @@ void DeltaBlockCopy::compress(size_t size)
 		// compression isn't beneficial
 		return;
 	}
-	compressedSize = dstLen;
-	block.swap(buf2);
-	block.resize(compressedSize); // shrink to fit
+	buf2.resize(dstLen); // shrink to fit
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		compressedSize = dstLen;
+		block.swap(buf2);
+	}
 	assert(compressed());
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
@@ -326,10 +376,22 @@ const uint8_t* DeltaBlockCopy::getData()
 
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
-		const uint8_t* data, size_t size)
+		const uint8_t* data, size_t size, ThreadPool& pool)
 	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data, size))
+	, copySize(size)
 {
+	// 'data' will change as soon as emulation continues, so take a copy.
+	auto copy = std::make_shared<MemBuffer<uint8_t>>(size);
+	memcpy(copy->data(), data, size);
+	done = pool.addTask([this, copy, size]() {
+		delta = calcDelta(prev->getData(), copy->data(), size);
+#if STATISTICS
+		allocSize = delta.size();
+		globalAllocSize += allocSize;
+		std::cout << "stat: DeltaBlockDiff " << globalAllocSize
+		          << " (+" << allocSize << ')' << std::endl;
+#endif
+	});
 #ifdef DEBUG
 	sha1 = SHA1::calc(data, size);
 
@@ -337,31 +399,62 @@ DeltaBlockDiff::DeltaBlockDiff(
 	apply(buf.data(), size);
 	assert(memcmp(buf.data(), data, size) == 0);
 #endif
-#if STATISTICS
-	allocSize = delta.size();
-	globalAllocSize += allocSize;
-	std::cout << "stat: DeltaBlockDiff " << globalAllocSize
-	          << " (+" << allocSize << ')' << std::endl;
-#endif
+}
+
+DeltaBlockDiff::~DeltaBlockDiff()
+{
+	// The task refers to 'this', it must be finished before we're gone.
+	done.wait();
 }
 
 void DeltaBlockDiff::apply(uint8_t* dst, size_t size) const
 {
 	prev->apply(dst, size);
+	done.get();
 	applyDeltaInPlace(dst, size, delta.data());
 #ifdef DEBUG
 	assert(SHA1::calc(dst, size) == sha1);
 #endif
 }
 
+size_t DeltaBlockDiff::getDataSize() const
+{
+	if (done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return copySize;
+	}
+	return delta.size();
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
+	done.get();
 	return delta.size();
 }
 
 
 // class LastDeltaBlocks
 
+LastDeltaBlocks::LastDeltaBlocks(ThreadPool& pool_)
+	: pool(pool_)
+{
+}
+
+void LastDeltaBlocks::compressAsync(
+	const std::shared_ptr<DeltaBlockCopy>& ref, Info& info)
+{
+	// Diffs against 'ref' read its uncompressed data, so compression has
+	// to wait for them. Those diffs were added to the pool earlier, so
+	// (because of the FIFO order) waiting for them from a pool thread
+	// cannot deadlock.
+	auto size = info.size;
+	auto pending = std::move(info.pending);
+	info.pending.clear();
+	pool.addTask([ref, size, pending]() {
+		for (auto& f : pending) f.wait();
+		ref->compress(size);
+	});
+}
+
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		const void* id, const uint8_t* data, size_t size)
 {
@@ -375,26 +468,42 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 	assert(it->id   == id);
 	assert(it->size == size);
 
+	// The size of the previous diff is only accounted for now, this gives
+	// its (asynchronous) calculation a full snapshot period to finish.
+	if (it->lastDiff) {
+		it->accSize += it->lastDiff->getDeltaSize();
+		it->lastDiff.reset();
+	}
+
 	auto ref = it->ref.lock();
 	if (it->accSize >= size || !ref) {
 		if (ref) {
 			// We will switch to a new DeltaBlockCopy object. So
 			// now is a good time to compress the old one.
-			ref->compress(size);
+			compressAsync(ref, *it);
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
 		auto b = std::make_shared<DeltaBlockCopy>(data, size);
 		it->ref = b;
 		it->last = b;
+		it->pending.clear();
 		it->accSize = 0;
 		return b;
 	} else {
 		// Create diff based on earlier reference block.
 		// Reference remains unchanged.
-		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size);
+		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size, pool);
 		it->last = b;
-		it->accSize += b->getDeltaSize();
+		it->lastDiff = b;
+		// forget about already finished diffs
+		auto& pending = it->pending;
+		pending.erase(std::remove_if(begin(pending), end(pending),
+			[](const std::shared_future<void>& f) {
+				return f.wait_for(std::chrono::seconds(0)) ==
+				       std::future_status::ready; }),
+			end(pending));
+		pending.push_back(b->getFuture());
 		return b;
 	}
 }
@@ -416,6 +525,8 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 		auto b = std::make_shared<DeltaBlockCopy>(data, size);
 		it->ref = b;
 		it->last = b;
+		it->lastDiff.reset();
+		it->pending.clear();
 		it->accSize = 0;
 		return b;
 	} else {
@@ -428,9 +539,9 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 
 void LastDeltaBlocks::clear()
 {
-	for (const Info& info : infos) {
+	for (Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			compressAsync(ref, info);
 		}
 	}
 	infos.clear();
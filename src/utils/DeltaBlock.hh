@@ -4,8 +4,11 @@
 #define STATISTICS 0
 
 #include "MemBuffer.hh"
+#include "ThreadPool.hh"
 #include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -23,6 +26,14 @@ public:
 #endif
 	virtual void apply(uint8_t* dst, size_t size) const = 0;
 
+	/** Number of bytes of (heap) memory used by this block. This does not
+	  * include the memory of the block returned by getBase().
+	  */
+	virtual size_t getDataSize() const = 0;
+
+	/** The block this block depends on (and shares), or nullptr. */
+	virtual const DeltaBlock* getBase() const { return nullptr; }
+
 protected:
 	DeltaBlock() = default;
 
@@ -44,34 +55,59 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	DeltaBlockCopy(const uint8_t* data, size_t size);
 	void apply(uint8_t* dst, size_t size) const override;
+	size_t getDataSize() const override;
 	void compress(size_t size);
 	const uint8_t* getData();
 
 private:
 	bool compressed() const { return compressedSize != 0; }
 
+	// compress() may run on a worker thread, concurrently with apply()
+	// on the main thread. This mutex protects swapping 'block' from its
+	// uncompressed to its compressed form.
+	mutable std::mutex mutex;
 	MemBuffer<uint8_t> block;
+	const size_t uncompressedSize;
 	size_t compressedSize;
 };
 
 
+/** The delta against 'prev' is calculated asynchronously on a ThreadPool.
+  * The constructor only makes a private copy of the data. Methods that need
+  * the delta (apply(), getDeltaSize()) block until the calculation is done.
+  * getDataSize() doesn't block, while the calculation is still running it
+  * returns the size of the private copy.
+  */
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
-	               const uint8_t* data, size_t size);
+	               const uint8_t* data, size_t size, ThreadPool& pool);
+	~DeltaBlockDiff();
 	void apply(uint8_t* dst, size_t size) const override;
+	size_t getDataSize() const override;
+	const DeltaBlock* getBase() const override { return prev.get(); }
 	size_t getDeltaSize() const;
+	const std::shared_future<void>& getFuture() const { return done; }
 
 private:
 	const std::shared_ptr<DeltaBlockCopy> prev;
-	const std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	std::shared_future<void> done;
+	const size_t copySize;
 };
 
 
+/** Creates DeltaBlocks for consecutive snapshots of the same memory blocks.
+  * The expensive work (calculating deltas and compressing no longer used
+  * reference blocks) is offloaded to the given (shared) ThreadPool, so that
+  * taking a snapshot on the emulation thread is not much more than a memcpy.
+  */
 class LastDeltaBlocks
 {
 public:
+	explicit LastDeltaBlocks(ThreadPool& pool);
+
 	std::shared_ptr<DeltaBlock> createNew(
 		const void* id, const uint8_t* data, size_t size);
 	std::shared_ptr<DeltaBlock> createNullDiff(
@@ -87,10 +123,18 @@ private:
 		size_t size;
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
+		// Most recent diff, its size is not yet added to 'accSize'.
+		std::shared_ptr<DeltaBlockDiff> lastDiff;
+		// Diffs against 'ref' that might still be in progress. 'ref'
+		// can only be compressed after those have finished.
+		std::vector<std::shared_future<void>> pending;
 		size_t accSize;
 	};
 
+	void compressAsync(const std::shared_ptr<DeltaBlockCopy>& ref, Info& info);
+
 	std::vector<Info> infos;
+	ThreadPool& pool;
 };
 
 } // namespace openmsx
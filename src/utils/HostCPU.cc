@@ -0,0 +1,53 @@
+#include "HostCPU.hh"
+#if HAVE_SHA_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace openmsx {
+namespace HostCPU {
+
+static bool detectAVX2()
+{
+#if HAVE_AVX2_DISPATCH
+	// Required when called during static initialization.
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+static bool detectSHA()
+{
+#if HAVE_SHA_DISPATCH
+	// Not all compilers know "sha" in __builtin_cpu_supports(), so query
+	// cpuid directly. SHA is in leaf 7, ebx bit 29, SSE4.1 in leaf 1,
+	// ecx bit 19. These instructions don't need any OS support.
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	if (!(ecx & (1 << 19))) return false;
+	if (__get_cpuid_max(0, nullptr) < 7) return false;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & (1 << 29)) != 0;
+#else
+	return false;
+#endif
+}
+
+namespace detail {
+	bool avx2 = detectAVX2();
+	bool sha  = detectSHA();
+}
+
+void setAVX2(bool enabled)
+{
+	detail::avx2 = enabled && detectAVX2();
+}
+
+void setSHA(bool enabled)
+{
+	detail::sha = enabled && detectSHA();
+}
+
+} // namespace HostCPU
+} // namespace openmsx
@@ -0,0 +1,59 @@
+#ifndef HOSTCPU_HH
+#define HOSTCPU_HH
+
+#include "build-info.hh"
+
+// Some routines have an AVX2 version that's compiled in addition to the
+// normal (SSE2 or C++) version. The AVX2 functions are marked with
+// AVX2_TARGET and may only be called when HostCPU::hasAVX2() returns true.
+// This requires per-function target attributes, so it's only available on
+// gcc and clang (which also provide the necessary run-time check).
+//
+// Similarly, the SHA-1 code has a version that uses the SHA extensions
+// (SHA-NI), marked with SHA_TARGET and guarded by HostCPU::hasSHA().
+#if ASM_X86 && defined(__GNUC__)
+#define HAVE_AVX2_DISPATCH 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define HAVE_SHA_DISPATCH 1
+#define SHA_TARGET __attribute__((target("sha,sse4.1")))
+#else
+#define HAVE_AVX2_DISPATCH 0
+#define AVX2_TARGET
+#define HAVE_SHA_DISPATCH 0
+#define SHA_TARGET
+#endif
+
+namespace openmsx {
+
+/** Run-time detection of CPU features.
+  */
+namespace HostCPU {
+
+	namespace detail {
+		extern bool avx2; // see hasAVX2()
+		extern bool sha;  // see hasSHA()
+	}
+
+	/** Does the host CPU (and OS) support the AVX2 instruction set?
+	  * This is determined once at startup, checking it is cheap.
+	  */
+	inline bool hasAVX2() { return detail::avx2; }
+
+	/** Pretend that the host CPU doesn't support AVX2 (or enable it
+	  * again, but only if it's really supported). Only meant for unittests
+	  * and benchmarks, to compare the AVX2 and the non-AVX2 routines.
+	  */
+	void setAVX2(bool enabled);
+
+	/** Does the host CPU support the SHA extensions (and SSE4.1, which
+	  * is used together with them)?
+	  */
+	inline bool hasSHA() { return detail::sha; }
+
+	/** Like setAVX2(), but for the SHA extensions. */
+	void setSHA(bool enabled);
+
+} // namespace HostCPU
+} // namespace openmsx
+
+#endif
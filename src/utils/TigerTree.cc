@@ -84,6 +84,7 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 	if (!entry.valid[n]) {
 		if (n & 1) {
 			// interior node
+			if (node.l == 4) calcLeaves(node, progressCallback);
 			auto left  = getLeftChild (node);
 			auto right = getRightChild(node);
 			auto& h1 = calcHash(left, progressCallback);
@@ -115,6 +116,39 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 	return entry.hash[n];
 }
 
+void TigerTree::calcLeaves(Node node, const std::function<void(size_t, size_t)>& progressCallback)
+{
+	// Hash the (invalid, full) leaves below this level-4 node at once,
+	// that's a lot faster than one at a time (see tiger_leaves()). A
+	// partial last block is handled in the normal way.
+	assert(node.l == 4);
+	uint8_t buffer[4][BLOCK_SIZE];
+	const uint8_t* blocks[4];
+	TigerHash* results[4];
+	size_t leaves[4];
+	size_t count = 0;
+	for (size_t leaf = node.n - 3; leaf <= node.n + 3; leaf += 2) {
+		if (leaf >= entry.numNodes) break;
+		if (entry.valid[leaf]) continue;
+		size_t b = leaf * (BLOCK_SIZE / 2);
+		if ((dataSize - b) < BLOCK_SIZE) break; // partial last block
+		// getData() may reuse its buffer, so make a copy
+		memcpy(buffer[count], data.getData(b, BLOCK_SIZE), BLOCK_SIZE);
+		blocks[count] = buffer[count];
+		results[count] = &entry.hash[leaf];
+		leaves[count] = leaf;
+		++count;
+	}
+	tiger_leaves(blocks, results, count);
+	for (size_t i = 0; i < count; ++i) {
+		entry.valid[leaves[i]] = true;
+		entry.numNodesValid++;
+		if (progressCallback) {
+			progressCallback(entry.numNodesValid, entry.numNodes);
+		}
+	}
+}
+
 
 // The TigerTree::nodes member variable stores a linearized binary tree. The
 // linearization is done like in this example:
@@ -182,70 +216,3 @@ TigerTree::Node TigerTree::getRightChild(Node node) const
 
 } // namespace openmsx
 
-
-#if 0
-
-// Unittest
-
-class TTTestData : public openmsx::TTData
-{
-public:
-	uint8_t* getData(size_t offset, size_t size) override
-	{
-		return buffer + offset;
-	}
-	uint8_t* buffer;
-};
-
-int main()
-{
-	uint8_t buffer_[8192 + 1];
-	uint8_t* buffer = buffer_ + 1;
-	TTTestData data;
-	data.buffer = buffer;
-
-	// zero sized buffer
-	openmsx::TigerTree tt0(data, 0);
-	assert(tt0.calcHash().toString() ==
-	       "LWPNACQDBZRYXW3VHJVCJ64QBZNGHOHHHZWCLNQ");
-
-	// size less than one block
-	openmsx::TigerTree tt1(data, 100);
-	memset(buffer, 0, 100);
-	assert(tt1.calcHash().toString() ==
-	       "EOIEKIQO6BSNCNRX2UB2MB466INV6LICZ6MPUWQ");
-	memset(buffer + 20, 1, 10);
-	tt1.notifyChange(20, 10);
-	assert(tt1.calcHash().toString() ==
-	       "GOTZVYW3WIE37XFCDOY66PLLXWGP6DPN3CQRHWA");
-
-	// 3 full and one partial block
-	openmsx::TigerTree tt2(data, 4000);
-	memset(buffer, 0, 4000);
-	assert(tt2.calcHash().toString() ==
-	       "YC44NFWFCN3QWFRSS6ICGUJDLH7F654RCKVT7VY");
-	memset(buffer + 1500, 1, 10);
-	tt2.notifyChange(1500, 10); // change a single block
-	assert(tt2.calcHash().toString() ==
-	       "JU5RYR446PVZSPMOJML4IQ2FXLDDKE522CEYIBA");
-	memset(buffer + 2000, 1, 100);
-	tt2.notifyChange(2000, 100); // change two blocks
-	assert(tt2.calcHash().toString() ==
-	       "IPV53CDVB2I63HXIXVK2OUPNS26YB7V7G2Y7XIA");
-
-	// 7 full blocks (unbalanced internal binary tree)
-	openmsx::TigerTree tt3(data, 7 * 1024);
-	memset(buffer, 0, 7 * 1024);
-	assert(tt3.calcHash().toString() ==
-	       "FPSZ35773WS4WGBVXM255KWNETQZXMTEJGFMLTA");
-	memset(buffer + 512, 1, 512);
-	tt3.notifyChange(512, 512); // part of block-0
-	assert(tt3.calcHash().toString() ==
-	       "Z32BC2WSHPW5DYUSNSZGLDIFTEIP3DBFJ7MG2MQ");
-	memset(buffer + 3*1024, 1, 4*1024);
-	tt3.notifyChange(3*1024, 4*1024); // blocks 3-6
-	assert(tt3.calcHash().toString() ==
-	       "SJUYB3QVIJXNKZMSQZGIMHA7GA2MYU2UECDA26A");
-}
-
-#endif
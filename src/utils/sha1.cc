@@ -20,6 +20,7 @@ A million repetitions of "a"
 
 #include "sha1.hh"
 #include "MSXException.hh"
+#include "HostCPU.hh"
 #include "endian.hh"
 #include "likely.hh"
 #include <cassert>
@@ -27,6 +28,9 @@ A million repetitions of "a"
 #ifdef __SSE2__
 #include <emmintrin.h> // SSE2
 #endif
+#if HAVE_SHA_DISPATCH
+#include <immintrin.h> // SHA, SSE4.1
+#endif
 
 using std::string;
 
@@ -268,6 +272,85 @@ SHA1::SHA1()
 	m_finalized = false;
 }
 
+#if HAVE_SHA_DISPATCH
+// One group of 4 rounds (out of 20 groups) using the SHA extensions. The
+// message schedule for the later groups is computed along the way, in the
+// 4 registers in 'msg'. The round constant and function (the last argument
+// of sha1rnds4) change every 5 groups.
+template<int G>
+SHA_TARGET static inline void shaGroup(
+	__m128i& abcd, __m128i& e0, __m128i& e1, __m128i msg[4])
+{
+	__m128i& e    = (G & 1) ? e1 : e0;
+	__m128i& next = (G & 1) ? e0 : e1;
+	__m128i m = msg[G & 3];
+	e = (G == 0) ? _mm_add_epi32(e, m) : _mm_sha1nexte_epu32(e, m);
+	next = abcd;
+	if ((3 <= G) && (G <= 18)) {
+		msg[(G + 1) & 3] = _mm_sha1msg2_epu32(msg[(G + 1) & 3], m);
+	}
+	abcd = _mm_sha1rnds4_epu32(abcd, e, G / 5);
+	if ((1 <= G) && (G <= 16)) {
+		msg[(G + 3) & 3] = _mm_sha1msg1_epu32(msg[(G + 3) & 3], m);
+	}
+	if ((2 <= G) && (G <= 17)) {
+		msg[(G + 2) & 3] = _mm_xor_si128(msg[(G + 2) & 3], m);
+	}
+}
+
+SHA_TARGET static void transformSHA(
+	uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	const __m128i mask = _mm_set_epi64x(
+		0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+
+	__m128i abcd = _mm_loadu_si128(reinterpret_cast<__m128i*>(state));
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	__m128i e1;
+	__m128i msg[4];
+
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		__m128i abcdSave = abcd;
+		__m128i e0Save = e0;
+		for (int i = 0; i < 4; ++i) {
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(data + 16 * i)),
+				mask);
+		}
+		shaGroup< 0>(abcd, e0, e1, msg); shaGroup< 1>(abcd, e0, e1, msg);
+		shaGroup< 2>(abcd, e0, e1, msg); shaGroup< 3>(abcd, e0, e1, msg);
+		shaGroup< 4>(abcd, e0, e1, msg); shaGroup< 5>(abcd, e0, e1, msg);
+		shaGroup< 6>(abcd, e0, e1, msg); shaGroup< 7>(abcd, e0, e1, msg);
+		shaGroup< 8>(abcd, e0, e1, msg); shaGroup< 9>(abcd, e0, e1, msg);
+		shaGroup<10>(abcd, e0, e1, msg); shaGroup<11>(abcd, e0, e1, msg);
+		shaGroup<12>(abcd, e0, e1, msg); shaGroup<13>(abcd, e0, e1, msg);
+		shaGroup<14>(abcd, e0, e1, msg); shaGroup<15>(abcd, e0, e1, msg);
+		shaGroup<16>(abcd, e0, e1, msg); shaGroup<17>(abcd, e0, e1, msg);
+		shaGroup<18>(abcd, e0, e1, msg); shaGroup<19>(abcd, e0, e1, msg);
+		e0 = _mm_sha1nexte_epu32(e0, e0Save);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+	}
+
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+#endif
+
+void SHA1::transform(const uint8_t* data, size_t numBlocks)
+{
+#if HAVE_SHA_DISPATCH
+	if (HostCPU::hasSHA()) {
+		transformSHA(m_state.a, data, numBlocks);
+		return;
+	}
+#endif
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		transform(data);
+	}
+}
+
 void SHA1::transform(const uint8_t buffer[64])
 {
 	WorkspaceBlock block(buffer);
@@ -327,10 +410,10 @@ void SHA1::update(const uint8_t* data, size_t len)
 	size_t i;
 	if ((j + len) > 63) {
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		transform(m_buffer);
-		for (; i + 63 < len; i += 64) {
-			transform(&data[i]);
-		}
+		transform(m_buffer, 1);
+		size_t numBlocks = (len - i) / 64;
+		transform(&data[i], numBlocks);
+		i += numBlocks * 64;
 		j = 0;
 	} else {
 		i = 0;
@@ -91,6 +91,7 @@ public:
 	static Sha1Sum calc(const uint8_t* data, size_t len);
 
 private:
+	void transform(const uint8_t* data, size_t numBlocks);
 	void transform(const uint8_t buffer[64]);
 	void finalize();
 
@@ -568,89 +568,78 @@ static inline void round(uint64_t& a, uint64_t& b, uint64_t& c, uint64_t x, int
 	b *= mul;
 }
 
+static inline void keySchedule(uint64_t x[8])
+{
+	x[0] -= x[7] ^ 0xA5A5A5A5A5A5A5A5LL;
+	x[1] ^= x[0];
+	x[2] += x[1];
+	x[3] -= x[2] ^ ((~x[1]) << 19);
+	x[4] ^= x[3];
+	x[5] += x[4];
+	x[6] -= x[5] ^ ((~x[4]) >> 23);
+	x[7] ^= x[6];
+	x[0] += x[7];
+	x[1] -= x[0] ^ ((~x[7]) << 19);
+	x[2] ^= x[1];
+	x[3] += x[2];
+	x[4] -= x[3] ^ ((~x[2]) >> 23);
+	x[5] ^= x[4];
+	x[6] += x[5];
+	x[7] -= x[6] ^ 0x0123456789ABCDEFLL;
+}
+
+// Execute the same round for N independent lanes (see tiger_leaves()).
+template<int N>
+static inline void roundN(uint64_t* a, uint64_t* b, uint64_t* c,
+                          uint64_t (*x)[8], int i, int mul)
+{
+	for (int k = 0; k < N; ++k) round(a[k], b[k], c[k], x[k][i], mul);
+}
+
+template<int N>
+static inline void pass(uint64_t* a, uint64_t* b, uint64_t* c,
+                        uint64_t (*x)[8], int mul)
+{
+	roundN<N>(a, b, c, x, 0, mul);
+	roundN<N>(b, c, a, x, 1, mul);
+	roundN<N>(c, a, b, x, 2, mul);
+	roundN<N>(a, b, c, x, 3, mul);
+	roundN<N>(b, c, a, x, 4, mul);
+	roundN<N>(c, a, b, x, 5, mul);
+	roundN<N>(a, b, c, x, 6, mul);
+	roundN<N>(b, c, a, x, 7, mul);
+}
+
+// Compress N independent 64-byte blocks (each with its own state).
+template<int N>
+static inline void tiger_compressN(const uint8_t* const* str, uint64_t (*state)[3])
+{
+	uint64_t a[N], b[N], c[N], x[N][8];
+	for (int k = 0; k < N; ++k) {
+		a[k] = state[k][0];
+		b[k] = state[k][1];
+		c[k] = state[k][2];
+		for (int i = 0; i < 8; ++i) {
+			x[k][i] = Endian::read_UA_L64(str[k] + 8 * i);
+		}
+	}
+
+	pass<N>(a, b, c, x, 5);
+	for (int k = 0; k < N; ++k) keySchedule(x[k]);
+	pass<N>(c, a, b, x, 7);
+	for (int k = 0; k < N; ++k) keySchedule(x[k]);
+	pass<N>(b, c, a, x, 9);
+
+	for (int k = 0; k < N; ++k) {
+		state[k][0] ^= a[k];
+		state[k][1]  = b[k] - state[k][1];
+		state[k][2] += c[k];
+	}
+}
+
 static void tiger_compress(const uint8_t* str, uint64_t state[3])
 {
-	uint64_t a = state[0];
-	uint64_t b = state[1];
-	uint64_t c = state[2];
-
-	uint64_t x0 = Endian::read_UA_L64(str +  0);
-	uint64_t x1 = Endian::read_UA_L64(str +  8);
-	uint64_t x2 = Endian::read_UA_L64(str + 16);
-	uint64_t x3 = Endian::read_UA_L64(str + 24);
-	uint64_t x4 = Endian::read_UA_L64(str + 32);
-	uint64_t x5 = Endian::read_UA_L64(str + 40);
-	uint64_t x6 = Endian::read_UA_L64(str + 48);
-	uint64_t x7 = Endian::read_UA_L64(str + 56);
-
-	uint64_t aa = a;
-	uint64_t bb = b;
-	uint64_t cc = c;
-
-	round(a, b, c, x0, 5);
-	round(b, c, a, x1, 5);
-	round(c, a, b, x2, 5);
-	round(a, b, c, x3, 5);
-	round(b, c, a, x4, 5);
-	round(c, a, b, x5, 5);
-	round(a, b, c, x6, 5);
-	round(b, c, a, x7, 5);
-
-	x0 -= x7 ^ 0xA5A5A5A5A5A5A5A5LL;
-	x1 ^= x0;
-	x2 += x1;
-	x3 -= x2 ^ ((~x1) << 19);
-	x4 ^= x3;
-	x5 += x4;
-	x6 -= x5 ^ ((~x4) >> 23);
-	x7 ^= x6;
-	x0 += x7;
-	x1 -= x0 ^ ((~x7) << 19);
-	x2 ^= x1;
-	x3 += x2;
-	x4 -= x3 ^ ((~x2) >> 23);
-	x5 ^= x4;
-	x6 += x5;
-	x7 -= x6 ^ 0x0123456789ABCDEFLL;
-
-	round(c, a, b, x0, 7);
-	round(a, b, c, x1, 7);
-	round(b, c, a, x2, 7);
-	round(c, a, b, x3, 7);
-	round(a, b, c, x4, 7);
-	round(b, c, a, x5, 7);
-	round(c, a, b, x6, 7);
-	round(a, b, c, x7, 7);
-
-	x0 -= x7 ^ 0xA5A5A5A5A5A5A5A5LL;
-	x1 ^= x0;
-	x2 += x1;
-	x3 -= x2 ^ ((~x1) << 19);
-	x4 ^= x3;
-	x5 += x4;
-	x6 -= x5 ^ ((~x4) >> 23);
-	x7 ^= x6;
-	x0 += x7;
-	x1 -= x0 ^ ((~x7) << 19);
-	x2 ^= x1;
-	x3 += x2;
-	x4 -= x3 ^ ((~x2) >> 23);
-	x5 ^= x4;
-	x6 += x5;
-	x7 -= x6 ^ 0x0123456789ABCDEFLL;
-
-	round(b, c, a, x0, 9);
-	round(c, a, b, x1, 9);
-	round(a, b, c, x2, 9);
-	round(b, c, a, x3, 9);
-	round(c, a, b, x4, 9);
-	round(a, b, c, x5, 9);
-	round(b, c, a, x6, 9);
-	round(c, a, b, x7, 9);
-
-	state[0] = a ^ aa;
-	state[1] = b - bb;
-	state[2] = c + cc;
+	tiger_compressN<1>(&str, reinterpret_cast<uint64_t(*)[3]>(state));
 }
 
 static inline void initState(uint64_t state[3])
@@ -754,4 +743,56 @@ void tiger_leaf(/*const*/ uint8_t data[1024], TigerHash& result)
 	returnState(result.h64);
 }
 
+template<int N>
+static void tiger_leavesN(const uint8_t* const* data, TigerHash* result)
+{
+	// Like tiger_leaf(), but (to not have to modify the data) the first
+	// and the last block are assembled in a local buffer.
+	uint8_t first[N][64];
+	uint8_t last[N][64];
+	const uint8_t* str[N];
+	uint64_t state[N][3];
+	for (int k = 0; k < N; ++k) {
+		first[k][0] = 0x00;
+		memcpy(&first[k][1], data[k], 63);
+		memset(last[k], 0, 64);
+		last[k][ 0] = data[k][1023];
+		last[k][ 1] = 0x01;
+		last[k][56] = 0x08;
+		last[k][57] = 0x20;
+		initState(state[k]);
+		str[k] = first[k];
+	}
+	tiger_compressN<N>(str, state);
+	for (int i = 1; i < 16; ++i) {
+		for (int k = 0; k < N; ++k) str[k] = data[k] - 1 + i * 64;
+		tiger_compressN<N>(str, state);
+	}
+	for (int k = 0; k < N; ++k) str[k] = last[k];
+	tiger_compressN<N>(str, state);
+
+	for (int k = 0; k < N; ++k) {
+		memcpy(result[k].h64, state[k], sizeof(state[k]));
+		returnState(result[k].h64);
+	}
+}
+
+void tiger_leaves(const uint8_t* const data[], TigerHash* const result[],
+                  size_t count)
+{
+	TigerHash tmp[4];
+	while (count != 0) {
+		size_t n;
+		if (count >= 4) {
+			tiger_leavesN<4>(data, tmp); n = 4;
+		} else if (count >= 2) {
+			tiger_leavesN<2>(data, tmp); n = 2;
+		} else {
+			tiger_leavesN<1>(data, tmp); n = 1;
+		}
+		for (size_t k = 0; k < n; ++k) *result[k] = tmp[k];
+		data += n; result += n; count -= n;
+	}
+}
+
 } // namespace openmsx
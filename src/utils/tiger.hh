@@ -59,6 +59,17 @@ void tiger_int(const TigerHash& h0, const TigerHash& h1, TigerHash& result);
  */
 void tiger_leaf(/*const*/ uint8_t data[1024], TigerHash& result);
 
+/** Calculate the tiger-tree leaf node hashes of several 1024-byte blocks.
+ * Gives the same result as calling tiger_leaf() for each block, but it's
+ * faster: the blocks are hashed in groups of (up to) 4, interleaved. Each
+ * hash is a long chain of dependent table lookups, hashing independent
+ * blocks at the same time keeps the CPU a lot busier.
+ * Unlike tiger_leaf(), this function doesn't modify the data and it is
+ * reentrant.
+ */
+void tiger_leaves(const uint8_t* const data[], TigerHash* const result[],
+                  size_t count);
+
 } // namespace openmsx
 
 #endif
@@ -1,5 +1,6 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
+#include "RawVideoWriter.hh"
 #include "WavWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
@@ -11,17 +12,30 @@
 #include "Filename.hh"
 #include "CliComm.hh"
 #include "FileOperations.hh"
+#include "GlobalSettings.hh"
+#include "ThrottleManager.hh"
+#include "ThreadPool.hh"
+#include "FrameSource.hh"
 #include "TclObject.hh"
 #include "memory.hh"
+#include "strCat.hh"
 #include "outer.hh"
 #include "vla.hh"
+#include <SDL.h>
 #include <cassert>
+#include <chrono>
 
 using std::string;
 using std::vector;
 
 namespace openmsx {
 
+// Maximum number of video frames that are captured but not yet encoded.
+// Limits the memory usage (a 960x720 frame takes 2.7MB) and the delay.
+static const unsigned MAX_QUEUED_IMAGES = 8;
+// Also limit the number of dropped frames (these are cheap, only audio).
+static const unsigned MAX_PENDING_FRAMES = 4 * MAX_QUEUED_IMAGES;
+
 AviRecorder::AviRecorder(Reactor& reactor_)
 	: reactor(reactor_)
 	, recordCommand(reactor.getCommandController())
@@ -29,6 +43,8 @@ AviRecorder::AviRecorder(Reactor& reactor_)
 	, duration(EmuDuration::infinity)
 	, prevTime(EmuTime::infinity)
 	, frameHeight(0)
+	, numQueuedImages(0)
+	, droppedFrames(0)
 {
 }
 
@@ -36,10 +52,12 @@ AviRecorder::~AviRecorder()
 {
 	assert(!aviWriter);
 	assert(!wavWriter);
+	assert(!rawWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, bool recordRaw,
+                        const Filename& filename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -79,15 +97,29 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		warnedFps = false;
 		duration = EmuDuration::infinity;
 		prevTime = EmuTime::infinity;
+		droppedFrames = 0;
 
+		unsigned channels = (recordAudio && stereo) ? 2 : 1;
 		try {
-			aviWriter = make_unique<AviWriter>(
-				filename, frameWidth, frameHeight, bpp,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			if (recordRaw) {
+				rawWriter = make_unique<RawVideoWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			} else {
+				aviWriter = make_unique<AviWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			}
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
 		}
+		if (aviWriter) {
+			// Encoding and writing is done in a separate thread,
+			// see addImage(). A single thread keeps the frames in
+			// order.
+			encoder = make_unique<ThreadPool>(1);
+		}
 	} else {
 		assert(recordAudio);
 		wavWriter = make_unique<Wav16Writer>(
@@ -111,8 +143,49 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
+	finishAllFrames();
+	encoder.reset();
+	freeFrames.clear();
 	aviWriter.reset();
 	wavWriter.reset();
+	rawWriter.reset();
+}
+
+bool AviRecorder::isRecording() const
+{
+	return aviWriter || wavWriter || rawWriter;
+}
+
+void AviRecorder::finishFrame()
+{
+	// Wait for the oldest pending frame, then recycle it.
+	auto pending = std::move(pendingFrames.front());
+	pendingFrames.pop_front();
+	if (!pending.second->repeat) {
+		assert(numQueuedImages > 0);
+		--numQueuedImages;
+	}
+	freeFrames.push_back(std::move(pending.second));
+	pending.first.get(); // rethrows errors from the encoder thread
+}
+
+void AviRecorder::finishAllFrames()
+{
+	bool reported = false;
+	while (!pendingFrames.empty()) {
+		try {
+			finishFrame();
+		} catch (MSXException& e) {
+			// Most likely all remaining frames fail for the same
+			// reason, only report the first one.
+			if (!reported) {
+				reactor.getCliComm().printWarning(
+					"Error while writing video: " +
+					e.getMessage());
+				reported = true;
+			}
+		}
+	}
 }
 
 void AviRecorder::addWave(unsigned num, int16_t* data)
@@ -128,7 +201,7 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 		if (wavWriter) {
 			wavWriter->write(data, 2, num);
 		} else {
-			assert(aviWriter);
+			assert(aviWriter || rawWriter);
 			audioBuf.insert(end(audioBuf), data, data + 2 * num);
 		}
 	} else {
@@ -153,7 +226,7 @@ void AviRecorder::addWave(unsigned num, int16_t* data)
 		if (wavWriter) {
 			wavWriter->write(buf, 1, num);
 		} else {
-			assert(aviWriter);
+			assert(aviWriter || rawWriter);
 			audioBuf.insert(end(audioBuf), buf, buf + num);
 		}
 	}
@@ -172,15 +245,81 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity) {
 		duration = time - prevTime;
-		aviWriter->setFps(1.0 / duration.toDouble());
+		float fps = 1.0 / duration.toDouble();
+		if (rawWriter) {
+			rawWriter->setFps(fps);
+		} else {
+			aviWriter->setFps(fps);
+		}
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
+
+	if (rawWriter) {
+		// No encoding at all, just a copy of the frame.
+		rawWriter->addFrame(frame, unsigned(audioBuf.size()),
+		                    audioBuf.data());
+		audioBuf.clear();
+		return;
+	}
+
+	// Encoding a frame is expensive, so it's done in a separate thread.
+	// Here we only copy the frame (and its audio) to a queue. First
+	// recycle the frames that were already written.
+	while (!pendingFrames.empty() &&
+	       (pendingFrames.front().first.wait_for(std::chrono::seconds(0)) ==
+	        std::future_status::ready)) {
+		finishFrame();
+	}
+	bool drop = false;
+	if (numQueuedImages >= MAX_QUEUED_IMAGES) {
+		auto& throttleManager =
+			reactor.getGlobalSettings().getThrottleManager();
+		if (throttleManager.isThrottled()) {
+			// The encoder can't keep up with real time. Rather
+			// than slowing down the emulation, repeat the previous
+			// frame in the video.
+			drop = true;
+			++droppedFrames;
+		} else {
+			// Not running in real time, so we can just as well
+			// wait for the encoder.
+			while (numQueuedImages >= MAX_QUEUED_IMAGES) {
+				finishFrame();
+			}
+		}
+	}
+	while (pendingFrames.size() >= MAX_PENDING_FRAMES) {
+		finishFrame();
+	}
+
+	std::shared_ptr<Frame> f;
+	if (freeFrames.empty()) {
+		f = std::make_shared<Frame>();
+	} else {
+		f = std::move(freeFrames.back());
+		freeFrames.pop_back();
+	}
+	f->repeat = drop;
+	if (!drop) {
+		const auto& codec = aviWriter->getCodec();
+		if (f->pixels.empty()) f->pixels.resize(codec.getFrameSize());
+		codec.copyFrame(frame, f->pixels.data());
+		++numQueuedImages;
+	}
+	f->audio.swap(audioBuf);
 	audioBuf.clear();
+
+	auto* writer = aviWriter.get();
+	const SDL_PixelFormat& format = frame->getSDLPixelFormat();
+	auto future = encoder->addTask([writer, f, format] {
+		writer->addFrame(f->repeat ? nullptr : f->pixels.data(), format,
+		                 unsigned(f->audio.size()), f->audio.data());
+	});
+	pendingFrames.emplace_back(std::move(future), std::move(f));
 }
 
 // TODO: Can this be dropped?
@@ -197,6 +336,7 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	bool recordVideo = true;
 	bool recordMono = false;
 	bool recordStereo = false;
+	bool recordRaw = false;
 	frameWidth = 320;
 	frameHeight = 240;
 
@@ -224,6 +364,8 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 				recordStereo = true;
 			} else if (token == "-videoonly") {
 				recordAudio = false;
+			} else if (token == "-raw") {
+				recordRaw = true;
 			} else if (token == "-doublesize") {
 				frameWidth = 640;
 				frameHeight = 480;
@@ -246,6 +388,9 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	if (!recordAudio && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if (!recordVideo && recordRaw) {
+		throw CommandException("Can't have both -audioonly and -raw.");
+	}
 	switch (arguments.size()) {
 	case 0:
 		// nothing
@@ -258,15 +403,17 @@ void AviRecorder::processStart(array_ref<TclObject> tokens, TclObject& result)
 	}
 
 	string directory = recordVideo ? "videos" : "soundlogs";
-	string extension = recordVideo ? ".avi"   : ".wav";
+	string extension = !recordVideo ? ".wav"
+	                 : recordRaw    ? ".rawvideo"
+	                                : ".avi";
 	filename = FileOperations::parseCommandFileArgument(
 		filename, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		result.setString("Already recording.");
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
-				Filename(filename));
+				recordRaw, Filename(filename));
 		result.setString("Recording to " + filename);
 	}
 }
@@ -281,7 +428,7 @@ void AviRecorder::processStop(array_ref<TclObject> tokens)
 
 void AviRecorder::processToggle(array_ref<TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		// drop extra tokens
 		processStop(make_array_ref(tokens.data(), 2));
 	} else {
@@ -289,18 +436,49 @@ void AviRecorder::processToggle(array_ref<TclObject> tokens, TclObject& result)
 	}
 }
 
+void AviRecorder::processConvert(array_ref<TclObject> tokens, TclObject& result)
+{
+	if ((tokens.size() != 3) && (tokens.size() != 4)) {
+		throw SyntaxError();
+	}
+	auto context = userDataFileContext("videos");
+	string rawName = tokens[2].getString().str();
+	string rawFile;
+	try {
+		rawFile = context.resolve(rawName);
+	} catch (MSXException& /*e*/) {
+		rawFile = context.resolve(rawName + ".rawvideo");
+	}
+	string aviFile = (tokens.size() == 4)
+		? FileOperations::parseCommandFileArgument(
+			tokens[3].getString(), "videos", "", ".avi")
+		: strCat(FileOperations::stripExtension(rawFile), ".avi");
+	try {
+		unsigned frames = RawVideoWriter::convertToAvi(
+			Filename(rawFile), Filename(aviFile));
+		result.setString(strCat("Converted ", frames, " frames to ",
+		                        aviFile));
+	} catch (MSXException& e) {
+		throw CommandException("Can't convert raw video: ",
+		                       e.getMessage());
+	}
+}
+
 void AviRecorder::status(array_ref<TclObject> tokens, TclObject& result) const
 {
 	if (tokens.size() != 2) {
 		throw SyntaxError();
 	}
 	result.addListElement("status");
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		result.addListElement("recording");
 	} else {
 		result.addListElement("idle");
 	}
-
+	// Frames that were replaced by a copy of the previous frame, because
+	// the encoder couldn't keep up. For the current or last recording.
+	result.addListElement("dropped_frames");
+	result.addListElement(int(droppedFrames));
 }
 
 // class AviRecorder::Cmd
@@ -325,6 +503,8 @@ void AviRecorder::Cmd::execute(array_ref<TclObject> tokens, TclObject& result)
 		recorder.processToggle(tokens, result);
 	} else if (subcommand == "status") {
 		recorder.status(tokens, result);
+	} else if (subcommand == "convert") {
+		recorder.processConvert(tokens, result);
 	} else {
 		throw SyntaxError();
 	}
@@ -338,10 +518,15 @@ string AviRecorder::Cmd::help(const vector<string>& /*tokens*/) const
 	       "record start -prefix foo  Record to file 'fooNNNN.avi'\n"
 	       "record stop               Stop recording\n"
 	       "record toggle             Toggle recording (useful as keybinding)\n"
-	       "record status             Query recording state\n"
+	       "record status             Query recording state and the number of dropped\n"
+	       "                          frames (when the encoder can't keep up in real time)\n"
+	       "record convert <raw> [<avi>]  Convert a -raw recording to a .avi file\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
-	       " -mono, -stereo, -doublesize flag.\n"
+	       " -mono, -stereo, -doublesize, -raw flag.\n"
+	       "With -raw the frames are written uncompressed to a .rawvideo file, this "
+	       "takes (much) less CPU time but (much) more disk space. Use the convert "
+	       "subcommand to create a .avi file from it afterwards.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
 	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
 }
@@ -350,15 +535,17 @@ void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
 {
 	if (tokens.size() == 2) {
 		static const char* const cmds[] = {
-			"start", "stop", "toggle", "status",
+			"start", "stop", "toggle", "status", "convert",
 		};
 		completeString(tokens, cmds);
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static const char* const options[] = {
 			"-prefix", "-videoonly", "-audioonly", "-doublesize", "-triplesize",
-			"-mono", "-stereo",
+			"-mono", "-stereo", "-raw",
 		};
 		completeFileName(tokens, userFileContext(), options);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "convert")) {
+		completeFileName(tokens, userDataFileContext("videos"));
 	}
 }
 
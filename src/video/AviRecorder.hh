@@ -3,21 +3,27 @@
 
 #include "Command.hh"
 #include "EmuTime.hh"
+#include "MemBuffer.hh"
 #include "array_ref.hh"
 #include <cstdint>
-#include <vector>
+#include <deque>
+#include <future>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
 class Reactor;
 class AviWriter;
+class RawVideoWriter;
 class Wav16Writer;
 class Filename;
 class PostProcessor;
 class FrameSource;
 class MSXMixer;
 class TclObject;
+class ThreadPool;
 
 class AviRecorder
 {
@@ -32,12 +38,17 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, bool recordRaw, const Filename& filename);
+	bool isRecording() const;
 	void status(array_ref<TclObject> tokens, TclObject& result) const;
 
+	void finishFrame();
+	void finishAllFrames();
+
 	void processStart (array_ref<TclObject> tokens, TclObject& result);
 	void processStop  (array_ref<TclObject> tokens);
 	void processToggle(array_ref<TclObject> tokens, TclObject& result);
+	void processConvert(array_ref<TclObject> tokens, TclObject& result);
 
 	Reactor& reactor;
 
@@ -48,9 +59,22 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} recordCommand;
 
+	// A video frame and its audio, waiting to be encoded and written.
+	struct Frame {
+		MemBuffer<uint8_t> pixels;
+		std::vector<int16_t> audio;
+		bool repeat; // dropped frame, repeat previous one (no pixels)
+	};
+	using PendingFrame = std::pair<std::shared_future<void>,
+	                               std::shared_ptr<Frame>>;
+
 	std::vector<int16_t> audioBuf;
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
+	std::unique_ptr<ThreadPool>  encoder;   // only when aviWriter != nullptr
+	std::deque<PendingFrame> pendingFrames; // in encode order
+	std::vector<std::shared_ptr<Frame>> freeFrames; // for reuse
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<RawVideoWriter> rawWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
@@ -58,6 +82,8 @@ private:
 	unsigned sampleRate;
 	unsigned frameWidth;
 	unsigned frameHeight;
+	unsigned numQueuedImages; // pending frames with pixel data
+	unsigned droppedFrames;
 	bool warnedFps;
 	bool warnedSampleRate;
 	bool warnedStereo;
@@ -13,7 +13,6 @@
 namespace openmsx {
 
 class Filename;
-class FrameSource;
 
 class AviWriter
 {
@@ -21,11 +20,17 @@ public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned bpp, unsigned channels, unsigned freq);
 	~AviWriter();
-	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData);
+	/** Add a video frame and the audio samples that belong to it.
+	  * @param pixels Frame data as produced by ZMBVEncoder::copyFrame(),
+	  *               or nullptr to repeat the previous frame.
+	  */
+	void addFrame(const void* pixels, const SDL_PixelFormat& pixelFormat,
+	              unsigned samples, const int16_t* sampleData);
+	const ZMBVEncoder& getCodec() const { return codec; }
 	void setFps(float fps_) { fps = fps_; }
 
 private:
-	void addAviChunk(const char* tag, unsigned size, void* data, unsigned flags);
+	void addAviChunk(const char* tag, unsigned size, const void* data, unsigned flags);
 
 	File file;
 	ZMBVEncoder codec;
@@ -6,6 +6,9 @@
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
 #include "OutputSurface.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "ThreadPool.hh"
 #include "IntegerSetting.hh"
 #include "FloatSetting.hh"
 #include "BooleanSetting.hh"
@@ -14,11 +17,14 @@
 #include "aligned.hh"
 #include "random.hh"
 #include "xrange.hh"
+#include "vla.hh"
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <future>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -239,6 +245,8 @@ FBPostProcessor<Pixel>::FBPostProcessor(MSXMotherBoard& motherBoard_,
 	: PostProcessor(
 		motherBoard_, display_, screen_, videoSource, maxWidth_, height_,
 		canDoInterlace_)
+	, threadPool(motherBoard_.getReactor().getThreadPool())
+	, cacheValid(false)
 	, noiseShift(screen.getHeight())
 	, pixelOps(screen.getSDLFormat())
 {
@@ -276,55 +284,79 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 	if ((scaleAlgorithm != algo) || (scaleFactor != factor)) {
 		scaleAlgorithm = algo;
 		scaleFactor = factor;
-		currScaler = ScalerFactory<Pixel>::createScaler(
-			PixelOperations<Pixel>(output.getSDLFormat()),
-			renderSettings);
+		scalers.clear();
+		for (unsigned i = 0; i < threadPool.getMaxThreads(); ++i) {
+			scalers.push_back(ScalerFactory<Pixel>::createScaler(
+				PixelOperations<Pixel>(output.getSDLFormat()),
+				renderSettings));
+		}
 	}
 
 	// Scale image.
 	const unsigned srcHeight = paintFrame->getHeight();
 	const unsigned dstHeight = output.getHeight();
 
+	// The image is scaled in steps of srcStep source lines to dstStep
+	// destination lines. Step 'n' covers source lines [n * srcStep,
+	// (n + 1) * srcStep) and destination lines [n * dstStep, ...).
 	unsigned g = Math::gcd(srcHeight, dstHeight);
 	unsigned srcStep = srcHeight / g;
 	unsigned dstStep = dstHeight / g;
+	unsigned numSteps = dstHeight / dstStep;
 
 	// TODO: Store all MSX lines in RawFrame and only scale the ones that fit
 	//       on the PC screen, as a preparation for resizable output window.
-	unsigned srcStartY = 0;
-	unsigned dstStartY = 0;
-	while (dstStartY < dstHeight) {
+	regions.clear();
+	unsigned step = 0;
+	while (step < numSteps) {
 		// Currently this is true because the source frame height
 		// is always >= dstHeight/(dstStep/srcStep).
-		assert(srcStartY < srcHeight);
+		assert((step * srcStep) < srcHeight);
 
 		// get region with equal lineWidth
-		unsigned lineWidth = getLineWidth(paintFrame, srcStartY, srcStep);
-		unsigned srcEndY = srcStartY + srcStep;
-		unsigned dstEndY = dstStartY + dstStep;
-		while ((srcEndY < srcHeight) && (dstEndY < dstHeight) &&
-		       (getLineWidth(paintFrame, srcEndY, srcStep) == lineWidth)) {
-			srcEndY += srcStep;
-			dstEndY += dstStep;
+		unsigned lineWidth = getLineWidth(paintFrame, step * srcStep, srcStep);
+		unsigned lastStep = step + 1;
+		while ((lastStep < numSteps) &&
+		       ((lastStep * srcStep) < srcHeight) &&
+		       (getLineWidth(paintFrame, lastStep * srcStep, srcStep) == lineWidth)) {
+			++lastStep;
 		}
+		regions.push_back({step, lastStep, lineWidth});
+		step = lastStep;
+	}
 
-		// fill region
-		//fprintf(stderr, "post processing lines %d-%d: %d\n",
-		//	srcStartY, srcEndY, lineWidth );
-		output.lock();
-		float horStretch = renderSettings.getHorizontalStretch();
-		unsigned inWidth = lrintf(horStretch);
-		std::unique_ptr<ScalerOutput<Pixel>> dst(
-			StretchScalerOutputFactory<Pixel>::create(
-				output, pixelOps, inWidth));
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*dst, dstStartY, dstEndY); // dest
-
-		// next region
-		srcStartY = srcEndY;
-		dstStartY = dstEndY;
+	float horStretch = renderSettings.getHorizontalStretch();
+	unsigned inWidth = lrintf(horStretch);
+	findDirtySteps(output, inWidth, srcStep, numSteps);
+
+	// Split the image in horizontal bands (each spanning one or more
+	// regions) and scale those in parallel. Don't make the bands too small,
+	// then the overhead of starting the tasks isn't worth it.
+	static const unsigned MIN_BAND_LINES = 16;
+	unsigned numBands = (scalers[0]->canScaleInBands() &&
+	                     scalers[0]->isLocal())
+		? std::max(1u, std::min<unsigned>(
+			scalers.size(), dstHeight / MIN_BAND_LINES))
+		: 1;
+	output.lock();
+	if (numBands == 1) {
+		scaleBand(output, *scalers[0], inWidth,
+		          0, numSteps, srcStep, dstStep);
+	} else {
+		std::vector<std::shared_future<void>> bands;
+		for (unsigned b = 0; b < numBands; ++b) {
+			unsigned first = (numSteps * (b + 0)) / numBands;
+			unsigned last  = (numSteps * (b + 1)) / numBands;
+			if (first == last) continue;
+			auto* scaler = scalers[b].get();
+			bands.push_back(threadPool.addTask(
+				[this, &output, scaler, inWidth, first, last,
+				 srcStep, dstStep] {
+					scaleBand(output, *scaler, inWidth,
+					          first, last, srcStep, dstStep);
+				}));
+		}
+		for (auto& b : bands) b.get();
 	}
 
 	drawNoise(output);
@@ -332,6 +364,120 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output)
 	output.flushFrameBuffer(); // for SDLGL-FBxx
 }
 
+template <class Pixel>
+void FBPostProcessor<Pixel>::findDirtySteps(
+	OutputSurface& output, unsigned inWidth,
+	unsigned srcStep, unsigned numSteps)
+{
+	unsigned srcHeight = paintFrame->getHeight();
+	CacheKey key;
+	key.scaleAlgorithm = scaleAlgorithm;
+	key.scaleFactor    = scaleFactor;
+	key.inWidth        = inWidth;
+	key.scanlineFactor = renderSettings.getScanlineFactor();
+	key.blurFactor     = renderSettings.getBlurFactor();
+	key.srcHeight      = srcHeight;
+	key.dstWidth       = output.getWidth();
+	key.dstHeight      = output.getHeight();
+	bool useCache = cacheValid && (key == cacheKey);
+	cacheKey = key;
+	cacheValid = false;
+	dirtySteps.assign(numSteps, true);
+
+	// A superimposed video changes every frame anyway. And for a scaler
+	// that isn't local, a changed line can influence the whole output.
+	if (superImposeVideoFrame || !scalers[0]->isLocal()) return;
+
+	unsigned pitch = maxWidth;
+	srcCache.resize(srcHeight * pitch);
+	srcCacheWidths.resize(srcHeight);
+	dstCache.resize(key.dstWidth * key.dstHeight);
+	if (useCache) {
+		dirtySteps.assign(numSteps, false);
+	}
+
+	// A changed source line also influences the output of the neighbouring
+	// lines (some scalers look up to 2 lines above or below).
+	const unsigned margin = 2;
+	VLA_SSE_ALIGNED(Pixel, buf, pitch);
+	for (unsigned y = 0; y < srcHeight; ++y) {
+		unsigned width = paintFrame->getLineWidth(y);
+		if (width > pitch) {
+			// Can't store this line, don't use the cache.
+			dirtySteps.assign(numSteps, true);
+			return;
+		}
+		auto* line = paintFrame->getLinePtr(y, width, buf);
+		auto* cached = &srcCache[y * pitch];
+		if (useCache && (srcCacheWidths[y] == width) &&
+		    (memcmp(line, cached, width * sizeof(Pixel)) == 0)) {
+			continue;
+		}
+		srcCacheWidths[y] = width;
+		memcpy(cached, line, width * sizeof(Pixel));
+		if (useCache) {
+			unsigned first = (std::max(y, margin) - margin) / srcStep;
+			unsigned last  = std::min((y + margin) / srcStep + 1, numSteps);
+			for (unsigned step = first; step < last; ++step) {
+				dirtySteps[step] = true;
+			}
+		}
+	}
+	cacheValid = true;
+}
+
+template <class Pixel>
+void FBPostProcessor<Pixel>::scaleBand(
+	OutputSurface& output, Scaler<Pixel>& scaler, unsigned inWidth,
+	unsigned firstStep, unsigned lastStep, unsigned srcStep, unsigned dstStep)
+{
+	// Each band gets its own ScalerOutput, StretchScalerOutput keeps a pool
+	// of line buffers.
+	std::unique_ptr<ScalerOutput<Pixel>> dst(
+		StretchScalerOutputFactory<Pixel>::create(
+			output, pixelOps, inWidth));
+
+	for (auto& r : regions) {
+		unsigned regionFirst = std::max(r.firstStep, firstStep);
+		unsigned regionLast  = std::min(r.lastStep,  lastStep);
+		while (regionFirst < regionLast) {
+			// only scale the dirty steps
+			if (!dirtySteps[regionFirst]) {
+				++regionFirst;
+				continue;
+			}
+			unsigned first = regionFirst;
+			unsigned last = first + 1;
+			while ((last < regionLast) && dirtySteps[last]) ++last;
+			regionFirst = last;
+
+			// fill (part of) region
+			//fprintf(stderr, "post processing lines %d-%d: %d\n",
+			//	first * srcStep, last * srcStep, r.lineWidth);
+			scaler.scaleImage(
+				*paintFrame, superImposeVideoFrame,
+				first * srcStep, last * srcStep, r.lineWidth, // source
+				*dst, first * dstStep, last * dstStep); // dest
+		}
+	}
+
+	if (!cacheValid) return;
+	// Copy the output of the clean steps from the previous paint(),
+	// remember the output of the steps that were scaled.
+	unsigned width = output.getWidth();
+	for (unsigned step = firstStep; step < lastStep; ++step) {
+		for (unsigned y = step * dstStep; y < (step + 1) * dstStep; ++y) {
+			auto* line = output.getLinePtrDirect<Pixel>(y);
+			auto* cached = &dstCache[y * width];
+			if (dirtySteps[step]) {
+				memcpy(cached, line, width * sizeof(Pixel));
+			} else {
+				memcpy(line, cached, width * sizeof(Pixel));
+			}
+		}
+	}
+}
+
 template <class Pixel>
 std::unique_ptr<RawFrame> FBPostProcessor<Pixel>::rotateFrames(
 	std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time)
@@ -4,12 +4,14 @@
 #include "PostProcessor.hh"
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
+#include "MemBuffer.hh"
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Display;
+class ThreadPool;
 template<typename Pixel> class Scaler;
 
 /** Rasterizer using SDL.
@@ -35,13 +37,76 @@ private:
 	void drawNoise(OutputSurface& output);
 	void drawNoiseLine(Pixel* buf, signed char* noise,
 	                   size_t width);
+	void findDirtySteps(OutputSurface& output, unsigned inWidth,
+	                    unsigned srcStep, unsigned numSteps);
+	void scaleBand(OutputSurface& output, Scaler<Pixel>& scaler,
+	               unsigned inWidth, unsigned firstStep, unsigned lastStep,
+	               unsigned srcStep, unsigned dstStep);
 
 	// Observer<Setting>
 	void update(const Setting& setting) override;
 
-	/** The currently active scaler.
+	/** The currently active scaler. There's one instance per band, so that
+	  * the bands can be scaled in parallel (a scaler may have some internal
+	  * state).
 	  */
-	std::unique_ptr<Scaler<Pixel>> currScaler;
+	std::vector<std::unique_ptr<Scaler<Pixel>>> scalers;
+
+	/** Used to scale the bands in parallel (shared, see Reactor).
+	  */
+	ThreadPool& threadPool;
+
+	/** Regions (of the frame that's being painted) with equal lineWidth.
+	  * Expressed in steps, see paint().
+	  */
+	struct Region {
+		unsigned firstStep;
+		unsigned lastStep; // exclusive
+		unsigned lineWidth;
+	};
+	std::vector<Region> regions;
+
+	/** Copy of the source lines of the previously painted frame and of
+	  * the output that was produced from them. Often most lines of a frame
+	  * are identical to the previous frame (think of a static title screen
+	  * or the BASIC prompt), the output for those lines is copied from
+	  * 'dstCache' instead of being scaled again. See findDirtySteps().
+	  */
+	MemBuffer<Pixel> srcCache;
+	std::vector<unsigned> srcCacheWidths;
+	MemBuffer<Pixel> dstCache;
+
+	/** Everything (besides the source lines) that influences the output
+	  * stored in the caches above.
+	  */
+	struct CacheKey {
+		RenderSettings::ScaleAlgorithm scaleAlgorithm;
+		unsigned scaleFactor;
+		unsigned inWidth;
+		int scanlineFactor;
+		int blurFactor;
+		unsigned srcHeight;
+		unsigned dstWidth;
+		unsigned dstHeight;
+
+		bool operator==(const CacheKey& o) const {
+			return (scaleAlgorithm == o.scaleAlgorithm) &&
+			       (scaleFactor    == o.scaleFactor) &&
+			       (inWidth        == o.inWidth) &&
+			       (scanlineFactor == o.scanlineFactor) &&
+			       (blurFactor     == o.blurFactor) &&
+			       (srcHeight      == o.srcHeight) &&
+			       (dstWidth       == o.dstWidth) &&
+			       (dstHeight      == o.dstHeight);
+		}
+	};
+	CacheKey cacheKey;
+	bool cacheValid;
+
+	/** For the frame that's being painted: which steps must be scaled
+	  * (the others are copied from 'dstCache').
+	  */
+	std::vector<bool> dirtySteps;
 
 	/** Currently active scale algorithm, used to detect scaler changes.
 	  */
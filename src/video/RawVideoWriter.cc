@@ -0,0 +1,245 @@
+#include "RawVideoWriter.hh"
+#include "AviWriter.hh"
+#include "ZMBVEncoder.hh"
+#include "FrameSource.hh"
+#include "Filename.hh"
+#include "MSXException.hh"
+#include <SDL.h>
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+static const char MAGIC[8] = { 'o', 'p', 'e', 'n', 'M', 'S', 'X', 'V' };
+static const uint32_t VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct RawHeader {
+	char magic[8];
+	uint32_t byteOrder;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t bpp;
+	uint32_t channels;
+	uint32_t freq;
+};
+
+struct RawChunkHeader {
+	char tag[4];
+	uint32_t size; // of the data that follows
+};
+
+// The fields of SDL_PixelFormat that are needed to interpret the pixels.
+struct RawFormat {
+	uint32_t Rmask, Gmask, Bmask, Amask;
+	uint8_t Rshift, Gshift, Bshift, Ashift;
+	uint8_t Rloss, Gloss, Bloss, Aloss;
+	uint8_t BitsPerPixel, BytesPerPixel;
+	uint8_t padding[2];
+};
+
+// A 'vid ' chunk contains: uint32_t number of audio samples, the pixel data
+// (as produced by ZMBVEncoder::copyFrame()), the audio samples.
+
+
+RawVideoWriter::RawVideoWriter(
+		const Filename& filename, unsigned width, unsigned height_,
+		unsigned bpp, unsigned channels, unsigned freq)
+	: file(filename, "wb")
+	, height(height_)
+	, pixelSize((bpp + 7) / 8)
+	, formatWritten(false)
+{
+	assert(width == height * 4 / 3);
+	RawHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = VERSION;
+	header.width = width;
+	header.height = height;
+	header.bpp = bpp;
+	header.channels = channels;
+	header.freq = freq;
+	file.write(&header, sizeof(header));
+}
+
+void RawVideoWriter::writeFormat(const SDL_PixelFormat& format)
+{
+	struct {
+		RawChunkHeader chunk;
+		RawFormat format;
+	} data;
+	memset(&data, 0, sizeof(data));
+	memcpy(data.chunk.tag, "fmt ", 4);
+	data.chunk.size = sizeof(RawFormat);
+	data.format.Rmask = format.Rmask;
+	data.format.Gmask = format.Gmask;
+	data.format.Bmask = format.Bmask;
+	data.format.Amask = format.Amask;
+	data.format.Rshift = format.Rshift;
+	data.format.Gshift = format.Gshift;
+	data.format.Bshift = format.Bshift;
+	data.format.Ashift = format.Ashift;
+	data.format.Rloss = format.Rloss;
+	data.format.Gloss = format.Gloss;
+	data.format.Bloss = format.Bloss;
+	data.format.Aloss = format.Aloss;
+	data.format.BitsPerPixel = format.BitsPerPixel;
+	data.format.BytesPerPixel = format.BytesPerPixel;
+	file.write(&data, sizeof(data));
+}
+
+void RawVideoWriter::setFps(float fps)
+{
+	struct {
+		RawChunkHeader chunk;
+		float fps;
+	} data;
+	memcpy(data.chunk.tag, "fps ", 4);
+	data.chunk.size = sizeof(float);
+	data.fps = fps;
+	file.write(&data, sizeof(data));
+}
+
+void RawVideoWriter::addFrame(FrameSource* frame, unsigned samples,
+                              const int16_t* sampleData)
+{
+	if (!formatWritten) {
+		writeFormat(frame->getSDLPixelFormat());
+		formatWritten = true;
+	}
+
+	// Assemble the complete chunk, so that it can be written at once.
+	unsigned pixelBytes = (height * 4 / 3) * height * pixelSize;
+	unsigned audioBytes = samples * sizeof(int16_t);
+	unsigned dataSize = sizeof(uint32_t) + pixelBytes + audioBytes;
+	buffer.resize(sizeof(RawChunkHeader) + dataSize);
+
+	RawChunkHeader chunk;
+	memcpy(chunk.tag, "vid ", 4);
+	chunk.size = dataSize;
+	uint8_t* p = buffer.data();
+	memcpy(p, &chunk, sizeof(chunk));
+	p += sizeof(chunk);
+	uint32_t numSamples = samples;
+	memcpy(p, &numSamples, sizeof(numSamples));
+	p += sizeof(numSamples);
+	ZMBVEncoder::copyFrame(frame, height, pixelSize, p);
+	p += pixelBytes;
+	if (audioBytes) memcpy(p, sampleData, audioBytes);
+
+	file.write(buffer.data(), buffer.size());
+}
+
+unsigned RawVideoWriter::convertToAvi(const Filename& rawFile,
+                                      const Filename& aviFile)
+{
+	File file(rawFile);
+	size_t size;
+	const byte* data = file.mmap(size);
+
+	RawHeader header;
+	if (size >= sizeof(header)) {
+		memcpy(&header, data, sizeof(header));
+	}
+	if ((size < sizeof(header)) ||
+	    (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)) {
+		throw MSXException("Not a raw openMSX video file: ",
+		                   rawFile.getOriginal());
+	}
+	if (header.byteOrder != BYTE_ORDER_MARK) {
+		throw MSXException("This raw video file was recorded on a "
+		                   "machine with a different byte order.");
+	}
+	if (header.version != VERSION) {
+		throw MSXException("Unsupported raw video file version: ",
+		                   header.version);
+	}
+	if (((header.height != 240) && (header.height != 480) &&
+	     (header.height != 720)) ||
+	    (header.width != header.height * 4 / 3) ||
+	    ((header.bpp != 15) && (header.bpp != 16) && (header.bpp != 32))) {
+		throw MSXException("Unsupported raw video format: ",
+		                   header.width, 'x', header.height, ' ',
+		                   header.bpp, "bpp");
+	}
+	unsigned pixelBytes = header.width * header.height *
+	                      ((header.bpp + 7) / 8);
+
+	AviWriter writer(aviFile, header.width, header.height, header.bpp,
+	                 header.channels, header.freq);
+	SDL_PixelFormat format;
+	memset(&format, 0, sizeof(format));
+	bool haveFormat = false;
+	bool haveFps = false;
+	unsigned frames = 0;
+
+	size_t pos = sizeof(header);
+	while ((size - pos) >= sizeof(RawChunkHeader)) {
+		RawChunkHeader chunk;
+		memcpy(&chunk, data + pos, sizeof(chunk));
+		pos += sizeof(chunk);
+		// Ignore an incomplete chunk at the end, this can happen when
+		// the recording was interrupted.
+		if (chunk.size > (size - pos)) break;
+		const byte* p = data + pos;
+		pos += chunk.size;
+
+		if (memcmp(chunk.tag, "fmt ", 4) == 0) {
+			if (chunk.size != sizeof(RawFormat)) {
+				throw MSXException("Corrupt raw video file.");
+			}
+			RawFormat f;
+			memcpy(&f, p, sizeof(f));
+			format.Rmask = f.Rmask;
+			format.Gmask = f.Gmask;
+			format.Bmask = f.Bmask;
+			format.Amask = f.Amask;
+			format.Rshift = f.Rshift;
+			format.Gshift = f.Gshift;
+			format.Bshift = f.Bshift;
+			format.Ashift = f.Ashift;
+			format.Rloss = f.Rloss;
+			format.Gloss = f.Gloss;
+			format.Bloss = f.Bloss;
+			format.Aloss = f.Aloss;
+			format.BitsPerPixel = f.BitsPerPixel;
+			format.BytesPerPixel = f.BytesPerPixel;
+			haveFormat = true;
+		} else if (memcmp(chunk.tag, "fps ", 4) == 0) {
+			if (chunk.size != sizeof(float)) {
+				throw MSXException("Corrupt raw video file.");
+			}
+			float fps;
+			memcpy(&fps, p, sizeof(fps));
+			writer.setFps(fps);
+			haveFps = true;
+		} else if (memcmp(chunk.tag, "vid ", 4) == 0) {
+			uint32_t samples;
+			if (!haveFormat || (chunk.size < sizeof(samples))) {
+				throw MSXException("Corrupt raw video file.");
+			}
+			memcpy(&samples, p, sizeof(samples));
+			if (chunk.size != (sizeof(samples) + pixelBytes +
+			                   samples * sizeof(int16_t))) {
+				throw MSXException("Corrupt raw video file.");
+			}
+			const byte* pixels = p + sizeof(samples);
+			auto* audio = reinterpret_cast<const int16_t*>(
+				pixels + pixelBytes);
+			writer.addFrame(pixels, format, samples, audio);
+			++frames;
+		} else {
+			// unknown chunk, skip
+		}
+	}
+	if (!haveFps) {
+		// Less than two frames recorded, the frame rate doesn't
+		// really matter.
+		writer.setFps(50.0f);
+	}
+	return frames;
+}
+
+} // namespace openmsx
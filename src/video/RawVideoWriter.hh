@@ -0,0 +1,59 @@
+#ifndef RAWVIDEOWRITER_HH
+#define RAWVIDEOWRITER_HH
+
+#include "File.hh"
+#include <cstdint>
+#include <vector>
+
+struct SDL_PixelFormat;
+
+namespace openmsx {
+
+class Filename;
+class FrameSource;
+
+/** Writes uncompressed video frames and audio to a simple append-only file.
+  *
+  * This is meant for long (automated) recording sessions: recording a frame
+  * only costs a copy of the pixel data and a single write to the file. The
+  * file can afterwards be converted to an AVI file with convertToAvi().
+  *
+  * The file format is a small header, followed by a sequence of chunks. Each
+  * chunk starts with a 4 byte tag and a 4 byte size (of the data that
+  * follows). All values are stored in native byte order (conversion must be
+  * done on a machine with the same byte order). Because the file is only
+  * appended to, an interrupted recording can still be converted (up to the
+  * last complete chunk).
+  */
+class RawVideoWriter
+{
+public:
+	RawVideoWriter(const Filename& filename, unsigned width, unsigned height,
+	               unsigned bpp, unsigned channels, unsigned freq);
+
+	/** Add a frame and the audio samples that belong to it. */
+	void addFrame(FrameSource* frame, unsigned samples,
+	              const int16_t* sampleData);
+	void setFps(float fps);
+
+	/** Convert a file written by this class to an AVI file (using the
+	  * ZMBV codec, exactly like a normal 'record start').
+	  * @return The number of converted frames.
+	  * @throws MSXException
+	  */
+	static unsigned convertToAvi(const Filename& rawFile,
+	                             const Filename& aviFile);
+
+private:
+	void writeFormat(const SDL_PixelFormat& format);
+
+	File file;
+	std::vector<uint8_t> buffer; // one chunk, reused for every frame
+	const unsigned height;
+	const unsigned pixelSize;
+	bool formatWritten;
+};
+
+} // namespace openmsx
+
+#endif
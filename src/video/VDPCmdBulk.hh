@@ -0,0 +1,169 @@
+#ifndef VDPCMDBULK_HH
+#define VDPCMDBULK_HH
+
+#include "EmuTime.hh"
+#include "openmsx.hh"
+#include <algorithm>
+
+namespace openmsx {
+
+// Bulk execution of block commands:
+//
+// Normally the block commands are executed one VRAM access at a time, at the
+// exact moment of the corresponding access slot. Each write is reported to
+// the VRAM observers (renderer, sprite checker) with its exact time. But when
+// a command will finish before the next sync point (so the CPU can't observe
+// the intermediate state) and nobody observes the VRAM region it writes to,
+// the exact moment of the individual accesses doesn't matter. Then the whole
+// command is executed at once, without the (per access) bookkeeping.
+//
+// The functions below are templatized on the VRAM type, normally that's
+// VDPVRAM. The 'bulk*' functions take the relevant command engine registers
+// by reference, on return they have the same value as after stepwise
+// execution. 'nx' and 'ny' are the clipped NX and NY values, 'tx' and 'ty'
+// the (signed) distance between two elements in x and y direction.
+
+/** Wrapper around VDPVRAM that writes without notifying the observers. Only
+  * used when VDPVRAM::isUnobserved() is true for the destination region. */
+template<typename VRAM>
+struct UnobservedVRAM {
+	explicit UnobservedVRAM(VRAM& vram_) : vram(vram_) {}
+	void cmdWrite(unsigned address, byte value, EmuTime::param /*time*/) {
+		vram.cmdWriteUnobserved(address, value);
+	}
+	VRAM& vram;
+};
+
+/** Is the destination of a block command unobserved (see
+  * VDPVRAM::isUnobserved())? Parameters as for the command registers.
+  * The addresses of a row are contiguous, except in the planar modes, there
+  * they're spread over two contiguous ranges 64kB apart (bit 16).
+  */
+template<typename Mode, typename VRAM>
+inline bool isUnobserved(
+	const VRAM& vram, unsigned adx, unsigned anx, unsigned dx,
+	unsigned nx, unsigned dy, unsigned ny, int tx, int ty)
+{
+	unsigned x = adx;
+	unsigned num = anx;
+	for (/**/; ny != 0; --ny) {
+		unsigned addr1 = Mode::addressOf(x, dy, false);
+		unsigned addr2 = Mode::addressOf(x + (num - 1) * tx, dy, false);
+		if (Mode::PLANAR) {
+			addr1 &= ~0x10000;
+			addr2 &= ~0x10000;
+		}
+		unsigned lo = std::min(addr1, addr2);
+		unsigned hi = std::max(addr1, addr2);
+		if (!vram.isUnobserved(lo, hi)) return false;
+		if (Mode::PLANAR &&
+		    !vram.isUnobserved(lo | 0x10000, hi | 0x10000)) {
+			return false;
+		}
+		x = dx;
+		num = nx;
+		dy += ty;
+	}
+	return true;
+}
+
+template<typename Mode, typename LogOp, typename VRAM>
+inline void bulkLmmv(
+	VRAM& vram, EmuTime::param time, byte color,
+	unsigned dx, unsigned nx, unsigned ny, int tx, int ty,
+	unsigned& adx, unsigned& anx, unsigned& dyReg, unsigned& nyReg)
+{
+	UnobservedVRAM<VRAM> uvram(vram);
+	do {
+		for (/**/; anx != 0; --anx) {
+			unsigned addr = Mode::addressOf(adx, dyReg, false);
+			byte dst = vram.cmdWriteWindow.readNP(addr);
+			Mode::pset(time, uvram, adx, addr, dst, color, LogOp());
+			adx += tx;
+		}
+		dyReg += ty; --nyReg;
+		adx = dx; anx = nx;
+	} while (--ny != 0);
+}
+
+template<typename Mode, typename LogOp, typename VRAM>
+inline void bulkLmmm(
+	VRAM& vram, EmuTime::param time,
+	unsigned sx, unsigned dx, unsigned nx, unsigned ny, int tx, int ty,
+	unsigned& asx, unsigned& adx, unsigned& anx,
+	unsigned& syReg, unsigned& dyReg, unsigned& nyReg)
+{
+	UnobservedVRAM<VRAM> uvram(vram);
+	do {
+		for (/**/; anx != 0; --anx) {
+			byte src = Mode::point(vram, asx, syReg, false);
+			unsigned addr = Mode::addressOf(adx, dyReg, false);
+			byte dst = vram.cmdWriteWindow.readNP(addr);
+			Mode::pset(time, uvram, adx, addr, dst, src, LogOp());
+			asx += tx; adx += tx;
+		}
+		syReg += ty; dyReg += ty; --nyReg;
+		asx = sx; adx = dx; anx = nx;
+	} while (--ny != 0);
+}
+
+template<typename Mode, typename VRAM>
+inline void bulkHmmv(
+	VRAM& vram, byte color,
+	unsigned dx, unsigned nx, unsigned ny, int tx, int ty,
+	unsigned& adx, unsigned& anx, unsigned& dyReg, unsigned& nyReg)
+{
+	do {
+		for (/**/; anx != 0; --anx) {
+			vram.cmdWriteUnobserved(
+				Mode::addressOf(adx, dyReg, false), color);
+			adx += tx;
+		}
+		dyReg += ty; --nyReg;
+		adx = dx; anx = nx;
+	} while (--ny != 0);
+}
+
+template<typename Mode, typename VRAM>
+inline void bulkHmmm(
+	VRAM& vram,
+	unsigned sx, unsigned dx, unsigned nx, unsigned ny, int tx, int ty,
+	unsigned& asx, unsigned& adx, unsigned& anx,
+	unsigned& syReg, unsigned& dyReg, unsigned& nyReg)
+{
+	do {
+		for (/**/; anx != 0; --anx) {
+			byte p = vram.cmdReadWindow.readNP(
+				Mode::addressOf(asx, syReg, false));
+			vram.cmdWriteUnobserved(
+				Mode::addressOf(adx, dyReg, false), p);
+			asx += tx; adx += tx;
+		}
+		syReg += ty; dyReg += ty; --nyReg;
+		asx = sx; adx = dx; anx = nx;
+	} while (--ny != 0);
+}
+
+template<typename Mode, typename VRAM>
+inline void bulkYmmm(
+	VRAM& vram,
+	unsigned dx, unsigned nx, unsigned ny, int tx, int ty,
+	unsigned& adx, unsigned& anx,
+	unsigned& syReg, unsigned& dyReg, unsigned& nyReg)
+{
+	do {
+		for (/**/; anx != 0; --anx) {
+			byte p = vram.cmdReadWindow.readNP(
+				Mode::addressOf(adx, syReg, false));
+			vram.cmdWriteUnobserved(
+				Mode::addressOf(adx, dyReg, false), p);
+			adx += tx;
+		}
+		syReg += ty; dyReg += ty; --nyReg;
+		adx = dx; anx = nx;
+	} while (--ny != 0);
+}
+
+} // namespace openmsx
+
+#endif
@@ -36,6 +36,8 @@ TODO:
 #include "VDPCmdEngine.hh"
 #include "EmuTime.hh"
 #include "VDPVRAM.hh"
+#include "VDPCmdModes.hh"
+#include "VDPCmdBulk.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include "memory.hh"
@@ -160,252 +162,6 @@ template<typename LogOp> static void psetFast(
 	op(time, vram, addr, src, color, mask);
 }
 
-/** Represents V9938 Graphic 4 mode (SCREEN5).
-  */
-struct Graphic4Mode
-{
-	//using IncrByteAddr  = IncrByteAddr4;
-	//using IncrPixelAddr = IncrPixelAddr4;
-	//using IncrMask      = IncrMask4;
-	//using IncrShift     = IncrShift4;
-	static const byte COLOR_MASK = 0x0F;
-	static const byte PIXELS_PER_BYTE = 2;
-	static const byte PIXELS_PER_BYTE_SHIFT = 1;
-	static const unsigned PIXELS_PER_LINE = 256;
-	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
-	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template <typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
-		unsigned x, unsigned addr, byte src, byte color, LogOp op);
-	static inline byte duplicate(byte color);
-};
-
-inline unsigned Graphic4Mode::addressOf(
-	unsigned x, unsigned y, bool extVRAM)
-{
-	return likely(!extVRAM)
-		? (((y & 1023) << 7) | ((x & 255) >> 1))
-		: (((y &  511) << 7) | ((x & 255) >> 1) | 0x20000);
-}
-
-inline byte Graphic4Mode::point(
-	VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
-{
-	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
-		>> (((~x) & 1) << 2) ) & 15;
-}
-
-template<typename LogOp>
-inline void Graphic4Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
-	byte src, byte color, LogOp op)
-{
-	byte sh = ((~x) & 1) << 2;
-	op(time, vram, addr, src, color << sh, ~(15 << sh));
-}
-
-inline byte Graphic4Mode::duplicate(byte color)
-{
-	assert((color & 0xF0) == 0);
-	return color | (color << 4);
-}
-
-/** Represents V9938 Graphic 5 mode (SCREEN6).
-  */
-struct Graphic5Mode
-{
-	//using IncrByteAddr  = IncrByteAddr5;
-	//using IncrPixelAddr = IncrPixelAddr5;
-	//using IncrMask      = IncrMask5;
-	//using IncrShift     = IncrShift5;
-	static const byte COLOR_MASK = 0x03;
-	static const byte PIXELS_PER_BYTE = 4;
-	static const byte PIXELS_PER_BYTE_SHIFT = 2;
-	static const unsigned PIXELS_PER_LINE = 512;
-	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
-	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template <typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
-		unsigned x, unsigned addr, byte src, byte color, LogOp op);
-	static inline byte duplicate(byte color);
-};
-
-inline unsigned Graphic5Mode::addressOf(
-	unsigned x, unsigned y, bool extVRAM)
-{
-	return likely(!extVRAM)
-		? (((y & 1023) << 7) | ((x & 511) >> 2))
-		: (((y &  511) << 7) | ((x & 511) >> 2) | 0x20000);
-}
-
-inline byte Graphic5Mode::point(
-	VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
-{
-	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
-		>> (((~x) & 3) << 1) ) & 3;
-}
-
-template<typename LogOp>
-inline void Graphic5Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
-	byte src, byte color, LogOp op)
-{
-	byte sh = ((~x) & 3) << 1;
-	op(time, vram, addr, src, color << sh, ~(3 << sh));
-}
-
-inline byte Graphic5Mode::duplicate(byte color)
-{
-	assert((color & 0xFC) == 0);
-	color |= color << 2;
-	color |= color << 4;
-	return color;
-}
-
-/** Represents V9938 Graphic 6 mode (SCREEN7).
-  */
-struct Graphic6Mode
-{
-	//using IncrByteAddr  = IncrByteAddr6;
-	//using IncrPixelAddr = IncrPixelAddr6;
-	//using IncrMask      = IncrMask6;
-	//using IncrShift     = IncrShift6;
-	static const byte COLOR_MASK = 0x0F;
-	static const byte PIXELS_PER_BYTE = 2;
-	static const byte PIXELS_PER_BYTE_SHIFT = 1;
-	static const unsigned PIXELS_PER_LINE = 512;
-	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
-	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template <typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
-		unsigned x, unsigned addr, byte src, byte color, LogOp op);
-	static inline byte duplicate(byte color);
-};
-
-inline unsigned Graphic6Mode::addressOf(
-	unsigned x, unsigned y, bool extVRAM)
-{
-	return likely(!extVRAM)
-		? (((x & 2) << 15) | ((y & 511) << 7) | ((x & 511) >> 2))
-		: (0x20000         | ((y & 511) << 7) | ((x & 511) >> 2));
-}
-
-inline byte Graphic6Mode::point(
-	VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
-{
-	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
-		>> (((~x) & 1) << 2) ) & 15;
-}
-
-template<typename LogOp>
-inline void Graphic6Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
-	byte src, byte color, LogOp op)
-{
-	byte sh = ((~x) & 1) << 2;
-	op(time, vram, addr, src, color << sh, ~(15 << sh));
-}
-
-inline byte Graphic6Mode::duplicate(byte color)
-{
-	assert((color & 0xF0) == 0);
-	return color | (color << 4);
-}
-
-/** Represents V9938 Graphic 7 mode (SCREEN8).
-  */
-struct Graphic7Mode
-{
-	//using IncrByteAddr  = IncrByteAddr7;
-	//using IncrPixelAddr = IncrPixelAddr7;
-	//using IncrMask      = IncrMask7;
-	//using IncrShift     = IncrShift7;
-	static const byte COLOR_MASK = 0xFF;
-	static const byte PIXELS_PER_BYTE = 1;
-	static const byte PIXELS_PER_BYTE_SHIFT = 0;
-	static const unsigned PIXELS_PER_LINE = 256;
-	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
-	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
-		unsigned x, unsigned addr, byte src, byte color, LogOp op);
-	static inline byte duplicate(byte color);
-};
-
-inline unsigned Graphic7Mode::addressOf(
-	unsigned x, unsigned y, bool extVRAM)
-{
-	return likely(!extVRAM)
-		? (((x & 1) << 16) | ((y & 511) << 7) | ((x & 255) >> 1))
-		: (0x20000         | ((y & 511) << 7) | ((x & 255) >> 1));
-}
-
-inline byte Graphic7Mode::point(
-	VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
-{
-	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
-}
-
-template<typename LogOp>
-inline void Graphic7Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned /*x*/, unsigned addr,
-	byte src, byte color, LogOp op)
-{
-	op(time, vram, addr, src, color, 0);
-}
-
-inline byte Graphic7Mode::duplicate(byte color)
-{
-	return color;
-}
-
-/** Represents V9958 non-bitmap command mode. This uses the Graphic7Mode
-  * coordinate system, but in non-planar mode.
-  */
-struct NonBitmapMode
-{
-	//using IncrByteAddr  = IncrByteAddrNonBitMap;
-	//using IncrPixelAddr = IncrPixelAddrNonBitMap;
-	//using IncrMask      = IncrMaskNonBitMap;
-	//using IncrShift     = IncrShiftNonBitMap;
-	static const byte COLOR_MASK = 0xFF;
-	static const byte PIXELS_PER_BYTE = 1;
-	static const byte PIXELS_PER_BYTE_SHIFT = 0;
-	static const unsigned PIXELS_PER_LINE = 256;
-	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
-	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
-		unsigned x, unsigned addr, byte src, byte color, LogOp op);
-	static inline byte duplicate(byte color);
-};
-
-inline unsigned NonBitmapMode::addressOf(
-	unsigned x, unsigned y, bool extVRAM)
-{
-	return likely(!extVRAM)
-		? (((y & 511) << 8) | (x & 255))
-		: (((y & 255) << 8) | (x & 255) | 0x20000);
-}
-
-inline byte NonBitmapMode::point(
-	VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
-{
-	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
-}
-
-template<typename LogOp>
-inline void NonBitmapMode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned /*x*/, unsigned addr,
-	byte src, byte color, LogOp op)
-{
-	op(time, vram, addr, src, color, 0);
-}
-
-inline byte NonBitmapMode::duplicate(byte color)
-{
-	return color;
-}
 
 /** Incremental address calculation (byte based, no extended VRAM)
  */
@@ -650,72 +406,39 @@ struct IncrShift7
 };
 
 
-// Logical operations:
-
-struct DummyOp {
-	void operator()(EmuTime::param /*time*/, VDPVRAM& /*vram*/, unsigned /*addr*/,
-	                byte /*src*/, byte /*color*/, byte /*mask*/) const
-	{
-		// Undefined logical operations do nothing.
-	}
-};
-
-struct ImpOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte mask) const
-	{
-		vram.cmdWrite(addr, (src & mask) | color, time);
-	}
-};
-
-struct AndOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte mask) const
-	{
-		vram.cmdWrite(addr, src & (color | mask), time);
-	}
-};
-
-struct OrOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte /*mask*/) const
-	{
-		vram.cmdWrite(addr, src | color, time);
-	}
-};
-
-struct XorOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte /*mask*/) const
-	{
-		vram.cmdWrite(addr, src ^ color, time);
-	}
-};
-
-struct NotOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte mask) const
-	{
-		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
-	}
-};
+// Bulk execution of block commands, see also VDPCmdBulk.hh.
 
-template<typename Op>
-struct TransparentOp : Op {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte mask) const
-	{
-		// TODO does this skip the write or re-write the original value
-		//      might make a difference in case the CPU has written
-		//      the same address inbetween the command read and write
-		if (color) Op::operator()(time, vram, addr, src, color, mask);
+/** Will a block command finish before the limit of the given calculator?
+  * Each element (pixel or byte) takes N VRAM accesses, 'deltas[i]' is the
+  * minimal distance between access i and i+1 (for the last access that's
+  * the distance to the first access of the next element). On the end of a
+  * row 'rowDelta' is used instead of 'deltas[N - 1]'.
+  * @param calculator In: positioned at the first access. Out: when this
+  *                   function returns true, positioned at the last access.
+  * @param anx Number of elements left in the current row.
+  * @param nx Number of elements in the next rows.
+  * @param ny Number of rows left (including the current one).
+  */
+template<unsigned N>
+static bool finishesBeforeLimit(
+	Calculator& calculator, unsigned anx, unsigned nx, unsigned ny,
+	const Delta (&deltas)[N], Delta rowDelta)
+{
+	unsigned num = anx;
+	while (true) {
+		for (unsigned i = 0; i < num; ++i) {
+			for (unsigned j = 0; j < N - 1; ++j) {
+				if (calculator.limitReached()) return false;
+				calculator.next(deltas[j]);
+			}
+			if (calculator.limitReached()) return false;
+			if (i != (num - 1)) calculator.next(deltas[N - 1]);
+		}
+		if (--ny == 0) return true;
+		calculator.next(rowDelta);
+		num = nx;
 	}
-};
-using TImpOp = TransparentOp<ImpOp>;
-using TAndOp = TransparentOp<AndOp>;
-using TOrOp  = TransparentOp<OrOp>;
-using TXorOp = TransparentOp<XorOp>;
-using TNotOp = TransparentOp<NotOp>;
+}
 
 
 // Commands
@@ -966,6 +689,23 @@ void VDPCmdEngine::executeLmmv(EmuTime::param limit)
 	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !dstExt) {
+		static const Delta deltas[] = { DELTA_24, DELTA_72 };
+		auto endCalc = calculator;
+		if (isUnobserved<Mode>(vram, ADX, ANX, DX, tmpNX,
+		                       DY, tmpNY, TX, TY) &&
+		    finishesBeforeLimit(endCalc, ANX, tmpNX, tmpNY,
+		                        deltas, DELTA_136)) {
+			// bulk execution
+			EmuTime time = endCalc.getTime();
+			bulkLmmv<Mode, LogOp>(vram, time, CL, DX, tmpNX, tmpNY,
+			                      TX, TY, ADX, ANX, DY, NY);
+			commandDone(time);
+			engineTime = time;
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
@@ -1092,6 +832,23 @@ void VDPCmdEngine::executeLmmm(EmuTime::param limit)
 	unsigned dstAddr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !srcExt && !dstExt) {
+		static const Delta deltas[] = { DELTA_32, DELTA_24, DELTA_64 };
+		auto endCalc = calculator;
+		if (isUnobserved<Mode>(vram, ADX, ANX, DX, tmpNX,
+		                       DY, tmpNY, TX, TY) &&
+		    finishesBeforeLimit(endCalc, ANX, tmpNX, tmpNY,
+		                        deltas, DELTA_128)) {
+			// bulk execution
+			EmuTime time = endCalc.getTime();
+			bulkLmmm<Mode, LogOp>(vram, time, SX, DX, tmpNX, tmpNY,
+			                      TX, TY, ASX, ADX, ANX, SY, DY, NY);
+			commandDone(time);
+			engineTime = time;
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
@@ -1343,6 +1100,23 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 	bool doPset = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if (!dstExt) {
+		static const Delta deltas[] = { DELTA_48 };
+		auto endCalc = calculator;
+		if (isUnobserved<Mode>(vram, ADX, ANX, DX, tmpNX,
+		                       DY, tmpNY, TX, TY) &&
+		    finishesBeforeLimit(endCalc, ANX, tmpNX, tmpNY,
+		                        deltas, DELTA_104)) {
+			// bulk execution
+			EmuTime time = endCalc.getTime();
+			bulkHmmv<Mode>(vram, COL, DX, tmpNX, tmpNY, TX, TY,
+			               ADX, ANX, DY, NY);
+			commandDone(time);
+			engineTime = time;
+			return;
+		}
+	}
+
 	while (!calculator.limitReached()) {
 		if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
@@ -1451,6 +1225,23 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	bool doPset  = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !srcExt && !dstExt) {
+		static const Delta deltas[] = { DELTA_24, DELTA_64 };
+		auto endCalc = calculator;
+		if (isUnobserved<Mode>(vram, ADX, ANX, DX, tmpNX,
+		                       DY, tmpNY, TX, TY) &&
+		    finishesBeforeLimit(endCalc, ANX, tmpNX, tmpNY,
+		                        deltas, DELTA_128)) {
+			// bulk execution
+			EmuTime time = endCalc.getTime();
+			bulkHmmm<Mode>(vram, SX, DX, tmpNX, tmpNY, TX, TY,
+			               ASX, ADX, ANX, SY, DY, NY);
+			commandDone(time);
+			engineTime = time;
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
@@ -1585,6 +1376,23 @@ void VDPCmdEngine::executeYmmm(EmuTime::param limit)
 	bool doPset  = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !dstExt) {
+		static const Delta deltas[] = { DELTA_24, DELTA_40 };
+		auto endCalc = calculator;
+		if (isUnobserved<Mode>(vram, ADX, ANX, DX, tmpNX,
+		                       DY, tmpNY, TX, TY) &&
+		    finishesBeforeLimit(endCalc, ANX, tmpNX, tmpNY,
+		                        deltas, DELTA_40)) {
+			// bulk execution
+			EmuTime time = endCalc.getTime();
+			bulkYmmm<Mode>(vram, DX, tmpNX, tmpNY, TX, TY,
+			               ADX, ANX, SY, DY, NY);
+			commandDone(time);
+			engineTime = time;
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
@@ -0,0 +1,354 @@
+#ifndef VDPCMDMODES_HH
+#define VDPCMDMODES_HH
+
+#include "EmuTime.hh"
+#include "openmsx.hh"
+#include "likely.hh"
+#include <cassert>
+
+namespace openmsx {
+
+// The screen modes (addressing) and logical operations of the VDP command
+// engine. The VRAM they operate on is a template parameter, normally it's
+// VDPVRAM (see also UnobservedVRAM in VDPCmdBulk.hh).
+
+/** Represents V9938 Graphic 4 mode (SCREEN5).
+  */
+struct Graphic4Mode
+{
+	//using IncrByteAddr  = IncrByteAddr4;
+	//using IncrPixelAddr = IncrPixelAddr4;
+	//using IncrMask      = IncrMask4;
+	//using IncrShift     = IncrShift4;
+	static const byte COLOR_MASK = 0x0F;
+	static const byte PIXELS_PER_BYTE = 2;
+	static const byte PIXELS_PER_BYTE_SHIFT = 1;
+	static const unsigned PIXELS_PER_LINE = 256;
+	static const bool PLANAR = false;
+	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
+	template<typename VRAM>
+	static inline byte point(VRAM& vram, unsigned x, unsigned y, bool extVRAM);
+	template<typename LogOp, typename VRAM>
+	static inline void pset(EmuTime::param time, VRAM& vram,
+		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte duplicate(byte color);
+};
+
+inline unsigned Graphic4Mode::addressOf(
+	unsigned x, unsigned y, bool extVRAM)
+{
+	return likely(!extVRAM)
+		? (((y & 1023) << 7) | ((x & 255) >> 1))
+		: (((y &  511) << 7) | ((x & 255) >> 1) | 0x20000);
+}
+
+template<typename VRAM>
+inline byte Graphic4Mode::point(
+	VRAM& vram, unsigned x, unsigned y, bool extVRAM)
+{
+	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+		>> (((~x) & 1) << 2) ) & 15;
+}
+
+template<typename LogOp, typename VRAM>
+inline void Graphic4Mode::pset(
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
+	byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 1) << 2;
+	op(time, vram, addr, src, color << sh, ~(15 << sh));
+}
+
+inline byte Graphic4Mode::duplicate(byte color)
+{
+	assert((color & 0xF0) == 0);
+	return color | (color << 4);
+}
+
+/** Represents V9938 Graphic 5 mode (SCREEN6).
+  */
+struct Graphic5Mode
+{
+	//using IncrByteAddr  = IncrByteAddr5;
+	//using IncrPixelAddr = IncrPixelAddr5;
+	//using IncrMask      = IncrMask5;
+	//using IncrShift     = IncrShift5;
+	static const byte COLOR_MASK = 0x03;
+	static const byte PIXELS_PER_BYTE = 4;
+	static const byte PIXELS_PER_BYTE_SHIFT = 2;
+	static const unsigned PIXELS_PER_LINE = 512;
+	static const bool PLANAR = false;
+	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
+	template<typename VRAM>
+	static inline byte point(VRAM& vram, unsigned x, unsigned y, bool extVRAM);
+	template<typename LogOp, typename VRAM>
+	static inline void pset(EmuTime::param time, VRAM& vram,
+		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte duplicate(byte color);
+};
+
+inline unsigned Graphic5Mode::addressOf(
+	unsigned x, unsigned y, bool extVRAM)
+{
+	return likely(!extVRAM)
+		? (((y & 1023) << 7) | ((x & 511) >> 2))
+		: (((y &  511) << 7) | ((x & 511) >> 2) | 0x20000);
+}
+
+template<typename VRAM>
+inline byte Graphic5Mode::point(
+	VRAM& vram, unsigned x, unsigned y, bool extVRAM)
+{
+	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+		>> (((~x) & 3) << 1) ) & 3;
+}
+
+template<typename LogOp, typename VRAM>
+inline void Graphic5Mode::pset(
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
+	byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 3) << 1;
+	op(time, vram, addr, src, color << sh, ~(3 << sh));
+}
+
+inline byte Graphic5Mode::duplicate(byte color)
+{
+	assert((color & 0xFC) == 0);
+	color |= color << 2;
+	color |= color << 4;
+	return color;
+}
+
+/** Represents V9938 Graphic 6 mode (SCREEN7).
+  */
+struct Graphic6Mode
+{
+	//using IncrByteAddr  = IncrByteAddr6;
+	//using IncrPixelAddr = IncrPixelAddr6;
+	//using IncrMask      = IncrMask6;
+	//using IncrShift     = IncrShift6;
+	static const byte COLOR_MASK = 0x0F;
+	static const byte PIXELS_PER_BYTE = 2;
+	static const byte PIXELS_PER_BYTE_SHIFT = 1;
+	static const unsigned PIXELS_PER_LINE = 512;
+	static const bool PLANAR = true;
+	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
+	template<typename VRAM>
+	static inline byte point(VRAM& vram, unsigned x, unsigned y, bool extVRAM);
+	template<typename LogOp, typename VRAM>
+	static inline void pset(EmuTime::param time, VRAM& vram,
+		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte duplicate(byte color);
+};
+
+inline unsigned Graphic6Mode::addressOf(
+	unsigned x, unsigned y, bool extVRAM)
+{
+	return likely(!extVRAM)
+		? (((x & 2) << 15) | ((y & 511) << 7) | ((x & 511) >> 2))
+		: (0x20000         | ((y & 511) << 7) | ((x & 511) >> 2));
+}
+
+template<typename VRAM>
+inline byte Graphic6Mode::point(
+	VRAM& vram, unsigned x, unsigned y, bool extVRAM)
+{
+	return ( vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+		>> (((~x) & 1) << 2) ) & 15;
+}
+
+template<typename LogOp, typename VRAM>
+inline void Graphic6Mode::pset(
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
+	byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 1) << 2;
+	op(time, vram, addr, src, color << sh, ~(15 << sh));
+}
+
+inline byte Graphic6Mode::duplicate(byte color)
+{
+	assert((color & 0xF0) == 0);
+	return color | (color << 4);
+}
+
+/** Represents V9938 Graphic 7 mode (SCREEN8).
+  */
+struct Graphic7Mode
+{
+	//using IncrByteAddr  = IncrByteAddr7;
+	//using IncrPixelAddr = IncrPixelAddr7;
+	//using IncrMask      = IncrMask7;
+	//using IncrShift     = IncrShift7;
+	static const byte COLOR_MASK = 0xFF;
+	static const byte PIXELS_PER_BYTE = 1;
+	static const byte PIXELS_PER_BYTE_SHIFT = 0;
+	static const unsigned PIXELS_PER_LINE = 256;
+	static const bool PLANAR = true;
+	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
+	template<typename VRAM>
+	static inline byte point(VRAM& vram, unsigned x, unsigned y, bool extVRAM);
+	template<typename LogOp, typename VRAM>
+	static inline void pset(EmuTime::param time, VRAM& vram,
+		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte duplicate(byte color);
+};
+
+inline unsigned Graphic7Mode::addressOf(
+	unsigned x, unsigned y, bool extVRAM)
+{
+	return likely(!extVRAM)
+		? (((x & 1) << 16) | ((y & 511) << 7) | ((x & 255) >> 1))
+		: (0x20000         | ((y & 511) << 7) | ((x & 255) >> 1));
+}
+
+template<typename VRAM>
+inline byte Graphic7Mode::point(
+	VRAM& vram, unsigned x, unsigned y, bool extVRAM)
+{
+	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
+}
+
+template<typename LogOp, typename VRAM>
+inline void Graphic7Mode::pset(
+	EmuTime::param time, VRAM& vram, unsigned /*x*/, unsigned addr,
+	byte src, byte color, LogOp op)
+{
+	op(time, vram, addr, src, color, 0);
+}
+
+inline byte Graphic7Mode::duplicate(byte color)
+{
+	return color;
+}
+
+/** Represents V9958 non-bitmap command mode. This uses the Graphic7Mode
+  * coordinate system, but in non-planar mode.
+  */
+struct NonBitmapMode
+{
+	//using IncrByteAddr  = IncrByteAddrNonBitMap;
+	//using IncrPixelAddr = IncrPixelAddrNonBitMap;
+	//using IncrMask      = IncrMaskNonBitMap;
+	//using IncrShift     = IncrShiftNonBitMap;
+	static const byte COLOR_MASK = 0xFF;
+	static const byte PIXELS_PER_BYTE = 1;
+	static const byte PIXELS_PER_BYTE_SHIFT = 0;
+	static const unsigned PIXELS_PER_LINE = 256;
+	static const bool PLANAR = false;
+	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
+	template<typename VRAM>
+	static inline byte point(VRAM& vram, unsigned x, unsigned y, bool extVRAM);
+	template<typename LogOp, typename VRAM>
+	static inline void pset(EmuTime::param time, VRAM& vram,
+		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte duplicate(byte color);
+};
+
+inline unsigned NonBitmapMode::addressOf(
+	unsigned x, unsigned y, bool extVRAM)
+{
+	return likely(!extVRAM)
+		? (((y & 511) << 8) | (x & 255))
+		: (((y & 255) << 8) | (x & 255) | 0x20000);
+}
+
+template<typename VRAM>
+inline byte NonBitmapMode::point(
+	VRAM& vram, unsigned x, unsigned y, bool extVRAM)
+{
+	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
+}
+
+template<typename LogOp, typename VRAM>
+inline void NonBitmapMode::pset(
+	EmuTime::param time, VRAM& vram, unsigned /*x*/, unsigned addr,
+	byte src, byte color, LogOp op)
+{
+	op(time, vram, addr, src, color, 0);
+}
+
+inline byte NonBitmapMode::duplicate(byte color)
+{
+	return color;
+}
+
+
+// Logical operations:
+
+struct DummyOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param /*time*/, VRAM& /*vram*/, unsigned /*addr*/,
+	                byte /*src*/, byte /*color*/, byte /*mask*/) const
+	{
+		// Undefined logical operations do nothing.
+	}
+};
+
+struct ImpOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		vram.cmdWrite(addr, (src & mask) | color, time);
+	}
+};
+
+struct AndOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		vram.cmdWrite(addr, src & (color | mask), time);
+	}
+};
+
+struct OrOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte /*mask*/) const
+	{
+		vram.cmdWrite(addr, src | color, time);
+	}
+};
+
+struct XorOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte /*mask*/) const
+	{
+		vram.cmdWrite(addr, src ^ color, time);
+	}
+};
+
+struct NotOp {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
+	}
+};
+
+template<typename Op>
+struct TransparentOp : Op {
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		// TODO does this skip the write or re-write the original value
+		//      might make a difference in case the CPU has written
+		//      the same address inbetween the command read and write
+		if (color) Op::operator()(time, vram, addr, src, color, mask);
+	}
+};
+using TImpOp = TransparentOp<ImpOp>;
+using TAndOp = TransparentOp<AndOp>;
+using TOrOp  = TransparentOp<OrOp>;
+using TXorOp = TransparentOp<XorOp>;
+using TNotOp = TransparentOp<NotOp>;
+
+} // namespace openmsx
+
+#endif
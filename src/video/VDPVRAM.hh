@@ -297,6 +297,18 @@ public:
 		return (address & combiMask) == unsigned(baseAddr);
 	}
 
+	/** Might a change in the address range [begin, end] have to be
+	  * reported to the observer of this window? This test is conservative:
+	  * it only looks at the lowest and highest address inside this window,
+	  * so it can return true even when no address of the range is inside.
+	  */
+	inline bool mayNotify(unsigned begin, unsigned end) const {
+		if (!isEnabled() || !hasObserver()) return false;
+		unsigned first = baseAddr;
+		unsigned last  = baseAddr | ~combiMask;
+		return (begin <= last) && (first <= end);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
@@ -428,6 +440,33 @@ public:
 		writeCommon(address, value, time);
 	}
 
+	/** Can the command engine write to the address range [begin, end]
+	  * without anyone (renderer, sprite checker) having to be notified?
+	  * If so, the exact moment of those writes doesn't matter and they can
+	  * be done with cmdWriteUnobserved().
+	  */
+	inline bool isUnobserved(unsigned begin, unsigned end) const {
+		// no mirroring inside the range
+		if (end > sizeMask) return false;
+		return !bitmapVisibleWindow.mayNotify(begin, end) &&
+		       !spriteAttribTable  .mayNotify(begin, end) &&
+		       !spritePatternTable .mayNotify(begin, end);
+	}
+
+	/** Write a byte to VRAM through the command engine, without notifying
+	  * the observers. Only allowed for addresses for which isUnobserved()
+	  * returns true.
+	  * @param address The address to write.
+	  * @param value The value to write.
+	  */
+	inline void cmdWriteUnobserved(unsigned address, byte value) {
+		assert(isUnobserved(address, address));
+		// non-present ram chips (16kb vram)
+		if (likely(address < actualSize)) {
+			data[address] = value;
+		}
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
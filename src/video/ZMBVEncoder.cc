@@ -7,10 +7,14 @@
 #include "endian.hh"
 #include <algorithm>
 #include <iterator>
+#include <vector>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -145,6 +149,11 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp)
 	// Level 6 seems a good compromise between size/speed for THIS test.
 }
 
+ZMBVEncoder::~ZMBVEncoder()
+{
+	deflateEnd(&zstream);
+}
+
 void ZMBVEncoder::setupBuffers(unsigned bpp)
 {
 	switch (bpp) {
@@ -181,6 +190,7 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 	unsigned xblocks = width / BLOCK_WIDTH;
 	unsigned yblocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xblocks * yblocks);
+	blockVectors.resize(xblocks * yblocks);
 	for (unsigned y = 0; y < yblocks; ++y) {
 		for (unsigned x = 0; x < xblocks; ++x) {
 			blockOffsets[y * xblocks + x] =
@@ -198,11 +208,11 @@ unsigned ZMBVEncoder::neededSize()
 }
 
 template<class P>
-unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
+unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset) const
 {
 	int ret = 0;
-	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
-	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+	auto* pold = &(reinterpret_cast<const P*>(oldframe.data()))[offset + (vy * pitch) + vx];
+	auto* pnew = &(reinterpret_cast<const P*>(newframe.data()))[offset];
 	for (unsigned y = 0; y < BLOCK_HEIGHT; y += 4) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
 			if (pold[x] != pnew[x]) ++ret;
@@ -213,12 +223,11 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
 	return ret;
 }
 
+// Count the number of different pixels in a block.
 template<class P>
-unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
+static inline unsigned countDifferences(const P* pold, const P* pnew, unsigned pitch)
 {
-	int ret = 0;
-	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
-	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+	unsigned ret = 0;
 	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; ++x) {
 			if (pold[x] != pnew[x]) ++ret;
@@ -229,6 +238,62 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 	return ret;
 }
 
+#ifdef __SSE2__
+// Same as above, but compare 8 (16bpp) or 4 (32bpp) pixels at once. The
+// pcmpeq instructions return -1 for equal pixels, so subtracting the result
+// counts the equal pixels (per lane).
+static_assert(BLOCK_WIDTH == 16, "below assumes 16 pixel wide blocks");
+
+static inline unsigned countDifferences(
+	const uint16_t* pold, const uint16_t* pnew, unsigned pitch)
+{
+	__m128i equal = _mm_setzero_si128();
+	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
+		auto* o = reinterpret_cast<const __m128i*>(pold);
+		auto* n = reinterpret_cast<const __m128i*>(pnew);
+		equal = _mm_sub_epi16(equal, _mm_cmpeq_epi16(
+			_mm_loadu_si128(o + 0), _mm_loadu_si128(n + 0)));
+		equal = _mm_sub_epi16(equal, _mm_cmpeq_epi16(
+			_mm_loadu_si128(o + 1), _mm_loadu_si128(n + 1)));
+		pold += pitch;
+		pnew += pitch;
+	}
+	// horizontal sum of the 8 16-bit counters
+	__m128i s = _mm_madd_epi16(equal, _mm_set1_epi16(1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - _mm_cvtsi128_si32(s);
+}
+
+static inline unsigned countDifferences(
+	const uint32_t* pold, const uint32_t* pnew, unsigned pitch)
+{
+	__m128i equal = _mm_setzero_si128();
+	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
+		auto* o = reinterpret_cast<const __m128i*>(pold);
+		auto* n = reinterpret_cast<const __m128i*>(pnew);
+		for (unsigned x = 0; x < 4; ++x) {
+			equal = _mm_sub_epi32(equal, _mm_cmpeq_epi32(
+				_mm_loadu_si128(o + x), _mm_loadu_si128(n + x)));
+		}
+		pold += pitch;
+		pnew += pitch;
+	}
+	// horizontal sum of the 4 32-bit counters
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, 0x4E));
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, 0xB1));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - _mm_cvtsi128_si32(equal);
+}
+#endif
+
+template<class P>
+unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset) const
+{
+	auto* pold = &(reinterpret_cast<const P*>(oldframe.data()))[offset + (vy * pitch) + vx];
+	auto* pnew = &(reinterpret_cast<const P*>(newframe.data()))[offset];
+	return countDifferences(pold, pnew, pitch);
+}
+
 template<class P>
 void ZMBVEncoder::addXorBlock(
 	const PixelOperations<P>& pixelOps, int vx, int vy, unsigned offset, unsigned& workUsed)
@@ -261,9 +326,39 @@ void ZMBVEncoder::addXorFrame(const SDL_PixelFormat& pixelFormat, unsigned& work
 	// Align the following xor data on 4 byte boundary
 	workUsed = (workUsed + blockcount * 2 + 3) & ~3;
 
+	// The motion search is by far the most expensive part. Blocks can be
+	// searched independently, so do this in parallel, one task per row
+	// of blocks. (The search starts from the vector of the previous block
+	// in the same row, so the result doesn't depend on the number of
+	// threads).
+	std::vector<std::shared_future<void>> rows;
+	rows.reserve(yblocks);
+	for (unsigned y = 0; y < yblocks; ++y) {
+		unsigned first = y * xblocks;
+		rows.push_back(threadPool.addTask([this, first, xblocks] {
+			findMotionVectors<P>(first, first + xblocks);
+		}));
+	}
+	for (auto& r : rows) r.get();
+
+	// Writing the output must be done in order.
+	for (unsigned b = 0; b < blockcount; ++b) {
+		const auto& v = blockVectors[b];
+		vectors[b * 2 + 0] = (v.x << 1);
+		vectors[b * 2 + 1] = (v.y << 1);
+		if (v.change) {
+			vectors[b * 2 + 0] |= 1;
+			addXorBlock<P>(pixelOps, v.x, v.y, blockOffsets[b], workUsed);
+		}
+	}
+}
+
+template<class P>
+void ZMBVEncoder::findMotionVectors(unsigned firstBlock, unsigned lastBlock)
+{
 	int bestvx = 0;
 	int bestvy = 0;
-	for (unsigned b = 0; b < blockcount; ++b) {
+	for (unsigned b = firstBlock; b < lastBlock; ++b) {
 		unsigned offset = blockOffsets[b];
 		// first try best vector of previous block
 		unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
@@ -283,12 +378,7 @@ void ZMBVEncoder::addXorFrame(const SDL_PixelFormat& pixelFormat, unsigned& work
 				}
 			}
 		}
-		vectors[b * 2 + 0] = (bestvx << 1);
-		vectors[b * 2 + 1] = (bestvy << 1);
-		if (bestchange) {
-			vectors[b * 2 + 0] |= 1;
-			addXorBlock<P>(pixelOps, bestvx, bestvy, offset, workUsed);
-		}
+		blockVectors[b] = {bestvx, bestvy, bestchange};
 	}
 }
 
@@ -311,7 +401,8 @@ void ZMBVEncoder::addFullFrame(const SDL_PixelFormat& pixelFormat, unsigned& wor
 	}
 }
 
-const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* buf_)
+static const void* getScaledLine(FrameSource* frame, unsigned height,
+                                 unsigned pixelSize, unsigned y, void* buf_)
 {
 #if HAVE_32BPP
 	if (pixelSize == 4) { // 32bpp
@@ -347,7 +438,20 @@ const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* buf
 	return nullptr; // avoid warning
 }
 
-void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
+void ZMBVEncoder::copyFrame(FrameSource* frame, unsigned height,
+                            unsigned pixelSize, void* pixels)
+{
+	unsigned lineWidth = (height * 4 / 3) * pixelSize;
+	auto* dest = static_cast<uint8_t*>(pixels);
+	for (unsigned i = 0; i < height; ++i) {
+		auto* scaled = getScaledLine(frame, height, pixelSize, i, dest);
+		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		dest += lineWidth;
+	}
+}
+
+void ZMBVEncoder::compressFrame(bool keyFrame, const void* pixels,
+                                const SDL_PixelFormat& pixelFormat,
                                 void*& buffer, unsigned& written)
 {
 	std::swap(newframe, oldframe); // replace oldframe with newframe
@@ -375,12 +479,16 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 	// copy lines (to add black border)
 	unsigned linePitch = pitch * pixelSize;
 	unsigned lineWidth = width * pixelSize;
-	uint8_t* dest =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	unsigned start = pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch);
+	uint8_t* dest = &newframe[start];
+	// no pixels -> repeat the previous frame (now in oldframe)
+	const uint8_t* src = pixels ? static_cast<const uint8_t*>(pixels)
+	                            : &oldframe[start];
+	unsigned srcPitch = pixels ? lineWidth : linePitch;
 	for (unsigned i = 0; i < height; ++i) {
-		auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		memcpy(dest, src, lineWidth);
 		dest += linePitch;
+		src += srcPitch;
 	}
 
 	// Add the frame data.
@@ -389,12 +497,12 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -405,12 +513,12 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getSDLPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -4,6 +4,7 @@
 #define ZMBVENCODER_HH
 
 #include "MemBuffer.hh"
+#include "ThreadPool.hh"
 #include <cstdint>
 #include <zlib.h>
 
@@ -20,10 +21,38 @@ public:
 	static const char* CODEC_4CC;
 
 	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
+	~ZMBVEncoder();
 
-	void compressFrame(bool keyFrame, FrameSource* frame,
+	/** Compress one frame.
+	  * @param keyFrame Should this be a key frame?
+	  * @param pixels The frame data, 'width' x 'height' pixels without
+	  *               padding between the lines. Can be nullptr, this
+	  *               means the frame is identical to the previous one.
+	  * @param pixelFormat The format of the pixels.
+	  * @param buffer Output: points to the compressed data, remains valid
+	  *               till the next call to this method.
+	  * @param written Output: size of the compressed data.
+	  */
+	void compressFrame(bool keyFrame, const void* pixels,
+	                   const SDL_PixelFormat& pixelFormat,
 	                   void*& buffer, unsigned& written);
 
+	/** Copy (and scale) a frame to a buffer as expected by
+	  * compressFrame(): 'width' x 'height' pixels without padding.
+	  * This is the only part that needs access to the FrameSource, so
+	  * the (expensive) compression itself can be done later or in
+	  * another thread.
+	  * @param height Must be 240, 480 or 720 (width is 4/3 of that).
+	  * @param pixelSize Bytes per pixel, 2 or 4.
+	  */
+	static void copyFrame(FrameSource* frame, unsigned height,
+	                      unsigned pixelSize, void* pixels);
+	void copyFrame(FrameSource* frame, void* pixels) const {
+		copyFrame(frame, height, pixelSize, pixels);
+	}
+
+	unsigned getFrameSize() const { return width * height * pixelSize; }
+
 private:
 	enum Format {
 		ZMBV_FORMAT_16BPP = 6,
@@ -34,20 +63,27 @@ private:
 	unsigned neededSize();
 	template<class P> void addFullFrame(const SDL_PixelFormat& pixelFormat, unsigned& workUsed);
 	template<class P> void addXorFrame (const SDL_PixelFormat& pixelFormat, unsigned& workUsed);
-	template<class P> unsigned possibleBlock(int vx, int vy, unsigned offset);
-	template<class P> unsigned compareBlock(int vx, int vy, unsigned offset);
+	template<class P> void findMotionVectors(unsigned firstBlock, unsigned lastBlock);
+	template<class P> unsigned possibleBlock(int vx, int vy, unsigned offset) const;
+	template<class P> unsigned compareBlock(int vx, int vy, unsigned offset) const;
 	template<class P> void addXorBlock(
 		const PixelOperations<P>& pixelOps, int vx, int vy,
 		unsigned offset, unsigned& workUsed);
-	const void* getScaledLine(FrameSource* frame, unsigned y, void* workBuf);
 
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> oldframe;
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> newframe;
 	MemBuffer<uint8_t, SSE2_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<unsigned> blockOffsets;
+	struct BlockVector {
+		int x, y;
+		unsigned change; // number of different pixels
+	};
+	MemBuffer<BlockVector> blockVectors;
 	unsigned outputSize;
 
+	ThreadPool threadPool; // for the motion search
+
 	z_stream zstream;
 
 	const unsigned width;
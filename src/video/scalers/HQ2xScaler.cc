@@ -44,6 +44,9 @@ void HQ_1x1on2x2<Pixel>::operator()(
 	c5 = c6 = readPixel(in1[0]);
 	c8 = c9 = readPixel(in2[0]);
 
+	VLA(unsigned, edges, srcWidth);
+	calcEdgesHQ(in1, in2, srcWidth, edges, edgeOp);
+
 	unsigned pattern = 0;
 	if (edgeOp(c5, c8)) pattern |= 3 <<  6;
 	if (edgeOp(c5, c2)) pattern |= 3 <<  9;
@@ -66,10 +69,7 @@ void HQ_1x1on2x2<Pixel>::operator()(
 		//if (edgeOp(c5, c1)) pattern |= 1 <<  3; //     l: c2-c6 9,  t: c4-c8 0
 		//if (edgeOp(c4, c2)) pattern |= 1 <<  4; //     l: c5-c3 10, t: c5-c7 1
 		// non-overlapping pixels
-		if (edgeOp(c5, c8)) pattern |= 1 <<  5; // B
-		if (edgeOp(c5, c9)) pattern |= 1 <<  6; // BR
-		if (edgeOp(c6, c8)) pattern |= 1 <<  7; // BR
-		if (edgeOp(c5, c6)) pattern |= 1 <<  8; // R
+		pattern |= edges[x]; // B, BR, BR, R, see calcEdgesHQ()
 		// overlaps with top
 		//if (edgeOp(c2, c6)) pattern |= 1 <<  9; // R - t: c5-c9 6
 		//if (edgeOp(c5, c3)) pattern |= 1 << 10; // R - t: c6-c8 7
@@ -110,6 +110,9 @@ void HQ_1x1on1x2<Pixel>::operator()(
 	c5 = c6 = readPixel(in1[0]);
 	c8 = c9 = readPixel(in2[0]);
 
+	VLA(unsigned, edges, srcWidth);
+	calcEdgesHQ(in1, in2, srcWidth, edges, edgeOp);
+
 	unsigned pattern = 0;
 	if (edgeOp(c5, c8)) pattern |= 3 <<  6;
 	if (edgeOp(c5, c2)) pattern |= 3 <<  9;
@@ -132,10 +135,7 @@ void HQ_1x1on1x2<Pixel>::operator()(
 		//if (edgeOp(c5, c1)) pattern |= 1 <<  3; //     l: c2-c6 9,  t: c4-c8 0
 		//if (edgeOp(c4, c2)) pattern |= 1 <<  4; //     l: c5-c3 10, t: c5-c7 1
 		// non-overlapping pixels
-		if (edgeOp(c5, c8)) pattern |= 1 <<  5; // B
-		if (edgeOp(c5, c9)) pattern |= 1 <<  6; // BR
-		if (edgeOp(c6, c8)) pattern |= 1 <<  7; // BR
-		if (edgeOp(c5, c6)) pattern |= 1 <<  8; // R
+		pattern |= edges[x]; // B, BR, BR, R, see calcEdgesHQ()
 		// overlaps with top
 		//if (edgeOp(c2, c6)) pattern |= 1 <<  9; // R - t: c5-c9 6
 		//if (edgeOp(c5, c3)) pattern |= 1 << 10; // R - t: c6-c8 7
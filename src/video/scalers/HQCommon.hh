@@ -5,11 +5,15 @@
 #include "ScalerOutput.hh"
 #include "LineScalers.hh"
 #include "PixelOperations.hh"
+#include "HostCPU.hh"
 #include "vla.hh"
 #include "build-info.hh"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#if HAVE_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -74,6 +78,11 @@ public:
 
 		return false;
 	}
+
+	unsigned getShiftR() const { return shiftR; }
+	unsigned getShiftG() const { return shiftG; }
+	unsigned getShiftB() const { return shiftB; }
+
 private:
 	const unsigned shiftR;
 	const unsigned shiftG;
@@ -92,6 +101,114 @@ EdgeHQ createEdgeHQ(const PixelOperations<Pixel>& pixelOps)
 	}
 }
 
+#if HAVE_AVX2_DISPATCH
+// Same as EdgeHQ, but for 8 pairs of pixels (already passed through
+// readPixel()). Returns all ones for each pair that has an edge.
+AVX2_TARGET static inline __m256i edgeHQ_AVX2(
+	__m256i c1, __m256i c2, __m128i shiftR, __m128i shiftG, __m128i shiftB)
+{
+	__m256i ff = _mm256_set1_epi32(0xFF);
+	__m256i dr = _mm256_sub_epi32(
+		_mm256_and_si256(_mm256_srl_epi32(c1, shiftR), ff),
+		_mm256_and_si256(_mm256_srl_epi32(c2, shiftR), ff));
+	__m256i dg = _mm256_sub_epi32(
+		_mm256_and_si256(_mm256_srl_epi32(c1, shiftG), ff),
+		_mm256_and_si256(_mm256_srl_epi32(c2, shiftG), ff));
+	__m256i db = _mm256_sub_epi32(
+		_mm256_and_si256(_mm256_srl_epi32(c1, shiftB), ff),
+		_mm256_and_si256(_mm256_srl_epi32(c2, shiftB), ff));
+	__m256i dy = _mm256_add_epi32(_mm256_add_epi32(dr, dg), db);
+	__m256i du = _mm256_sub_epi32(dr, db);
+	__m256i dv = _mm256_sub_epi32(
+		_mm256_add_epi32(dg, _mm256_add_epi32(dg, dg)), dy);
+	return _mm256_or_si256(
+		_mm256_cmpgt_epi32(_mm256_abs_epi32(dy), _mm256_set1_epi32(0xC0)),
+		_mm256_or_si256(
+		    _mm256_cmpgt_epi32(_mm256_abs_epi32(du), _mm256_set1_epi32(0x1C)),
+		    _mm256_cmpgt_epi32(_mm256_abs_epi32(dv), _mm256_set1_epi32(0x30))));
+}
+
+AVX2_TARGET static inline __m256i loadPixelsHQ_AVX2(
+	const uint32_t* p, __m256i mask)
+{
+	return _mm256_and_si256(mask, _mm256_loadu_si256(
+		reinterpret_cast<const __m256i*>(p)));
+}
+
+// Handles groups of 8 pixels (but not the last pixel of the line), returns
+// the number of processed pixels. See calcEdgesHQ().
+AVX2_TARGET static inline unsigned calcEdgesHQ_AVX2(
+	const uint32_t* __restrict curr, const uint32_t* __restrict next,
+	unsigned srcWidth, unsigned* __restrict edges, const EdgeHQ& edgeOp)
+{
+	if (srcWidth == 0) return 0;
+	unsigned n = (srcWidth - 1) & ~7u;
+	__m128i shiftR = _mm_cvtsi32_si128(edgeOp.getShiftR());
+	__m128i shiftG = _mm_cvtsi32_si128(edgeOp.getShiftG());
+	__m128i shiftB = _mm_cvtsi32_si128(edgeOp.getShiftB());
+	__m256i mask = _mm256_set1_epi32(0xF8F8F8F8); // see readPixel()
+	for (unsigned x = 0; x < n; x += 8) {
+		__m256i c5 = loadPixelsHQ_AVX2(curr + x,     mask);
+		__m256i c6 = loadPixelsHQ_AVX2(curr + x + 1, mask);
+		__m256i c8 = loadPixelsHQ_AVX2(next + x,     mask);
+		__m256i c9 = loadPixelsHQ_AVX2(next + x + 1, mask);
+		__m256i e58 = edgeHQ_AVX2(c5, c8, shiftR, shiftG, shiftB);
+		__m256i e59 = edgeHQ_AVX2(c5, c9, shiftR, shiftG, shiftB);
+		__m256i e68 = edgeHQ_AVX2(c6, c8, shiftR, shiftG, shiftB);
+		__m256i e56 = edgeHQ_AVX2(c5, c6, shiftR, shiftG, shiftB);
+		__m256i pattern = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_and_si256(e58, _mm256_set1_epi32(1 << 5)),
+				_mm256_and_si256(e59, _mm256_set1_epi32(1 << 6))),
+			_mm256_or_si256(
+				_mm256_and_si256(e68, _mm256_set1_epi32(1 << 7)),
+				_mm256_and_si256(e56, _mm256_set1_epi32(1 << 8))));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(edges + x), pattern);
+	}
+	return n;
+}
+// 16bpp pixels need a conversion in readPixel(), not worth it
+static inline unsigned calcEdgesHQ_AVX2(
+	const uint16_t* /*curr*/, const uint16_t* /*next*/,
+	unsigned /*srcWidth*/, unsigned* /*edges*/, const EdgeHQ& /*edgeOp*/)
+{
+	return 0;
+}
+#endif
+
+/** Calculate the part of the HQ edge pattern that doesn't overlap with the
+  * previous pixel or the previous line (see HQ_1x1on2x2):
+  *   bit 5: c5-c8 (B), bit 6: c5-c9 (BR), bit 7: c6-c8 (BR), bit 8: c5-c6 (R)
+  * with c5 = curr[x], c6 = curr[x + 1], c8 = next[x], c9 = next[x + 1]. For
+  * the last pixel of the line c6 and c9 are the same as c5 and c8.
+  * Doing this for the whole line at once makes it possible to vectorize it.
+  */
+template <typename Pixel>
+static void calcEdgesHQ(
+	const Pixel* __restrict curr, const Pixel* __restrict next,
+	unsigned srcWidth, unsigned* __restrict edges, EdgeHQ edgeOp)
+{
+	unsigned x = 0;
+#if HAVE_AVX2_DISPATCH
+	if (HostCPU::hasAVX2()) {
+		x = calcEdgesHQ_AVX2(curr, next, srcWidth, edges, edgeOp);
+	}
+#endif
+	for (/* */; x < srcWidth; ++x) {
+		unsigned x1 = std::min(x + 1, srcWidth - 1);
+		uint32_t c5 = readPixel(curr[x]);
+		uint32_t c6 = readPixel(curr[x1]);
+		uint32_t c8 = readPixel(next[x]);
+		uint32_t c9 = readPixel(next[x1]);
+		unsigned pattern = 0;
+		if (edgeOp(c5, c8)) pattern |= 1 << 5; // B
+		if (edgeOp(c5, c9)) pattern |= 1 << 6; // BR
+		if (edgeOp(c6, c8)) pattern |= 1 << 7; // BR
+		if (edgeOp(c5, c6)) pattern |= 1 << 8; // R
+		edges[x] = pattern;
+	}
+}
+
 struct EdgeHQLite
 {
 	inline bool operator()(uint32_t c1, uint32_t c2) const
@@ -2,6 +2,7 @@
 #define LINESCALERS_HH
 
 #include "PixelOperations.hh"
+#include "HostCPU.hh"
 #include "likely.hh"
 #include <type_traits>
 #include <cstring>
@@ -12,6 +13,9 @@
 #ifdef __SSSE3__
 #include "tmmintrin.h"
 #endif
+#if HAVE_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -361,7 +365,7 @@ static inline void scale_1onN(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t width)
 {
 	unsigned i = 0, j = 0;
-	for (/* */; i < (width - (N - 1)); i += N, j += 1) {
+	for (/* */; (i + N) <= width; i += N, j += 1) {
 		Pixel pix = in[j];
 		for (unsigned k = 0; k < N; ++k) {
 			out[i + k] = pix;
@@ -372,9 +376,41 @@ static inline void scale_1onN(
 	}
 }
 
+#if HAVE_AVX2_DISPATCH
+// Handles complete groups of 8 input pixels, returns the number of
+// processed input pixels.
+AVX2_TARGET static inline size_t scale_1on3_AVX2(
+	const uint32_t* __restrict in, uint32_t* __restrict out, size_t srcWidth)
+{
+	__m256i idx0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+	__m256i idx1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+	__m256i idx2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+	size_t n = srcWidth & ~size_t(7);
+	for (size_t x = 0; x < n; x += 8) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x));
+		auto* o = reinterpret_cast<__m256i*>(out + 3 * x);
+		_mm256_storeu_si256(o + 0, _mm256_permutevar8x32_epi32(a, idx0));
+		_mm256_storeu_si256(o + 1, _mm256_permutevar8x32_epi32(a, idx1));
+		_mm256_storeu_si256(o + 2, _mm256_permutevar8x32_epi32(a, idx2));
+	}
+	return n;
+}
+#endif
+
 template <typename Pixel>
 void Scale_1on3<Pixel>::operator()(const Pixel* in, Pixel* out, size_t width)
 {
+#if HAVE_AVX2_DISPATCH
+	// only a 32bpp version, 16bpp uses the generic code below
+	if ((sizeof(Pixel) == 4) && HostCPU::hasAVX2()) {
+		size_t n = scale_1on3_AVX2(
+			reinterpret_cast<const uint32_t*>(in),
+			reinterpret_cast<uint32_t*>(out), width / 3);
+		in    +=     n;
+		out   += 3 * n;
+		width -= 3 * n;
+	}
+#endif
 	scale_1onN<Pixel, 3>(in, out, width);
 }
 
@@ -452,6 +488,35 @@ static inline void scale_1on2_SSE(const Pixel* in_, Pixel* out_, size_t srcWidth
 }
 #endif
 
+#if HAVE_AVX2_DISPATCH
+// Handles complete groups of 32 bytes of input, returns the number of
+// processed input pixels. Unlike scale_1on2_SSE() there are no alignment
+// requirements.
+template<typename Pixel>
+AVX2_TARGET static inline size_t scale_1on2_AVX2(
+	const Pixel* __restrict in, Pixel* __restrict out, size_t srcWidth)
+{
+	const size_t chunk = sizeof(__m256i) / sizeof(Pixel);
+	size_t n = srcWidth & ~(chunk - 1);
+	for (size_t x = 0; x < n; x += chunk) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x));
+		__m256i l, h;
+		if (sizeof(Pixel) == 4) {
+			l = _mm256_unpacklo_epi32(a, a);
+			h = _mm256_unpackhi_epi32(a, a);
+		} else {
+			l = _mm256_unpacklo_epi16(a, a);
+			h = _mm256_unpackhi_epi16(a, a);
+		}
+		// unpack works per 128-bit lane, put the lanes in the right order
+		auto* o = reinterpret_cast<__m256i*>(out + 2 * x);
+		_mm256_storeu_si256(o + 0, _mm256_permute2x128_si256(l, h, 0x20));
+		_mm256_storeu_si256(o + 1, _mm256_permute2x128_si256(l, h, 0x31));
+	}
+	return n;
+}
+#endif
+
 template <typename Pixel>
 void Scale_1on2<Pixel>::operator()(
 	const Pixel* __restrict in, Pixel* __restrict out, size_t dstWidth)
@@ -470,14 +535,24 @@ void Scale_1on2<Pixel>::operator()(
 	// the instrinsic version is no longer needed.
 	size_t srcWidth = dstWidth / 2;
 
+#if HAVE_AVX2_DISPATCH
+	if (HostCPU::hasAVX2()) {
+		size_t n = scale_1on2_AVX2(in, out, srcWidth);
+		in  +=     n;
+		out += 2 * n;
+		srcWidth -= n;
+	} else
+#endif
+	{
 #ifdef __SSE2__
-	size_t chunk = 4 * sizeof(__m128i) / sizeof(Pixel);
-	size_t srcWidth2 = srcWidth & ~(chunk - 1);
-	scale_1on2_SSE(in, out, srcWidth2);
-	in  +=      srcWidth2;
-	out +=  2 * srcWidth2;
-	srcWidth -= srcWidth2;
+		size_t chunk = 4 * sizeof(__m128i) / sizeof(Pixel);
+		size_t srcWidth2 = srcWidth & ~(chunk - 1);
+		scale_1on2_SSE(in, out, srcWidth2);
+		in  +=      srcWidth2;
+		out +=  2 * srcWidth2;
+		srcWidth -= srcWidth2;
 #endif
+	}
 
 	// C++ version. Used both on non-x86 machines and (possibly) on x86 for
 	// the last few pixels of the line.
@@ -1080,14 +1155,46 @@ BlendLines<Pixel, w1, w2>::BlendLines(PixelOperations<Pixel> pixelOps_)
 {
 }
 
+#if HAVE_AVX2_DISPATCH
+// Same as PixelOperations::avgDown() (so blend<1, 1>()) for complete
+// groups of 32 bytes, returns the number of processed pixels.
+template<typename Pixel>
+AVX2_TARGET static inline size_t blendLines_1on1_AVX2(
+	const Pixel* in1, const Pixel* in2, Pixel* out, size_t width,
+	Pixel blendMask)
+{
+	const size_t chunk = sizeof(__m256i) / sizeof(Pixel);
+	size_t n = width & ~(chunk - 1);
+	__m256i mask = (sizeof(Pixel) == 4) ? _mm256_set1_epi32(blendMask)
+	                                    : _mm256_set1_epi16(blendMask);
+	for (size_t x = 0; x < n; x += chunk) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + x));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + x));
+		__m256i c = _mm256_and_si256(a, b);
+		__m256i d = _mm256_and_si256(_mm256_xor_si256(a, b), mask);
+		__m256i r = (sizeof(Pixel) == 4)
+		          ? _mm256_add_epi32(c, _mm256_srli_epi32(d, 1))
+		          : _mm256_add_epi16(c, _mm256_srli_epi16(d, 1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), r);
+	}
+	return n;
+}
+#endif
+
 template <typename Pixel, unsigned w1, unsigned w2>
 void BlendLines<Pixel, w1, w2>::operator()(
 	const Pixel* in1, const Pixel* in2, Pixel* out, unsigned width)
 {
 	// It _IS_ allowed that the output is the same as one of the inputs.
-	// TODO SSE optimizations
+	unsigned i = 0;
+#if HAVE_AVX2_DISPATCH
+	if ((w1 == w2) && (w1 != 0) && HostCPU::hasAVX2()) {
+		i = unsigned(blendLines_1on1_AVX2(
+			in1, in2, out, width, Pixel(pixelOps.getBlendMask())));
+	}
+#endif
 	// pure C++ version
-	for (unsigned i = 0; i < width; ++i) {
+	for (/* */; i < width; ++i) {
 		out[i] = pixelOps.template blend<w1, w2>(in1[i], in2[i]);
 	}
 }
@@ -670,6 +670,14 @@ void MLAAScaler<Pixel>::scaleImage(
 	}
 }
 
+template <class Pixel>
+bool MLAAScaler<Pixel>::isLocal() const
+{
+	// The slopes found by this algorithm can be as long as the whole
+	// image.
+	return false;
+}
+
 // Force template instantiation.
 #if HAVE_16BPP
 template class MLAAScaler<uint16_t>;
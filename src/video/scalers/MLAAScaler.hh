@@ -24,6 +24,7 @@ public:
 	void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
+	bool isLocal() const override;
 
 private:
 	const PixelOperations<Pixel> pixelOps;
@@ -23,6 +23,8 @@ protected:
 	void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) override;
+	// reads settings (not thread-safe) while scaling
+	bool canScaleInBands() const override { return false; }
 
 	void scaleBlank1to3(
 		FrameSource& src, unsigned srcStartY, unsigned srcEndY,
@@ -30,6 +30,19 @@ public:
 	virtual void scaleImage(FrameSource& src, const RawFrame* superImpose,
 		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
 		ScalerOutput<Pixel>& dst, unsigned dstStartY, unsigned dstEndY) = 0;
+
+	/** Does each output line only depend on the nearby source lines (at
+	  * most 2 lines above or below)? When not (e.g. MLAA), the output of a
+	  * line can depend on the whole image. Then the image is always scaled
+	  * as a whole: not in bands and not only the changed lines.
+	  */
+	virtual bool isLocal() const { return true; }
+
+	/** Is it allowed to split an image in bands and to scale those at
+	  * the same time (each band with its own instance of this scaler) from
+	  * different threads?
+	  */
+	virtual bool canScaleInBands() const { return true; }
 };
 
 } // namespace openmsx
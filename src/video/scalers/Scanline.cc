@@ -1,5 +1,6 @@
 #include "Scanline.hh"
 #include "PixelOperations.hh"
+#include "HostCPU.hh"
 #include "unreachable.hh"
 #include <cassert>
 #include <cstddef>
@@ -7,6 +8,9 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#if HAVE_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -187,6 +191,61 @@ static inline void drawSSE2(
 #endif
 
 
+#if HAVE_AVX2_DISPATCH
+
+// 32bpp, same as drawSSE2() but 32 bytes at a time
+AVX2_TARGET static void drawAVX2_32(
+	const uint32_t* __restrict in1_,
+	const uint32_t* __restrict in2_,
+	      uint32_t* __restrict out_,
+	unsigned factor,
+	size_t width)
+{
+	width *= sizeof(uint32_t); // in bytes
+	assert(width >= 64);
+	assert((width % 64) == 0);
+	auto* in1 = reinterpret_cast<const char*>(in1_) + width;
+	auto* in2 = reinterpret_cast<const char*>(in2_) + width;
+	auto* out = reinterpret_cast<      char*>(out_) + width;
+
+	__m256i zero = _mm256_setzero_si256();
+	__m256i f = _mm256_set1_epi16(factor << 8);
+	ptrdiff_t x = -ptrdiff_t(width);
+	do {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in1 + x));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in2 + x));
+		__m256i c = _mm256_avg_epu8(a, b);
+		// unpack and pack both work per 128-bit lane, so the pixels
+		// end up in the original order
+		__m256i l = _mm256_unpacklo_epi8(c, zero);
+		__m256i h = _mm256_unpackhi_epi8(c, zero);
+		__m256i m = _mm256_mulhi_epu16(l, f);
+		__m256i n = _mm256_mulhi_epu16(h, f);
+		__m256i r = _mm256_packus_epi16(m, n);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), r);
+		x += 32;
+	} while (x < 0);
+}
+
+static inline bool drawAVX2(
+	const uint32_t* in1, const uint32_t* in2, uint32_t* out,
+	unsigned factor, size_t width)
+{
+	drawAVX2_32(in1, in2, out, factor, width);
+	return true;
+}
+
+// 16bpp, the table lookups don't benefit from AVX2
+static inline bool drawAVX2(
+	const uint16_t* /*in1*/, const uint16_t* /*in2*/, uint16_t* /*out*/,
+	unsigned /*factor*/, size_t /*width*/)
+{
+	return false;
+}
+
+#endif
+
+
 // class Scanline
 
 template <class Pixel>
@@ -201,6 +260,11 @@ void Scanline<Pixel>::draw(
 	const Pixel* __restrict src1, const Pixel* __restrict src2,
 	Pixel* __restrict dst, unsigned factor, size_t width)
 {
+#if HAVE_AVX2_DISPATCH
+	if (HostCPU::hasAVX2() && drawAVX2(src1, src2, dst, factor, width)) {
+		return;
+	}
+#endif
 #ifdef __SSE2__
 	drawSSE2(src1, src2, dst, factor, width, pixelOps, darkener);
 #else